@@ -0,0 +1,539 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de las utilidades del árbol.
+ * */
+#include "astutil.hpp"
+
+#include <climits>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "parser.hpp"
+
+void forEachExpression(ExpressionNode* expr,
+                       const std::function<void(ExpressionNode*)>& fn) {
+  if (!expr) return;
+  fn(expr);
+  if (auto call = dynamic_cast<CallNode*>(expr)) {
+    for (auto& arg : call->argsList) forEachExpression(arg.get(), fn);
+  } else if (auto fac = dynamic_cast<FactorNode*>(expr)) {
+    forEachExpression(fac->expression.get(), fn);
+    if (fac->var) forEachExpression(fac->var->expression.get(), fn);
+    forEachExpression(fac->call.get(), fn);
+  } else if (auto term = dynamic_cast<TermNode*>(expr)) {
+    forEachExpression(term->leftFactor.get(), fn);
+    forEachExpression(term->rightFactor.get(), fn);
+  } else if (auto add = dynamic_cast<AdditiveExpressionNode*>(expr)) {
+    forEachExpression(add->leftTerm.get(), fn);
+    forEachExpression(add->rightTerm.get(), fn);
+  } else if (auto simple = dynamic_cast<SimpleExpressionNode*>(expr)) {
+    forEachExpression(simple->additiveLeft.get(), fn);
+    forEachExpression(simple->additiveRight.get(), fn);
+  } else if (auto assign = dynamic_cast<AssignmentExpressionNode*>(expr)) {
+    forEachExpression(assign->var->expression.get(), fn);
+    forEachExpression(assign->simpleExpression.get(), fn);
+  }
+}
+
+void forEachStatement(StatementNode* stmt,
+                      const std::function<void(StatementNode*)>& fn) {
+  if (!stmt) return;
+  fn(stmt);
+  if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+    for (auto& child : comp->statements) forEachStatement(child.get(), fn);
+  } else if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+    forEachStatement(sel->statement.get(), fn);
+    forEachStatement(sel->elseStatement.get(), fn);
+  } else if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+    forEachStatement(iter->statement.get(), fn);
+  }
+}
+
+void forEachExpression(StatementNode* stmt,
+                       const std::function<void(ExpressionNode*)>& fn) {
+  forEachStatement(stmt, [&](StatementNode* s) {
+    if (auto expr = dynamic_cast<ExpressionStatementNode*>(s)) {
+      forEachExpression(expr->expression.get(), fn);
+    } else if (auto sel = dynamic_cast<SelectionStatementNode*>(s)) {
+      forEachExpression(sel->condition.get(), fn);
+    } else if (auto iter = dynamic_cast<IterationStatementNode*>(s)) {
+      forEachExpression(iter->expression.get(), fn);
+    } else if (auto ret = dynamic_cast<ReturnStatementNode*>(s)) {
+      forEachExpression(ret->expression.get(), fn);
+    }
+  });
+}
+
+VarNode* bareVar(FactorNode* factor) {
+  if (!factor || !factor->var || factor->var->expression) return nullptr;
+  return factor->var.get();
+}
+
+bool isLiteral(FactorNode* factor) {
+  return factor && !factor->expression && !factor->var && !factor->call;
+}
+
+FactorNode* asFactor(ExpressionNode* expr) {
+  if (auto simple = dynamic_cast<SimpleExpressionNode*>(expr)) {
+    if (simple->additiveRight) return nullptr;
+    return asFactor(simple->additiveLeft.get());
+  } else if (auto add = dynamic_cast<AdditiveExpressionNode*>(expr)) {
+    if (add->rightTerm) return nullptr;
+    return asFactor(add->leftTerm.get());
+  } else if (auto term = dynamic_cast<TermNode*>(expr)) {
+    if (term->rightFactor) return nullptr;
+    return asFactor(term->leftFactor.get());
+  }
+  return dynamic_cast<FactorNode*>(expr);
+}
+
+CallNode* asCall(ExpressionNode* expr) {
+  FactorNode* factor = asFactor(expr);
+  if (!factor) return dynamic_cast<CallNode*>(expr);
+  if (factor->expression) return asCall(factor->expression.get());
+  return factor->call.get();
+}
+
+SimpleExpressionNode* asComparison(ExpressionNode* expr) {
+  auto simple = dynamic_cast<SimpleExpressionNode*>(expr);
+  if (simple && simple->additiveRight) return simple;
+  FactorNode* factor = asFactor(expr);
+  if (factor && factor->expression) return asComparison(factor->expression.get());
+  return nullptr;
+}
+
+TokenType negateRelop(TokenType relop) {
+  switch (relop) {
+    case TokenType::LT:
+      return TokenType::GTE;
+    case TokenType::LTE:
+      return TokenType::GT;
+    case TokenType::GT:
+      return TokenType::LTE;
+    case TokenType::GTE:
+      return TokenType::LT;
+    case TokenType::EQ:
+      return TokenType::NOT_EQ;
+    default:
+      return TokenType::EQ;
+  }
+}
+
+bool matchInductionUpdate(ExpressionStatementNode* stmt, std::string& var,
+                          int& step) {
+  auto assign = dynamic_cast<AssignmentExpressionNode*>(stmt->expression.get());
+  if (!assign || assign->var->expression) return false;
+  auto simple =
+      dynamic_cast<SimpleExpressionNode*>(assign->simpleExpression.get());
+  if (!simple || simple->additiveRight) return false;
+  auto add = simple->additiveLeft.get();
+  if (!add->rightTerm || add->rightTerm->rightTerm) return false;
+  TermNode* left = add->leftTerm.get();
+  TermNode* right = add->rightTerm->leftTerm.get();
+  if (left->rightFactor || right->rightFactor) return false;
+
+  VarNode* leftVar = bareVar(left->leftFactor.get());
+  VarNode* rightVar = bareVar(right->leftFactor.get());
+  var = assign->var->id;
+  if (leftVar && leftVar->id == var && isLiteral(right->leftFactor.get())) {
+    step = right->leftFactor->value;
+    if (add->addop == TokenType::SUB) step = -step;
+    return true;
+  }
+  if (rightVar && rightVar->id == var && add->addop == TokenType::ADD &&
+      isLiteral(left->leftFactor.get())) {
+    step = left->leftFactor->value;
+    return true;
+  }
+  return false;
+}
+
+std::set<std::string> singleScalars(FunDeclarationNode* fun) {
+  std::map<std::string, int> declared;
+  std::set<std::string> arrays;
+  for (auto& param : fun->params) {
+    declared[param->id]++;
+    if (param->isArray) arrays.insert(param->id);
+  }
+  forEachStatement(fun->compoundStatement.get(), [&](StatementNode* s) {
+    if (auto comp = dynamic_cast<CompoundStatementNode*>(s)) {
+      for (auto& var : comp->vars) {
+        declared[var->id]++;
+        if (var->arraySize) arrays.insert(var->id);
+      }
+    }
+  });
+  std::set<std::string> scalars;
+  for (auto& [id, count] : declared) {
+    if (count == 1 && !arrays.count(id)) scalars.insert(id);
+  }
+  return scalars;
+}
+
+// Cada clase de nodo se copia con su propio tipo para poder colgarla de los
+// punteros tipados de su padre.
+static std::unique_ptr<FactorNode> cloneFactor(FactorNode* factor);
+
+static std::unique_ptr<VarNode> cloneVar(VarNode* var) {
+  auto copy = std::make_unique<VarNode>(var->id, var->getLineno(),
+                                        var->getPosition());
+  if (var->expression) {
+    copy->expression = cloneExpression(var->expression.get());
+  }
+  return copy;
+}
+
+static std::unique_ptr<CallNode> cloneCall(CallNode* call) {
+  auto copy = std::make_unique<CallNode>(call->id, call->getLineno(),
+                                         call->getPosition());
+  copy->expressionType = call->expressionType;
+  for (auto& arg : call->argsList) {
+    copy->argsList.push_back(cloneExpression(arg.get()));
+  }
+  return copy;
+}
+
+static std::unique_ptr<TermNode> cloneTerm(TermNode* term) {
+  if (!term) return nullptr;
+  auto copy =
+      std::make_unique<TermNode>(term->getLineno(), term->getPosition());
+  copy->expressionType = term->expressionType;
+  copy->leftFactor = cloneFactor(term->leftFactor.get());
+  copy->mulop = term->mulop;
+  copy->rightFactor = cloneTerm(term->rightFactor.get());
+  return copy;
+}
+
+static std::unique_ptr<AdditiveExpressionNode> cloneAdditive(
+    AdditiveExpressionNode* add) {
+  if (!add) return nullptr;
+  auto copy = std::make_unique<AdditiveExpressionNode>(add->getLineno(),
+                                                       add->getPosition());
+  copy->expressionType = add->expressionType;
+  copy->leftTerm = cloneTerm(add->leftTerm.get());
+  copy->addop = add->addop;
+  copy->rightTerm = cloneAdditive(add->rightTerm.get());
+  return copy;
+}
+
+static std::unique_ptr<FactorNode> cloneFactor(FactorNode* factor) {
+  if (!factor) return nullptr;
+  auto copy =
+      std::make_unique<FactorNode>(factor->getLineno(), factor->getPosition());
+  copy->expressionType = factor->expressionType;
+  copy->value = factor->value;
+  if (factor->expression) {
+    copy->expression = cloneExpression(factor->expression.get());
+  }
+  if (factor->var) copy->var = cloneVar(factor->var.get());
+  if (factor->call) copy->call = cloneCall(factor->call.get());
+  return copy;
+}
+
+std::unique_ptr<ExpressionNode> cloneExpression(ExpressionNode* expr) {
+  if (!expr) return nullptr;
+  if (auto call = dynamic_cast<CallNode*>(expr)) return cloneCall(call);
+  if (auto factor = dynamic_cast<FactorNode*>(expr)) {
+    return cloneFactor(factor);
+  }
+  if (auto term = dynamic_cast<TermNode*>(expr)) return cloneTerm(term);
+  if (auto add = dynamic_cast<AdditiveExpressionNode*>(expr)) {
+    return cloneAdditive(add);
+  }
+  if (auto simple = dynamic_cast<SimpleExpressionNode*>(expr)) {
+    auto copy = std::make_unique<SimpleExpressionNode>(simple->getLineno(),
+                                                       simple->getPosition());
+    copy->expressionType = simple->expressionType;
+    copy->additiveLeft = cloneAdditive(simple->additiveLeft.get());
+    copy->relop = simple->relop;
+    copy->additiveRight = cloneAdditive(simple->additiveRight.get());
+    return copy;
+  }
+  auto assign = static_cast<AssignmentExpressionNode*>(expr);
+  auto copy = std::make_unique<AssignmentExpressionNode>(assign->getLineno(),
+                                                         assign->getPosition());
+  copy->expressionType = assign->expressionType;
+  copy->var = cloneVar(assign->var.get());
+  copy->simpleExpression = cloneExpression(assign->simpleExpression.get());
+  return copy;
+}
+
+std::unique_ptr<StatementNode> cloneStatement(StatementNode* stmt) {
+  if (!stmt) return nullptr;
+  int line = stmt->getLineno(), pos = stmt->getPosition();
+  if (auto expr = dynamic_cast<ExpressionStatementNode*>(stmt)) {
+    auto copy = std::make_unique<ExpressionStatementNode>(line, pos);
+    copy->expression = cloneExpression(expr->expression.get());
+    return copy;
+  }
+  if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+    auto copy = std::make_unique<IterationStatementNode>(line, pos);
+    copy->expression = cloneExpression(iter->expression.get());
+    copy->statement = cloneStatement(iter->statement.get());
+    return copy;
+  }
+  if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+    auto copy = std::make_unique<SelectionStatementNode>(line, pos);
+    copy->condition = cloneExpression(sel->condition.get());
+    copy->statement = cloneStatement(sel->statement.get());
+    copy->elseStatement = cloneStatement(sel->elseStatement.get());
+    return copy;
+  }
+  if (auto ret = dynamic_cast<ReturnStatementNode*>(stmt)) {
+    auto copy = std::make_unique<ReturnStatementNode>(line, pos);
+    copy->expression = cloneExpression(ret->expression.get());
+    return copy;
+  }
+  auto comp = static_cast<CompoundStatementNode*>(stmt);
+  auto copy = std::make_unique<CompoundStatementNode>(line, pos);
+  for (auto& var : comp->vars) {
+    auto decl = std::make_unique<VarDeclarationNode>(
+        var->type, var->id, var->getLineno(), var->getPosition());
+    decl->arraySize = var->arraySize;
+    copy->vars.push_back(std::move(decl));
+  }
+  for (auto& child : comp->statements) {
+    copy->statements.push_back(cloneStatement(child.get()));
+  }
+  return copy;
+}
+
+std::unique_ptr<FactorNode> makeVarFactor(const std::string& id,
+                                          ExpressionNode* origin) {
+  int line = origin->getLineno(), pos = origin->getPosition();
+  auto factor = std::make_unique<FactorNode>(line, pos);
+  factor->var = std::make_unique<VarNode>(id, line, pos);
+  factor->expressionType = ExpressionType::Integer;
+  return factor;
+}
+
+std::unique_ptr<FactorNode> makeNumberFactor(int value,
+                                             ExpressionNode* origin) {
+  auto factor =
+      std::make_unique<FactorNode>(origin->getLineno(), origin->getPosition());
+  factor->value = value;
+  factor->expressionType = ExpressionType::Integer;
+  return factor;
+}
+
+std::unique_ptr<SimpleExpressionNode> makeExpression(
+    std::unique_ptr<FactorNode> left, TokenType op,
+    std::unique_ptr<FactorNode> right) {
+  int line = left->getLineno(), pos = left->getPosition();
+  auto term = std::make_unique<TermNode>(line, pos);
+  auto additive = std::make_unique<AdditiveExpressionNode>(line, pos);
+  term->leftFactor = std::move(left);
+
+  if (op == TokenType::TIMES || op == TokenType::DIV) {
+    term->mulop = op;
+    term->rightFactor = std::make_unique<TermNode>(line, pos);
+    term->rightFactor->leftFactor = std::move(right);
+    additive->leftTerm = std::move(term);
+  } else {
+    additive->leftTerm = std::move(term);
+    additive->addop = op;
+    additive->rightTerm = std::make_unique<AdditiveExpressionNode>(line, pos);
+    additive->rightTerm->leftTerm = std::make_unique<TermNode>(line, pos);
+    additive->rightTerm->leftTerm->leftFactor = std::move(right);
+  }
+
+  auto simple = std::make_unique<SimpleExpressionNode>(line, pos);
+  simple->additiveLeft = std::move(additive);
+  simple->expressionType = ExpressionType::Integer;
+  return simple;
+}
+
+std::unique_ptr<ExpressionStatementNode> makeAssignment(
+    const std::string& id, std::unique_ptr<ExpressionNode> value) {
+  int line = value->getLineno(), pos = value->getPosition();
+  auto assign = std::make_unique<AssignmentExpressionNode>(line, pos);
+  assign->var = std::make_unique<VarNode>(id, line, pos);
+  assign->simpleExpression = std::move(value);
+  assign->expressionType = ExpressionType::Integer;
+
+  auto stmt = std::make_unique<ExpressionStatementNode>(line, pos);
+  stmt->expression = std::move(assign);
+  return stmt;
+}
+
+std::unique_ptr<VarDeclarationNode> makeLocal(const std::string& id,
+                                              ExpressionNode* origin) {
+  return std::make_unique<VarDeclarationNode>(
+      "int", id, origin->getLineno(), origin->getPosition());
+}
+
+// Las sumas y productos dan la vuelta igual que en MIPS.
+static int wrap(long long value) { return (int)(unsigned)value; }
+
+bool constantValue(ExpressionNode* expr, int& value) {
+  if (auto factor = dynamic_cast<FactorNode*>(expr)) {
+    if (factor->expression) {
+      return constantValue(factor->expression.get(), value);
+    }
+    if (!isLiteral(factor)) return false;
+    value = factor->value;
+    return true;
+  }
+  // Las cadenas se evalúan de izquierda a derecha, como en el código.
+  if (auto term = dynamic_cast<TermNode*>(expr)) {
+    int acc, right;
+    if (!constantValue(term->leftFactor.get(), acc)) return false;
+    for (TermNode* t = term; t->rightFactor; t = t->rightFactor.get()) {
+      if (!constantValue(t->rightFactor->leftFactor.get(), right)) {
+        return false;
+      }
+      if (t->mulop == TokenType::DIV) {
+        if (right == 0 || (acc == INT_MIN && right == -1)) return false;
+        acc /= right;
+      } else {
+        acc = wrap((long long)acc * right);
+      }
+    }
+    value = acc;
+    return true;
+  }
+  if (auto add = dynamic_cast<AdditiveExpressionNode*>(expr)) {
+    int acc, right;
+    if (!constantValue(add->leftTerm.get(), acc)) return false;
+    for (auto a = add; a->rightTerm; a = a->rightTerm.get()) {
+      if (!constantValue(a->rightTerm->leftTerm.get(), right)) return false;
+      acc = wrap(a->addop == TokenType::SUB ? (long long)acc - right
+                                            : (long long)acc + right);
+    }
+    value = acc;
+    return true;
+  }
+  if (auto simple = dynamic_cast<SimpleExpressionNode*>(expr)) {
+    int left, right;
+    if (!constantValue(simple->additiveLeft.get(), left)) return false;
+    if (!simple->additiveRight) {
+      value = left;
+      return true;
+    }
+    if (!constantValue(simple->additiveRight.get(), right)) return false;
+    switch (simple->relop) {
+      case TokenType::LT:
+        value = left < right;
+        break;
+      case TokenType::LTE:
+        value = left <= right;
+        break;
+      case TokenType::GT:
+        value = left > right;
+        break;
+      case TokenType::GTE:
+        value = left >= right;
+        break;
+      case TokenType::EQ:
+        value = left == right;
+        break;
+      default:
+        value = left != right;
+        break;
+    }
+    return true;
+  }
+  // Asignaciones y llamadas.
+  return false;
+}
+
+static std::unique_ptr<TermNode> makeNumberTerm(int value,
+                                                ExpressionNode* origin) {
+  auto term =
+      std::make_unique<TermNode>(origin->getLineno(), origin->getPosition());
+  term->leftFactor = makeNumberFactor(value, origin);
+  return term;
+}
+
+// Los eslabones de en medio de una cadena no son subexpresiones: en a - b + c
+// no se puede juntar b + c.
+static int foldExpression(ExpressionNode* root) {
+  std::set<ExpressionNode*> chained;
+  forEachExpression(root, [&](ExpressionNode* expr) {
+    if (auto term = dynamic_cast<TermNode*>(expr)) {
+      if (term->rightFactor) chained.insert(term->rightFactor.get());
+    } else if (auto add = dynamic_cast<AdditiveExpressionNode*>(expr)) {
+      if (add->rightTerm) chained.insert(add->rightTerm.get());
+    }
+  });
+
+  int folded = 0;
+  forEachExpression(root, [&](ExpressionNode* expr) {
+    int value;
+    if (chained.count(expr)) return;
+    if (auto factor = dynamic_cast<FactorNode*>(expr)) {
+      if (factor->expression &&
+          constantValue(factor->expression.get(), value)) {
+        factor->expression.reset();
+        factor->value = value;
+        folded++;
+      }
+    } else if (auto term = dynamic_cast<TermNode*>(expr)) {
+      if (term->rightFactor && constantValue(term, value)) {
+        term->leftFactor = makeNumberFactor(value, term);
+        term->rightFactor.reset();
+        folded++;
+      }
+    } else if (auto add = dynamic_cast<AdditiveExpressionNode*>(expr)) {
+      if (add->rightTerm && constantValue(add, value)) {
+        add->leftTerm = makeNumberTerm(value, add);
+        add->rightTerm.reset();
+        folded++;
+      }
+    } else if (auto simple = dynamic_cast<SimpleExpressionNode*>(expr)) {
+      if (simple->additiveRight && constantValue(simple, value)) {
+        auto add = std::make_unique<AdditiveExpressionNode>(
+            simple->getLineno(), simple->getPosition());
+        add->leftTerm = makeNumberTerm(value, simple);
+        simple->additiveLeft = std::move(add);
+        simple->additiveRight.reset();
+        folded++;
+      }
+    }
+  });
+  return folded;
+}
+
+static int foldStatement(std::unique_ptr<StatementNode>& slot) {
+  StatementNode* stmt = slot.get();
+  int folded = 0, value;
+  if (auto expr = dynamic_cast<ExpressionStatementNode*>(stmt)) {
+    folded += foldExpression(expr->expression.get());
+  } else if (auto ret = dynamic_cast<ReturnStatementNode*>(stmt)) {
+    folded += foldExpression(ret->expression.get());
+  } else if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+    for (auto& child : comp->statements) folded += foldStatement(child);
+  } else if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+    folded += foldExpression(sel->condition.get());
+    folded += foldStatement(sel->statement);
+    folded += foldStatement(sel->elseStatement);
+    if (constantValue(sel->condition.get(), value)) {
+      // Se queda solo la rama que se toma.
+      auto taken = std::move(value ? sel->statement : sel->elseStatement);
+      if (!taken) {
+        taken = std::make_unique<CompoundStatementNode>(stmt->getLineno(),
+                                                        stmt->getPosition());
+      }
+      slot = std::move(taken);
+      folded++;
+    }
+  } else if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+    folded += foldExpression(iter->expression.get());
+    folded += foldStatement(iter->statement);
+    if (constantValue(iter->expression.get(), value) && value == 0) {
+      slot = std::make_unique<CompoundStatementNode>(stmt->getLineno(),
+                                                     stmt->getPosition());
+      folded++;
+    }
+  }
+  return folded;
+}
+
+int foldConstants(CompoundStatementNode* body) {
+  int folded = 0;
+  for (auto& stmt : body->statements) folded += foldStatement(stmt);
+  return folded;
+}
@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de las utilidades para recorrer y construir nodos
+ *  del árbol que usan las optimizaciones.
+ * */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "parser.hpp"
+
+// Recorren en preorden todas las expresiones (incluyendo subíndices y
+// argumentos) o todos los statements que cuelgan de un nodo.
+void forEachExpression(ExpressionNode* expr,
+                       const std::function<void(ExpressionNode*)>& fn);
+void forEachExpression(StatementNode* stmt,
+                       const std::function<void(ExpressionNode*)>& fn);
+void forEachStatement(StatementNode* stmt,
+                      const std::function<void(StatementNode*)>& fn);
+
+// Si el factor es una variable escalar (sin subíndice) regresa su nodo.
+VarNode* bareVar(FactorNode* factor);
+// Un factor sin expresión, variable ni llamada es una constante.
+bool isLiteral(FactorNode* factor);
+// Si la expresión no tiene operadores regresa su único factor (que puede ser
+// una expresión entre paréntesis).
+FactorNode* asFactor(ExpressionNode* expr);
+// Si toda la expresión es una sola llamada (sin operadores) regresa su nodo.
+CallNode* asCall(ExpressionNode* expr);
+// Si la expresión es una comparación, aunque esté entre paréntesis, regresa
+// su nodo.
+SimpleExpressionNode* asComparison(ExpressionNode* expr);
+// La comparación contraria: a < b se vuelve a >= b.
+TokenType negateRelop(TokenType relop);
+
+// Si el statement es `v = v + c`, `v = c + v` o `v = v - c` regresa v y c.
+bool matchInductionUpdate(ExpressionStatementNode* stmt, std::string& var,
+                          int& step);
+// Los escalares locales o parámetros de la función declarados una sola vez:
+// ninguna llamada los puede modificar y ningún bloque interno los esconde.
+std::set<std::string> singleScalars(FunDeclarationNode* fun);
+
+// Si la expresión solo tiene constantes regresa su valor, con la aritmética
+// de 32 bits de MIPS. Las divisiones entre cero se dejan para tiempo de
+// ejecución.
+bool constantValue(ExpressionNode* expr, int& value);
+// Reemplaza cada subexpresión constante por su valor y quita los if y while
+// cuya condición se conoce. Regresa cuántas simplificaciones hizo.
+int foldConstants(CompoundStatementNode* body);
+
+// Copias profundas de un subárbol. Las copias conservan línea, posición y
+// tipos del original.
+std::unique_ptr<ExpressionNode> cloneExpression(ExpressionNode* expr);
+std::unique_ptr<StatementNode> cloneStatement(StatementNode* stmt);
+
+// Constructores de nodos. Todos usan la línea y posición de `origin` para que
+// los errores sigan apuntando al código original.
+std::unique_ptr<FactorNode> makeVarFactor(const std::string& id,
+                                          ExpressionNode* origin);
+std::unique_ptr<FactorNode> makeNumberFactor(int value,
+                                             ExpressionNode* origin);
+std::unique_ptr<SimpleExpressionNode> makeExpression(
+    std::unique_ptr<FactorNode> left, TokenType op,
+    std::unique_ptr<FactorNode> right);
+std::unique_ptr<ExpressionStatementNode> makeAssignment(
+    const std::string& id, std::unique_ptr<ExpressionNode> value);
+std::unique_ptr<VarDeclarationNode> makeLocal(const std::string& id,
+                                              ExpressionNode* origin);
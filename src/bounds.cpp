@@ -0,0 +1,389 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de la eliminación de revisiones de rango.
+ * */
+#include "bounds.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "cfg.hpp"
+#include "mips.hpp"
+
+namespace {
+
+struct Range {
+  long long lo = INT_MIN;
+  long long hi = INT_MAX;
+
+  bool operator==(const Range& other) const {
+    return lo == other.lo && hi == other.hi;
+  }
+};
+
+// Rangos de los registros virtuales en un punto del programa. Un registro
+// que no está en el mapa puede valer cualquier cosa. Un estado sin
+// `reached` es código al que todavía no llega ningún camino.
+struct State {
+  bool reached = false;
+  std::map<int, Range> ranges;
+
+  bool operator==(const State& other) const {
+    return reached == other.reached && ranges == other.ranges;
+  }
+};
+
+}  // namespace
+
+static const Range FULL;
+
+// Si el resultado se puede salir de 32 bits, con el overflow puede valer
+// cualquier cosa.
+static Range make(long long lo, long long hi) {
+  if (lo < INT_MIN || hi > INT_MAX) return FULL;
+  return Range{lo, hi};
+}
+
+static Range rangeOf(const State& state, int reg) {
+  if (reg == Reg::ZERO) return Range{0, 0};
+  auto it = state.ranges.find(reg);
+  return it == state.ranges.end() ? FULL : it->second;
+}
+
+static void setRange(State& state, int reg, Range range) {
+  if (!Mips::isVirtual(reg)) return;
+  if (range == FULL) {
+    state.ranges.erase(reg);
+  } else {
+    state.ranges[reg] = range;
+  }
+}
+
+static bool intersect(State& state, int reg, Range bound) {
+  Range current = rangeOf(state, reg);
+  Range range{std::max(current.lo, bound.lo), std::min(current.hi, bound.hi)};
+  if (range.lo > range.hi) return false;
+  setRange(state, reg, range);
+  return true;
+}
+
+static void transfer(const Instruction& inst, State& state) {
+  // Después de una revisión el índice ya está dentro del arreglo, porque si
+  // no el programa terminó.
+  if (inst.op == Op::CHECK) {
+    if (!intersect(state, inst.rs, Range{0, inst.imm - 1LL})) {
+      state.reached = false;
+    }
+    return;
+  }
+
+  Range a = rangeOf(state, inst.rs), b = rangeOf(state, inst.rt);
+  Range value = FULL;
+  switch (inst.op) {
+    case Op::LI:
+      value = Range{inst.imm, inst.imm};
+      break;
+    case Op::MOVE:
+      value = a;
+      break;
+    case Op::ADDIU:
+      value = make(a.lo + inst.imm, a.hi + inst.imm);
+      break;
+    case Op::ADD:
+    case Op::ADDU:
+      value = make(a.lo + b.lo, a.hi + b.hi);
+      break;
+    case Op::SUB:
+    case Op::SUBU:
+      value = make(a.lo - b.hi, a.hi - b.lo);
+      break;
+    case Op::MUL: {
+      long long corners[] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo,
+                             a.hi * b.hi};
+      value = make(*std::min_element(corners, corners + 4),
+                   *std::max_element(corners, corners + 4));
+      break;
+    }
+    case Op::SLL:
+      value = make(a.lo * (1LL << inst.imm), a.hi * (1LL << inst.imm));
+      break;
+    case Op::SRA:
+      value = Range{a.lo >> inst.imm, a.hi >> inst.imm};
+      break;
+    case Op::SLT:
+    case Op::SLTU:
+    case Op::SLTIU:
+      value = Range{0, 1};
+      break;
+    case Op::XORI:
+      if (inst.imm == 1 && a.lo >= 0 && a.hi <= 1) value = Range{0, 1};
+      break;
+    default:
+      break;
+  }
+  for (int d : Mips::defs(inst)) setRange(state, d, value);
+}
+
+// a < b (o a >= b si no es strict) acota a los dos lados. Regresa false si
+// la condición no se puede cumplir.
+static bool refineLess(State& state, int a, int b, bool strict) {
+  Range ra = rangeOf(state, a), rb = rangeOf(state, b);
+  if (strict) {
+    return intersect(state, a, Range{INT_MIN, rb.hi - 1}) &&
+           intersect(state, b, Range{ra.lo + 1, INT_MAX});
+  }
+  return intersect(state, a, Range{rb.lo, INT_MAX}) &&
+         intersect(state, b, Range{INT_MIN, ra.hi});
+}
+
+// Si flag viene de un slt en el mismo bloque cuyos operandos no cambian antes
+// del branch, regresa esos operandos.
+static bool findCompare(const MachineFunction& fn, const BasicBlock& block,
+                        int flag, int& a, int& b) {
+  std::set<int> redefined;
+  for (int i = block.end - 2; i >= block.begin; --i) {
+    const Instruction& inst = fn.code[i];
+    auto defs = Mips::defs(inst);
+    if (std::count(defs.begin(), defs.end(), flag)) {
+      if (inst.op != Op::SLT || redefined.count(inst.rs) ||
+          redefined.count(inst.rt)) {
+        return false;
+      }
+      a = inst.rs;
+      b = inst.rt;
+      return true;
+    }
+    redefined.insert(defs.begin(), defs.end());
+  }
+  return false;
+}
+
+// Si reg es x + c (como la condición i + 3 < n de un loop desenrollado), x
+// no cambia antes del branch y la suma no se desborda, lo que se sabe de
+// reg también acota a x.
+static bool refineSource(const MachineFunction& fn, const BasicBlock& block,
+                         State& state, int reg) {
+  std::set<int> redefined;
+  for (int i = block.end - 2; i >= block.begin; --i) {
+    const Instruction& inst = fn.code[i];
+    auto defs = Mips::defs(inst);
+    if (!std::count(defs.begin(), defs.end(), reg)) {
+      redefined.insert(defs.begin(), defs.end());
+      continue;
+    }
+    int source = -1;
+    long long offset = 0;
+    if (inst.op == Op::ADDIU) {
+      source = inst.rs;
+      offset = inst.imm;
+    } else if (inst.op == Op::ADD || inst.op == Op::ADDU) {
+      Range a = rangeOf(state, inst.rs), b = rangeOf(state, inst.rt);
+      if (b.lo == b.hi && !redefined.count(inst.rt)) {
+        source = inst.rs;
+        offset = b.lo;
+      } else if (a.lo == a.hi && !redefined.count(inst.rs)) {
+        source = inst.rt;
+        offset = a.lo;
+      }
+    }
+    if (source < 0 || source == reg || redefined.count(source)) return true;
+    // Con overflow en la suma no se puede despejar x.
+    Range known = rangeOf(state, source);
+    if (known.lo + offset < INT_MIN || known.hi + offset > INT_MAX) {
+      return true;
+    }
+    Range range = rangeOf(state, reg);
+    return intersect(state, source,
+                     Range{std::max<long long>(INT_MIN, range.lo - offset),
+                           std::min<long long>(INT_MAX, range.hi - offset)});
+  }
+  return true;
+}
+
+// Lo que se sabe al tomar (taken) o no tomar el branch con el que termina el
+// bloque.
+static State refineEdge(const MachineFunction& fn, const BasicBlock& block,
+                        State state, bool taken) {
+  const Instruction& branch = fn.code[block.end - 1];
+  bool ok = true;
+  int a = 0, b = 0;
+  switch (branch.op) {
+    case Op::BEQ:
+    case Op::BNE: {
+      bool equal = (branch.op == Op::BEQ) == taken;
+      if (branch.rt == Reg::ZERO &&
+          findCompare(fn, block, branch.rs, a, b)) {
+        ok = refineLess(state, a, b, !equal) &&
+             refineSource(fn, block, state, a) &&
+             refineSource(fn, block, state, b);
+      } else if (equal) {
+        Range rs = rangeOf(state, branch.rs), rt = rangeOf(state, branch.rt);
+        ok = intersect(state, branch.rs, rt) && intersect(state, branch.rt, rs);
+      }
+      break;
+    }
+    case Op::BLTZ:
+      ok = intersect(state, branch.rs,
+                     taken ? Range{INT_MIN, -1} : Range{0, INT_MAX});
+      break;
+    case Op::BGEZ:
+      ok = intersect(state, branch.rs,
+                     taken ? Range{0, INT_MAX} : Range{INT_MIN, -1});
+      break;
+    case Op::BLEZ:
+      ok = intersect(state, branch.rs,
+                     taken ? Range{INT_MIN, 0} : Range{1, INT_MAX});
+      break;
+    case Op::BGTZ:
+      ok = intersect(state, branch.rs,
+                     taken ? Range{1, INT_MAX} : Range{INT_MIN, 0});
+      break;
+    default:
+      break;
+  }
+  if (!ok) state.reached = false;
+  return state;
+}
+
+static void join(State& into, const State& from) {
+  if (!from.reached) return;
+  if (!into.reached) {
+    into = from;
+    return;
+  }
+  std::map<int, Range> ranges;
+  for (const auto& [reg, range] : into.ranges) {
+    auto other = from.ranges.find(reg);
+    if (other == from.ranges.end()) continue;
+    ranges[reg] = Range{std::min(range.lo, other->second.lo),
+                        std::max(range.hi, other->second.hi)};
+  }
+  into.ranges = std::move(ranges);
+}
+
+// Lo que crece entre dos vueltas salta a la siguiente constante del
+// programa, para que los loops converjan sin perder el límite del loop. El
+// resultado siempre contiene al estado anterior.
+static void widen(State& next, const State& previous,
+                  const std::vector<long long>& thresholds) {
+  if (!previous.reached) return;
+  std::map<int, Range> ranges;
+  for (const auto& [reg, old] : previous.ranges) {
+    auto it = next.ranges.find(reg);
+    if (it == next.ranges.end()) continue;
+    Range range = old;
+    if (it->second.lo < old.lo) {
+      auto t = std::upper_bound(thresholds.begin(), thresholds.end(),
+                                it->second.lo);
+      range.lo = t == thresholds.begin() ? INT_MIN : *std::prev(t);
+    }
+    if (it->second.hi > old.hi) {
+      auto t = std::lower_bound(thresholds.begin(), thresholds.end(),
+                                it->second.hi);
+      range.hi = t == thresholds.end() ? INT_MAX : *t;
+    }
+    if (!(range == FULL)) ranges[reg] = range;
+  }
+  next.reached = true;
+  next.ranges = std::move(ranges);
+}
+
+BoundsReport eliminateBoundsChecks(MachineFunction& fn) {
+  BoundsReport report;
+  for (const auto& inst : fn.code) {
+    if (inst.op == Op::CHECK) report.checks++;
+  }
+  if (report.checks == 0) return report;
+
+  std::set<long long> constants = {-1, 0, 1};
+  for (const auto& inst : fn.code) {
+    if (inst.op == Op::LI || inst.op == Op::CHECK) {
+      for (long long c : {inst.imm - 1LL, inst.imm + 0LL, inst.imm + 1LL}) {
+        constants.insert(c);
+      }
+    }
+  }
+  std::vector<long long> thresholds(constants.begin(), constants.end());
+
+  ControlFlowGraph cfg(fn);
+  int n = cfg.blocks.size();
+  std::vector<State> in(n), out(n);
+  std::vector<int> visits(n, 0);
+
+  auto edgeState = [&](int from, int to) {
+    const BasicBlock& block = cfg.blocks[from];
+    const Instruction& last = fn.code[block.end - 1];
+    if (!last.isBranch() || !cfg.blockByLabel.count(last.label)) {
+      return out[from];
+    }
+    bool toTarget = cfg.blockByLabel.at(last.label) == to;
+    bool fallsInto = to == from + 1;
+    if (toTarget && fallsInto) return out[from];
+    return refineEdge(fn, block, out[from], toTarget);
+  };
+  auto computeIn = [&](int b) {
+    State state;
+    if (b == 0) state.reached = true;
+    for (int p : cfg.blocks[b].preds) join(state, edgeState(p, b));
+    return state;
+  };
+  auto computeOut = [&](int b) {
+    State state = in[b];
+    if (state.reached) {
+      for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+        transfer(fn.code[i], state);
+      }
+    }
+    return state;
+  };
+
+  // Punto fijo con ensanchamiento y después unas vueltas sin ensanchar para
+  // recuperar los límites que dan las condiciones de los loops.
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (int b = 0; b < n; ++b) {
+      State state = computeIn(b);
+      if (visits[b]++ > 0) widen(state, in[b], thresholds);
+      if (state == in[b]) continue;
+      in[b] = state;
+      out[b] = computeOut(b);
+      changed = true;
+    }
+  }
+  for (int round = 0; round < 2; ++round) {
+    for (int b = 0; b < n; ++b) {
+      in[b] = computeIn(b);
+      out[b] = computeOut(b);
+    }
+  }
+
+  std::vector<Instruction> code;
+  for (int b = 0; b < n; ++b) {
+    State state = in[b];
+    for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+      const Instruction& inst = fn.code[i];
+      if (inst.op != Op::CHECK) {
+        code.push_back(inst);
+        if (state.reached) transfer(inst, state);
+        continue;
+      }
+      Range index = rangeOf(state, inst.rs);
+      bool proven = !state.reached || (index.lo >= 0 && index.hi < inst.imm);
+      if (state.reached) transfer(inst, state);
+      if (proven) {
+        report.removed++;
+        continue;
+      }
+      // sltiu compara sin signo, así que un índice negativo también falla.
+      int inRange = fn.newVirtual();
+      code.push_back(Mips::immediate(Op::SLTIU, inRange, inst.rs, inst.imm));
+      code.push_back(
+          Mips::branch(Op::BEQ, inRange, Reg::ZERO, BOUNDS_ERROR_LABEL));
+    }
+  }
+  fn.code = std::move(code);
+  return report;
+}
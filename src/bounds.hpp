@@ -0,0 +1,22 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de la eliminación de revisiones de rango.
+ * */
+#pragma once
+
+#include "mips.hpp"
+
+// Etiqueta del manejador que imprime el error y termina el programa.
+constexpr const char* BOUNDS_ERROR_LABEL = "_bounds_error";
+
+struct BoundsReport {
+  int checks = 0;
+  int removed = 0;
+};
+
+// Calcula el intervalo de valores de cada registro virtual con un análisis
+// de rangos sobre el CFG (los loops se ensanchan hasta las constantes del
+// programa y los branches acotan sus operandos en cada lado). Las
+// revisiones CHECK cuyo índice ya está en [0, tamaño) se quitan; las demás
+// se cambian por sltiu + beq a BOUNDS_ERROR_LABEL.
+BoundsReport eliminateBoundsChecks(MachineFunction& fn);
@@ -0,0 +1,392 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del compilador del árbol a bytecode para
+ *  la VM.
+ * */
+#include "bytecode.hpp"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "astutil.hpp"
+#include "parser.hpp"
+
+namespace {
+
+// Dónde vive cada nombre mientras se compila una función.
+struct VmBinding {
+  enum Kind { REGISTER, GLOBAL, LOCAL_ARRAY, PARAM_ARRAY, GLOBAL_ARRAY } kind;
+  // El registro, el desplazamiento en el frame o la dirección del global.
+  int where;
+  // Tamaño del arreglo; 0 si no se conoce (parámetros).
+  int size = 0;
+};
+
+class BytecodeCompiler {
+ public:
+  BytecodeCompiler(BytecodeProgram& program, bool boundsCheck)
+      : program(program), code(program.code), boundsCheck(boundsCheck) {}
+
+  void compile(ProgramNode* tree);
+
+ private:
+  BytecodeProgram& program;
+  std::vector<VmInstruction>& code;
+  bool boundsCheck;
+  std::map<std::string, int> functionIndex;
+  std::map<std::string, VmBinding> globals;
+  std::vector<std::map<std::string, VmBinding>> scopes;
+  // Los registros se reparten como una pila: top es el primero libre y lo
+  // que está arriba de top está muerto, así que una llamada pone ahí el
+  // frame de la función llamada.
+  int top = 0;
+  int maxTop = 0;
+
+  int emit(VmOp op, int a = 0, int b = 0, int c = 0) {
+    code.push_back({op, a, b, c});
+    return code.size() - 1;
+  }
+  int here() const { return code.size(); }
+
+  int allocate(int words = 1) {
+    int at = top;
+    top += words;
+    maxTop = std::max(maxTop, top);
+    return at;
+  }
+
+  const VmBinding& lookup(const std::string& id) const {
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+      auto found = it->find(id);
+      if (found != it->end()) return found->second;
+    }
+    return globals.at(id);
+  }
+
+  void function(FunDeclarationNode* fun);
+  void statement(StatementNode* stmt);
+  int value(ExpressionNode* expr);
+  void valueInto(ExpressionNode* expr, int dest);
+  int assign(AssignmentExpressionNode* node);
+  void call(CallNode* node, int dest);
+  void readVar(VarNode* var, int dest);
+  int jumpIf(ExpressionNode* condition, bool when);
+
+  template <typename Node>
+  void chain(Node* node, int dest);
+};
+
+}  // namespace
+
+static VmOp compareOp(TokenType relop, bool jump) {
+  switch (relop) {
+    case TokenType::LT:
+      return jump ? VmOp::JLT : VmOp::LT;
+    case TokenType::LTE:
+      return jump ? VmOp::JLE : VmOp::LE;
+    case TokenType::GT:
+      return jump ? VmOp::JGT : VmOp::GT;
+    case TokenType::GTE:
+      return jump ? VmOp::JGE : VmOp::GE;
+    case TokenType::EQ:
+      return jump ? VmOp::JEQ : VmOp::EQ;
+    default:
+      return jump ? VmOp::JNE : VmOp::NE;
+  }
+}
+
+void BytecodeCompiler::compile(ProgramNode* tree) {
+  // Primero los nombres, para que las llamadas ya sepan su índice.
+  for (auto& decl : tree->declarationList) {
+    if (auto fun = dynamic_cast<FunDeclarationNode*>(decl.get())) {
+      functionIndex[fun->id] = program.functions.size();
+      program.functions.push_back({fun->id, (int)fun->params.size()});
+    } else if (auto var = dynamic_cast<VarDeclarationNode*>(decl.get())) {
+      int size = var->arraySize.value_or(1);
+      globals[var->id] = {var->arraySize ? VmBinding::GLOBAL_ARRAY
+                                         : VmBinding::GLOBAL,
+                          program.globalsSize, var->arraySize.value_or(0)};
+      program.globalsSize += size;
+    }
+  }
+
+  // El arranque: llama a main y termina cuando regresa.
+  emit(VmOp::CALL, functionIndex.at("main"), 0, -1);
+  emit(VmOp::HALT);
+  for (auto& decl : tree->declarationList) {
+    auto fun = dynamic_cast<FunDeclarationNode*>(decl.get());
+    if (fun && fun->compoundStatement) function(fun);
+  }
+}
+
+void BytecodeCompiler::function(FunDeclarationNode* fun) {
+  VmFunction& info = program.functions[functionIndex.at(fun->id)];
+  info.entry = here();
+  scopes.assign(1, {});
+  top = maxTop = 0;
+  for (auto& param : fun->params) {
+    scopes[0][param->id] = {
+        param->isArray ? VmBinding::PARAM_ARRAY : VmBinding::REGISTER,
+        allocate()};
+  }
+  statement(fun->compoundStatement.get());
+  // Una función que llega al final sin return regresa 0.
+  emit(VmOp::RETV);
+  info.frameSize = maxTop;
+}
+
+void BytecodeCompiler::statement(StatementNode* stmt) {
+  if (!stmt) return;
+  int saved = top;
+  if (auto expr = dynamic_cast<ExpressionStatementNode*>(stmt)) {
+    ExpressionNode* e = expr->expression.get();
+    if (auto assignment = dynamic_cast<AssignmentExpressionNode*>(e)) {
+      assign(assignment);
+    } else if (CallNode* callNode = e ? asCall(e) : nullptr) {
+      call(callNode, -1);
+    } else if (e) {
+      value(e);
+    }
+  } else if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+    scopes.emplace_back();
+    for (auto& var : comp->vars) {
+      if (var->arraySize) {
+        scopes.back()[var->id] = {VmBinding::LOCAL_ARRAY,
+                                  allocate(*var->arraySize),
+                                  *var->arraySize};
+      } else {
+        scopes.back()[var->id] = {VmBinding::REGISTER, allocate()};
+      }
+    }
+    for (auto& child : comp->statements) statement(child.get());
+    scopes.pop_back();
+  } else if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+    int skipThen = jumpIf(sel->condition.get(), false);
+    statement(sel->statement.get());
+    if (sel->elseStatement) {
+      int skipElse = emit(VmOp::JMP);
+      code[skipThen].a = here();
+      statement(sel->elseStatement.get());
+      code[skipElse].a = here();
+    } else {
+      code[skipThen].a = here();
+    }
+  } else if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+    // La condición va al final: cada vuelta hace un solo salto.
+    int toCondition = emit(VmOp::JMP);
+    int body = here();
+    statement(iter->statement.get());
+    code[toCondition].a = here();
+    code[jumpIf(iter->expression.get(), true)].a = body;
+  } else if (auto ret = dynamic_cast<ReturnStatementNode*>(stmt)) {
+    if (ret->expression) {
+      emit(VmOp::RET, value(ret->expression.get()));
+    } else {
+      emit(VmOp::RETV);
+    }
+  }
+  top = saved;
+}
+
+// Un salto (sin destino todavía) que se toma cuando la condición vale when.
+// Las comparaciones se vuelven un solo salto con la comparación.
+int BytecodeCompiler::jumpIf(ExpressionNode* condition, bool when) {
+  int saved = top;
+  int at;
+  SimpleExpressionNode* comparison = asComparison(condition);
+  if (comparison && comparison->additiveRight) {
+    int left = value(comparison->additiveLeft.get());
+    int right = value(comparison->additiveRight.get());
+    TokenType relop =
+        when ? comparison->relop : negateRelop(comparison->relop);
+    at = emit(compareOp(relop, true), -1, left, right);
+  } else {
+    at = emit(when ? VmOp::JNZ : VmOp::JZ, -1, value(condition));
+  }
+  top = saved;
+  return at;
+}
+
+// El registro donde queda el valor: el de la variable si es un escalar
+// local, o un temporal nuevo.
+int BytecodeCompiler::value(ExpressionNode* expr) {
+  VarNode* var = bareVar(asFactor(expr));
+  if (var) {
+    const VmBinding& binding = lookup(var->id);
+    if (binding.kind == VmBinding::REGISTER) return binding.where;
+  }
+  int dest = allocate();
+  valueInto(expr, dest);
+  return dest;
+}
+
+// Calcula la expresión en dest. dest solo se escribe con la última
+// instrucción, así que la expresión puede leer el valor anterior de dest.
+void BytecodeCompiler::valueInto(ExpressionNode* expr, int dest) {
+  if (auto factor = dynamic_cast<FactorNode*>(expr)) {
+    if (factor->expression) {
+      valueInto(factor->expression.get(), dest);
+    } else if (factor->call) {
+      call(factor->call.get(), dest);
+    } else if (factor->var) {
+      readVar(factor->var.get(), dest);
+    } else {
+      emit(VmOp::LOADK, dest, factor->value);
+    }
+  } else if (auto term = dynamic_cast<TermNode*>(expr)) {
+    chain(term, dest);
+  } else if (auto add = dynamic_cast<AdditiveExpressionNode*>(expr)) {
+    chain(add, dest);
+  } else if (auto simple = dynamic_cast<SimpleExpressionNode*>(expr)) {
+    if (!simple->additiveRight) {
+      valueInto(simple->additiveLeft.get(), dest);
+      return;
+    }
+    int left = value(simple->additiveLeft.get());
+    int right = value(simple->additiveRight.get());
+    emit(compareOp(simple->relop, false), dest, left, right);
+  } else if (auto assignment = dynamic_cast<AssignmentExpressionNode*>(expr)) {
+    int result = assign(assignment);
+    if (result != dest) emit(VmOp::MOVE, dest, result);
+  } else if (auto callNode = dynamic_cast<CallNode*>(expr)) {
+    call(callNode, dest);
+  }
+}
+
+// a op b op c ... de izquierda a derecha, para términos y sumas. Los
+// resultados intermedios van en un temporal y solo el último en dest.
+template <typename Node>
+void BytecodeCompiler::chain(Node* node, int dest) {
+  constexpr bool isTerm = std::is_same_v<Node, TermNode>;
+  auto leftOf = [](auto* link) -> ExpressionNode* {
+    if constexpr (isTerm) {
+      return link->leftFactor.get();
+    } else {
+      return link->leftTerm.get();
+    }
+  };
+  auto nextOf = [](auto* link) {
+    if constexpr (isTerm) {
+      return link->rightFactor.get();
+    } else {
+      return link->rightTerm.get();
+    }
+  };
+  if (!nextOf(node)) {
+    valueInto(leftOf(node), dest);
+    return;
+  }
+  int acc = value(leftOf(node));
+  int scratch = -1;
+  for (Node* link = node; nextOf(link); link = nextOf(link)) {
+    Node* right = nextOf(link);
+    int target = dest;
+    if (nextOf(right)) {
+      if (scratch < 0) scratch = allocate();
+      target = scratch;
+    }
+    if constexpr (isTerm) {
+      int operand = value(leftOf(right));
+      emit(link->mulop == TokenType::DIV ? VmOp::DIV : VmOp::MUL, target,
+           acc, operand);
+    } else {
+      // Sumar o restar una constante no necesita registro.
+      FactorNode* factor = asFactor(leftOf(right));
+      if (isLiteral(factor)) {
+        uint32_t constant = factor->value;
+        if (link->addop == TokenType::SUB) constant = 0u - constant;
+        emit(VmOp::ADDK, target, acc, (int32_t)constant);
+      } else {
+        int operand = value(leftOf(right));
+        emit(link->addop == TokenType::SUB ? VmOp::SUB : VmOp::ADD, target,
+             acc, operand);
+      }
+    }
+    acc = target;
+  }
+}
+
+// Como en el código MIPS, primero el valor y luego el subíndice.
+int BytecodeCompiler::assign(AssignmentExpressionNode* node) {
+  VarNode* var = node->var.get();
+  const VmBinding& binding = lookup(var->id);
+  if (!var->expression && binding.kind == VmBinding::REGISTER) {
+    valueInto(node->simpleExpression.get(), binding.where);
+    return binding.where;
+  }
+  int result = value(node->simpleExpression.get());
+  if (!var->expression) {
+    emit(VmOp::PUT, binding.where, result);
+    return result;
+  }
+  int index = value(var->expression.get());
+  if (boundsCheck && binding.size > 0) {
+    emit(VmOp::CHECK, index, binding.size);
+  }
+  VmOp store = binding.kind == VmBinding::GLOBAL_ARRAY ? VmOp::STOREG
+               : binding.kind == VmBinding::LOCAL_ARRAY ? VmOp::STOREL
+                                                        : VmOp::STOREP;
+  emit(store, binding.where, index, result);
+  return result;
+}
+
+void BytecodeCompiler::readVar(VarNode* var, int dest) {
+  const VmBinding& binding = lookup(var->id);
+  if (var->expression) {
+    int index = value(var->expression.get());
+    if (boundsCheck && binding.size > 0) {
+      emit(VmOp::CHECK, index, binding.size);
+    }
+    VmOp load = binding.kind == VmBinding::GLOBAL_ARRAY  ? VmOp::LOADG
+                : binding.kind == VmBinding::LOCAL_ARRAY ? VmOp::LOADL
+                                                         : VmOp::LOADP;
+    emit(load, dest, binding.where, index);
+    return;
+  }
+  // Sin subíndice: el valor de un escalar o la dirección de un arreglo,
+  // que es lo que se pasa como argumento.
+  switch (binding.kind) {
+    case VmBinding::REGISTER:
+    case VmBinding::PARAM_ARRAY:
+      if (binding.where != dest) emit(VmOp::MOVE, dest, binding.where);
+      break;
+    case VmBinding::GLOBAL:
+      emit(VmOp::GET, dest, binding.where);
+      break;
+    case VmBinding::LOCAL_ARRAY:
+      emit(VmOp::ADDR, dest, binding.where);
+      break;
+    case VmBinding::GLOBAL_ARRAY:
+      emit(VmOp::LOADK, dest, binding.where);
+      break;
+  }
+}
+
+// Los argumentos se calculan directo en los primeros registros del frame
+// de la función llamada; dest < 0 descarta el valor.
+void BytecodeCompiler::call(CallNode* node, int dest) {
+  if (node->id == "input") {
+    emit(VmOp::INPUT, dest >= 0 ? dest : allocate());
+    return;
+  }
+  if (node->id == "output") {
+    emit(VmOp::OUTPUT, value(node->argsList[0].get()));
+    return;
+  }
+  int window = allocate(node->argsList.size());
+  for (int i = 0; i < (int)node->argsList.size(); ++i) {
+    valueInto(node->argsList[i].get(), window + i);
+  }
+  emit(VmOp::CALL, functionIndex.at(node->id), window, dest);
+  top = window;
+}
+
+BytecodeProgram compileBytecode(ProgramNode* program, bool boundsCheck) {
+  BytecodeProgram bytecode;
+  BytecodeCompiler compiler(bytecode, boundsCheck);
+  compiler.compile(program);
+  return bytecode;
+}
@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del compilador del árbol a bytecode para la VM.
+ * */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+
+/*
+ *  Un bytecode de registros: cada función tiene un frame de registros
+ *  enteros (primero los parámetros, luego las variables locales y al final
+ *  los temporales) y las instrucciones leen y escriben esos registros
+ *  directamente, así que una variable local nunca se copia a una pila de
+ *  operandos. La memoria de la VM es un solo arreglo de palabras: los
+ *  globales, un espacio libre y los frames; una dirección es un índice en
+ *  ese arreglo. En la lista, r es un registro, k una constante y @ una
+ *  instrucción destino.
+ * */
+enum class VmOp : uint8_t {
+  LOADK,  // ra = kb
+  MOVE,   // ra = rb
+  ADD,    // ra = rb + rc
+  ADDK,   // ra = rb + kc
+  SUB,    // ra = rb - rc
+  MUL,    // ra = rb * rc
+  DIV,    // ra = rb / rc
+  LT,     // ra = rb < rc; igual LE, GT, GE, EQ y NE
+  LE,
+  GT,
+  GE,
+  EQ,
+  NE,
+  JMP,  // salta a @a
+  JLT,  // salta a @a si rb < rc; igual las demás comparaciones
+  JLE,
+  JGT,
+  JGE,
+  JEQ,
+  JNE,
+  JZ,   // salta a @a si rb == 0
+  JNZ,  // salta a @a si rb != 0
+  GET,  // ra = memoria[kb]: un global escalar
+  PUT,  // memoria[ka] = rb
+  // Elementos de arreglos: global en kb, local en el frame desde kb o
+  // parámetro con la dirección en rb. El subíndice va en rc.
+  LOADG,
+  LOADL,
+  LOADP,
+  // Igual, pero la base va en a, el subíndice en rb y el valor en rc.
+  STOREG,
+  STOREL,
+  STOREP,
+  ADDR,    // ra = dirección del arreglo local que empieza en kb del frame
+  CHECK,   // termina con el mensaje de error si no 0 <= ra < kb
+  CALL,    // llama a la función ka con su frame desde rb; el valor va a rc
+  RET,     // regresa ra
+  RETV,    // regresa sin valor
+  INPUT,   // ra = input()
+  OUTPUT,  // output(ra)
+  HALT,
+};
+
+struct VmInstruction {
+  VmOp op;
+  int32_t a = 0, b = 0, c = 0;
+};
+
+struct VmFunction {
+  std::string name;
+  int params = 0;
+  // Primera instrucción y tamaño del frame en palabras (registros y
+  // arreglos locales).
+  int entry = 0;
+  int frameSize = 0;
+};
+
+struct BytecodeProgram {
+  std::vector<VmInstruction> code;
+  std::vector<VmFunction> functions;
+  // Palabras que ocupan los globales al principio de la memoria.
+  int globalsSize = 0;
+};
+
+// Compila el árbol ya revisado por Semantic; no depende de las pasadas de
+// optimización ni del código MIPS. Con boundsCheck cada acceso a un arreglo
+// de tamaño conocido revisa su subíndice, con el mismo mensaje que el
+// código MIPS.
+BytecodeProgram compileBytecode(ProgramNode* program, bool boundsCheck);
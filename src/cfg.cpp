@@ -0,0 +1,216 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del grafo de flujo de control.
+ * */
+#include "cfg.hpp"
+
+#include <set>
+#include <vector>
+
+#include "mips.hpp"
+
+ControlFlowGraph::ControlFlowGraph(const MachineFunction& fn) {
+  const auto& code = fn.code;
+  int n = code.size();
+
+  // Un bloque empieza en cada etiqueta y después de cada salto.
+  int start = 0;
+  for (int i = 0; i < n; ++i) {
+    bool lastOfBlock = i + 1 == n || code[i + 1].isLabel() ||
+                       code[i].hasTarget() || code[i].endsBlock();
+    if (!lastOfBlock) continue;
+    BasicBlock block;
+    block.begin = start;
+    block.end = i + 1;
+    if (code[start].isLabel()) block.label = code[start].label;
+    blocks.push_back(block);
+    start = i + 1;
+  }
+
+  for (int b = 0; b < (int)blocks.size(); ++b) {
+    if (!blocks[b].label.empty()) blockByLabel[blocks[b].label] = b;
+    if (blocks[b].label == fn.exitLabel) exitBlock = b;
+  }
+
+  for (int b = 0; b < (int)blocks.size(); ++b) {
+    const Instruction& last = code[blocks[b].end - 1];
+    if (last.hasTarget() && blockByLabel.count(last.label)) {
+      blocks[b].succs.push_back(blockByLabel[last.label]);
+    }
+    if (!last.endsBlock() && b + 1 < (int)blocks.size() && b != exitBlock) {
+      blocks[b].succs.push_back(b + 1);
+    }
+    for (int s : blocks[b].succs) blocks[s].preds.push_back(b);
+  }
+}
+
+std::vector<bool> ControlFlowGraph::reachable() const {
+  std::vector<bool> seen(blocks.size(), false);
+  if (blocks.empty()) return seen;
+  std::vector<int> stack = {0};
+  seen[0] = true;
+  while (!stack.empty()) {
+    int b = stack.back();
+    stack.pop_back();
+    for (int s : blocks[b].succs) {
+      if (!seen[s]) {
+        seen[s] = true;
+        stack.push_back(s);
+      }
+    }
+  }
+  return seen;
+}
+
+void ControlFlowGraph::computeDominators() {
+  int n = blocks.size();
+  std::set<int> all;
+  for (int b = 0; b < n; ++b) all.insert(b);
+  dominators.assign(n, all);
+  if (n == 0) return;
+  dominators[0] = {0};
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int b = 1; b < n; ++b) {
+      std::set<int> dom = all;
+      for (int p : blocks[b].preds) {
+        std::set<int> meet;
+        for (int d : dom) {
+          if (dominators[p].count(d)) meet.insert(d);
+        }
+        dom = std::move(meet);
+      }
+      if (blocks[b].preds.empty()) dom.clear();
+      dom.insert(b);
+      if (dom != dominators[b]) {
+        dominators[b] = std::move(dom);
+        changed = true;
+      }
+    }
+  }
+}
+
+std::vector<Loop> findNaturalLoops(const ControlFlowGraph& cfg) {
+  std::vector<Loop> loops;
+  std::vector<bool> seen = cfg.reachable();
+  for (int b = 0; b < (int)cfg.blocks.size(); ++b) {
+    if (!seen[b]) continue;
+    for (int h : cfg.blocks[b].succs) {
+      if (!cfg.dominates(h, b)) continue;
+
+      Loop* loop = nullptr;
+      for (auto& other : loops) {
+        if (other.header == h) loop = &other;
+      }
+      if (!loop) {
+        loops.push_back(Loop{h, {h}, {}});
+        loop = &loops.back();
+      }
+      loop->latches.push_back(b);
+
+      std::vector<int> stack;
+      if (loop->blocks.insert(b).second) stack.push_back(b);
+      while (!stack.empty()) {
+        int x = stack.back();
+        stack.pop_back();
+        for (int p : cfg.blocks[x].preds) {
+          if (seen[p] && loop->blocks.insert(p).second) stack.push_back(p);
+        }
+      }
+    }
+  }
+  return loops;
+}
+
+namespace Location {
+
+bool isFrameSlot(const Instruction& inst, const MachineFunction& fn) {
+  return (inst.op == Op::LW || inst.op == Op::SW) && inst.rs == Reg::FP &&
+         fn.scalarSlots.count(inst.imm);
+}
+
+std::vector<int> defs(const Instruction& inst, const MachineFunction& fn) {
+  std::vector<int> result = Mips::defs(inst);
+  if (inst.op == Op::SW && isFrameSlot(inst, fn)) {
+    result.push_back(SLOT_BASE + inst.imm);
+  }
+  return result;
+}
+
+std::vector<int> uses(const Instruction& inst, const MachineFunction& fn) {
+  std::vector<int> result = Mips::uses(inst);
+  if (inst.op == Op::LW && isFrameSlot(inst, fn)) {
+    result.push_back(SLOT_BASE + inst.imm);
+  }
+  return result;
+}
+
+}  // namespace Location
+
+void computeLiveness(const MachineFunction& fn, ControlFlowGraph& cfg) {
+  // gen/kill de cada bloque
+  std::vector<std::set<int>> gen(cfg.blocks.size()), kill(cfg.blocks.size());
+  for (int b = 0; b < (int)cfg.blocks.size(); ++b) {
+    auto& block = cfg.blocks[b];
+    block.liveIn.clear();
+    block.liveOut.clear();
+    for (int i = block.begin; i < block.end; ++i) {
+      for (int u : Location::uses(fn.code[i], fn)) {
+        if (!kill[b].count(u)) gen[b].insert(u);
+      }
+      for (int d : Location::defs(fn.code[i], fn)) kill[b].insert(d);
+    }
+  }
+
+  // Al salir de la función siguen vivos el valor de retorno y los registros
+  // que el epílogo necesita.
+  std::set<int> exitLive = {Reg::SP, Reg::FP, Reg::RA};
+  for (int s = Reg::S0; s <= Reg::S7; ++s) exitLive.insert(s);
+  if (fn.returnsValue) exitLive.insert(Reg::V0);
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int b = cfg.blocks.size() - 1; b >= 0; --b) {
+      auto& block = cfg.blocks[b];
+      std::set<int> out;
+      if (b == cfg.exitBlock || block.succs.empty()) {
+        out = exitLive;
+        // Un j a una etiqueta de otra función es una llamada de cola ya
+        // armada: la otra función lee sus argumentos.
+        const Instruction& last = fn.code[block.end - 1];
+        if (last.op == Op::J && !cfg.blockByLabel.count(last.label)) {
+          for (int a = Reg::A0; a <= Reg::A3; ++a) out.insert(a);
+        }
+      }
+      for (int s : block.succs) {
+        out.insert(cfg.blocks[s].liveIn.begin(), cfg.blocks[s].liveIn.end());
+      }
+      std::set<int> in = gen[b];
+      for (int loc : out) {
+        if (!kill[b].count(loc)) in.insert(loc);
+      }
+      if (in != block.liveIn || out != block.liveOut) {
+        block.liveIn = std::move(in);
+        block.liveOut = std::move(out);
+        changed = true;
+      }
+    }
+  }
+}
+
+std::vector<std::set<int>> computeLiveAfter(const MachineFunction& fn,
+                                            const ControlFlowGraph& cfg) {
+  std::vector<std::set<int>> liveAfter(fn.code.size());
+  for (const auto& block : cfg.blocks) {
+    std::set<int> live = block.liveOut;
+    for (int i = block.end - 1; i >= block.begin; --i) {
+      liveAfter[i] = live;
+      for (int d : Location::defs(fn.code[i], fn)) live.erase(d);
+      for (int u : Location::uses(fn.code[i], fn)) live.insert(u);
+    }
+  }
+  return liveAfter;
+}
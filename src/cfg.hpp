@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del grafo de flujo de control y el análisis de
+ *  liveness sobre las instrucciones MIPS.
+ * */
+#pragma once
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mips.hpp"
+
+// Un bloque básico es el rango [begin, end) de MachineFunction::code.
+struct BasicBlock {
+  int begin;
+  int end;
+  std::string label;
+  std::vector<int> succs;
+  std::vector<int> preds;
+  std::set<int> liveIn;
+  std::set<int> liveOut;
+};
+
+class ControlFlowGraph {
+ public:
+  std::vector<BasicBlock> blocks;
+  std::unordered_map<std::string, int> blockByLabel;
+  int exitBlock = -1;
+
+  // dominators[b] es el conjunto de bloques que dominan a b.
+  std::vector<std::set<int>> dominators;
+
+  explicit ControlFlowGraph(const MachineFunction& fn);
+  std::vector<bool> reachable() const;
+  void computeDominators();
+  bool dominates(int a, int b) const { return dominators[b].count(a) > 0; }
+};
+
+// Un loop natural: el header y todos los bloques que llegan a un back edge
+// sin pasar por el header.
+struct Loop {
+  int header;
+  std::set<int> blocks;
+  std::vector<int> latches;
+};
+
+// Encuentra los loops naturales a partir de los back edges. Los loops que
+// comparten header se juntan en uno solo. Requiere computeDominators().
+std::vector<Loop> findNaturalLoops(const ControlFlowGraph& cfg);
+
+/*
+ *  Las "locaciones" que sigue el liveness son los registros y los slots
+ *  escalares del frame. Un slot se identifica como SLOT_BASE + desplazamiento
+ *  respecto a $fp para que no choque con los números de registro.
+ * */
+namespace Location {
+constexpr int SLOT_BASE = 1 << 20;
+
+bool isFrameSlot(const Instruction& inst, const MachineFunction& fn);
+std::vector<int> defs(const Instruction& inst, const MachineFunction& fn);
+std::vector<int> uses(const Instruction& inst, const MachineFunction& fn);
+}  // namespace Location
+
+// Llena liveIn y liveOut de cada bloque del grafo.
+void computeLiveness(const MachineFunction& fn, ControlFlowGraph& cfg);
+// Lo que está vivo justo después de cada instrucción. Requiere
+// computeLiveness().
+std::vector<std::set<int>> computeLiveAfter(const MachineFunction& fn,
+                                            const ControlFlowGraph& cfg);
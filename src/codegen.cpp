@@ -4,11 +4,21 @@
  * */
 #include "codegen.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
 #include <string>
+#include <utility>
 
+#include "astutil.hpp"
+#include "bounds.hpp"
+#include "cfg.hpp"
 #include "colors.hpp"
+#include "elf.hpp"
+#include "encoder.hpp"
+#include "globals.hpp"
+#include "layout.hpp"
+#include "mips.hpp"
 #include "parser.hpp"
 #include "semantic.hpp"
 
@@ -17,27 +27,28 @@ int labelCounter = 0;
 #include <fstream>
 #include <iostream>
 
-void printGeneratedCode(const std::string& filename) {
-  std::ifstream input(filename);
-  std::string line;
-  if (!input.is_open()) {
-    std::cerr << Style::bold_red("Error: ") << "Could not open file "
-              << filename << "\n";
-    return;
-  }
-
-  std::cout << Style::bold("Generated MIPS Code:\n\n");
-  while (std::getline(input, line)) {
+// Pinta el ensamblador con colores desde el mismo buffer que se escribe al
+// archivo, y lo manda a la terminal de una vez.
+void printGeneratedCode(const std::string& code) {
+  std::string colored = Style::bold("Generated MIPS Code:\n\n");
+  colored.reserve(colored.size() + code.size() * 2);
+  size_t start = 0;
+  while (start < code.size()) {
+    size_t end = code.find('\n', start);
+    if (end == std::string::npos) end = code.size();
+    std::string line = code.substr(start, end - start);
     if (line.empty()) {
-      std::cout << "\n";
+      colored += "\n";
     } else if (line[0] == '.') {
-      std::cout << Style::cyan(line) << "\n";
+      colored += Style::cyan(line) + "\n";
     } else if (line.back() == ':') {
-      std::cout << Style::yellow(line) << "\n";
+      colored += Style::yellow(line) + "\n";
     } else {
-      std::cout << Style::green("  " + line) << "\n";
+      colored += Style::green("  " + line) + "\n";
     }
+    start = end + 1;
   }
+  std::cout.write(colored.data(), colored.size());
 }
 
 std::string nodeToMIPS(VarDeclarationNode* node) {
@@ -53,32 +64,273 @@ std::string nodeToMIPS(VarDeclarationNode* node) {
   return finalString;
 }
 
+static Instruction memoryAccess(Op op, int reg, const MemoryOperand& at) {
+  if (!at.symbol.empty()) {
+    return Mips::gpRelative(op, reg, at.symbol, at.offset);
+  }
+  return op == Op::SW ? Mips::sw(reg, at.offset, at.base)
+                      : Mips::lw(reg, at.offset, at.base);
+}
+
+/*
+ *  Número de Sethi-Ullman: cuántos registros se necesitan para evaluar la
+ *  expresión sin guardar resultados intermedios en el stack. Las cadenas
+ *  a op b op c se evalúan de izquierda a derecha, así que se etiquetan como
+ *  ((a op b) op c).
+ * */
+static int binaryNeed(int left, int right) {
+  return left == right ? left + 1 : std::max(left, right);
+}
+
+static int registerNeed(ExpressionNode* node) {
+  if (auto factor = dynamic_cast<FactorNode*>(node)) {
+    if (factor->expression) return registerNeed(factor->expression.get());
+    if (factor->var && factor->var->expression) {
+      return std::max(1, registerNeed(factor->var->expression.get()));
+    }
+    return 1;
+  } else if (auto term = dynamic_cast<TermNode*>(node)) {
+    int need = registerNeed(term->leftFactor.get());
+    for (auto t = term; t->rightFactor; t = t->rightFactor.get()) {
+      need = binaryNeed(need, registerNeed(t->rightFactor->leftFactor.get()));
+    }
+    return need;
+  } else if (auto add = dynamic_cast<AdditiveExpressionNode*>(node)) {
+    int need = registerNeed(add->leftTerm.get());
+    for (auto a = add; a->rightTerm; a = a->rightTerm.get()) {
+      need = binaryNeed(need, registerNeed(a->rightTerm->leftTerm.get()));
+    }
+    return need;
+  } else if (auto simple = dynamic_cast<SimpleExpressionNode*>(node)) {
+    int need = registerNeed(simple->additiveLeft.get());
+    if (!simple->additiveRight) return need;
+    return binaryNeed(need, registerNeed(simple->additiveRight.get()));
+  } else if (auto assign = dynamic_cast<AssignmentExpressionNode*>(node)) {
+    return registerNeed(assign->simpleExpression.get());
+  }
+  // Una llamada deja su resultado en $v0 y los valores que siguen vivos
+  // después de ella ya viven en registros $s, así que cuenta como una hoja.
+  return 1;
+}
+
+// Llamadas y asignaciones: si alguno de los operandos las tiene, el orden
+// de evaluación se deja de izquierda a derecha.
+static bool hasSideEffects(ExpressionNode* node) {
+  bool found = false;
+  forEachExpression(node, [&](ExpressionNode* expr) {
+    if (dynamic_cast<CallNode*>(expr) ||
+        dynamic_cast<AssignmentExpressionNode*>(expr)) {
+      found = true;
+    }
+  });
+  return found;
+}
+
 CodeGenerator::CodeGenerator(Semantic& semantic) : semantic(semantic) {}
 
 void CodeGenerator::setup() {
-  fileToWrite.open("main.mips");
-
-  fileToWrite << ".data" << std::endl;
+  assembly.clear();
   isInGlobals = true;
 
-  for (const auto& decl : semantic.getTree()->declarationList) {
-    if (auto var = dynamic_cast<VarDeclarationNode*>(decl.get())) {
-      if (emittedGlobals.count(var->id)) continue;
-      emittedGlobals.insert(var->id);
-      fileToWrite << var->id << ": " << nodeToMIPS(var) << std::endl;
+  // Los globales chicos van en .sdata, donde se leen y escriben con una sola
+  // instrucción relativa a $gp; los arreglos grandes se quedan en .data.
+  globalLayout = layoutGlobals(semantic.getTree().get(), smallDataLimit);
+  auto declare = [&](VarDeclarationNode* var, bool small) {
+    emittedGlobals.insert(var->id);
+    if (var->arraySize) globalArraySizes[var->id] = *var->arraySize;
+    assembly += var->id + ": " + nodeToMIPS(var) + "\n";
+    if (needsObjectCode()) {
+      dataObjects.push_back(
+          {var->id, 4 * var->arraySize.value_or(1), "", small});
     }
+  };
+  if (!globalLayout.small.empty()) {
+    assembly += ".sdata\n";
+    for (auto* var : globalLayout.small) declare(var, true);
   }
+  assembly += ".data\n";
+  for (auto* var : globalLayout.large) declare(var, false);
 
   isInGlobals = false;
-  fileToWrite << "\n.text\n.globl main\nmain:\n";
-  fileToWrite << "  jal main_entry\n";
+  assembly += "\n.text\n.globl main\n";
+  std::vector<Instruction> start = {Mips::label("main"),
+                                    Mips::jump(Op::JAL, "main_entry")};
+  if (delaySlots) start.push_back(Mips::nop());
+  emitText(start);
+}
+
+// Agrega instrucciones al listado y, si se va a escribir el ELF, a la
+// sección de código que se codifica al final.
+void CodeGenerator::emitText(const std::vector<Instruction>& code) {
+  for (const auto& inst : code) {
+    Mips::appendTo(assembly, inst);
+    assembly += '\n';
+  }
+  if (needsObjectCode()) {
+    textSection.insert(textSection.end(), code.begin(), code.end());
+  }
 }
 
-void CodeGenerator::generate() {
+void CodeGenerator::generate(PassManager& passes) {
   setup();
+  passes.runTreePasses(semantic.getTree().get());
   generateForNode(semantic.getTree().get());
-  fileToWrite.close();
-  printGeneratedCode("main.mips");
+  passes.runModulePasses(functions);
+
+  // Los escalares globales que se pueden promover a registros.
+  for (const auto& name : emittedGlobals) {
+    if (!globalArraySizes.count(name)) globalScalars.insert(name);
+  }
+
+  for (auto& fn : functions) {
+    passes.runFunctionPasses(fn);
+    assembly += '\n';
+    emitText(fn.code);
+  }
+
+  // Un solo manejador para todas las revisiones que quedaron.
+  if (needsBoundsHandler) {
+    assembly += '\n';
+    emitText({Mips::label(BOUNDS_ERROR_LABEL), Mips::la(Reg::A0, "_bounds_msg"),
+              Mips::li(Reg::V0, 4), Mips::syscall(), Mips::li(Reg::V0, 10),
+              Mips::syscall()});
+    assembly +=
+        "\n.data\n_bounds_msg: .asciiz \"Error: index out of bounds\\n\"\n";
+    if (needsObjectCode()) {
+      dataObjects.push_back(
+          {"_bounds_msg", 0,
+           std::string("Error: index out of bounds\n") + '\0', false});
+    }
+  }
+
+  // Todo el programa sale al archivo en una sola escritura.
+  std::ofstream file("main.mips", std::ios::binary);
+  file.write(assembly.data(), assembly.size());
+  file.close();
+  if (printAssembly) printGeneratedCode(assembly);
+
+  // El mismo programa ya codificado, sin pasar por un ensamblador.
+  if (needsObjectCode()) {
+    object = encodeProgram(textSection, dataObjects);
+    object.functions.push_back("main");
+    for (const auto& fn : functions) {
+      object.functions.push_back(fn.name + "_entry");
+    }
+    for (const auto& error : object.errors) {
+      std::cerr << Style::bold_red("Error: ") << error << "\n";
+    }
+    if (emitElf && object.errors.empty() && !writeElf("main.elf", object)) {
+      std::cerr << Style::bold_red("Error: ") << "Could not write main.elf\n";
+    }
+  }
+}
+
+/*
+ *  Agrega el prólogo y el epílogo alrededor del cuerpo ya optimizado. El
+ *  cuerpo usa esta distribución del frame (el stack crece hacia abajo y $sp
+ *  apunta al siguiente slot libre):
+ *     4+4i($fp)  argumento 4+i (los primeros cuatro llegan en $a0-$a3)
+ *        0($fp)  $fp del caller
+ *       -4($fp)  $ra
+ *   -8-4k($fp)  primero los valores que no cupieron en registros y luego
+ *               los arreglos locales
+ *   debajo       registros $s que usó la función
+ *  Las funciones hoja no guardan $ra. Si el cuerpo nunca mueve $sp y está
+ *  activado omitFramePointer, el frame se direcciona desde $sp: no se guarda
+ *  $fp y los slots se recorren para no dejar huecos.
+ * */
+void CodeGenerator::lowerFrame(MachineFunction& fn) {
+  bool leaf = true;
+  bool movesStack = false;
+  for (const auto& inst : fn.code) {
+    if (inst.op == Op::JAL) leaf = false;
+    for (int d : Mips::defs(inst)) {
+      if (d == Reg::SP) movesStack = true;
+    }
+  }
+  // main termina con exit, así que nunca usa su $ra.
+  bool savesRa = !leaf && fn.name != "main";
+  bool usesFp = !omitFramePointer || movesStack;
+  int base = usesFp ? Reg::FP : Reg::SP;
+
+  int header = usesFp ? 8 : (savesRa ? 4 : 0);
+  int frameSize = header + fn.localsSize + 4 * fn.savedRegs.size();
+  int savedBase = -8 - fn.localsSize;
+  // Traduce un desplazamiento respecto a $fp al registro base real. Desde
+  // $sp los slots de spills pasan al fondo, junto a los $s guardados, para
+  // que sigan cerca de la base aunque haya arreglos grandes.
+  auto slot = [&](int offset) {
+    if (usesFp) return offset;
+    int depth = -8 - offset;
+    if (depth >= 0 && depth < fn.spillSize) {
+      return 4 * (int)fn.savedRegs.size() + 4 + depth;
+    }
+    if (depth >= 0 && depth < fn.localsSize) {
+      return frameSize - header - (depth - fn.spillSize);
+    }
+    if (offset == -4) {
+      offset = 0;
+    } else if (offset <= -8) {
+      offset += 8 - header;
+    }
+    return offset + frameSize;
+  };
+
+  std::vector<Instruction> code;
+  code.push_back(Mips::label(fn.name + "_entry"));
+  if (usesFp) {
+    code.push_back(Mips::sw(Reg::FP, 0, Reg::SP));
+    code.push_back(Mips::move(Reg::FP, Reg::SP));
+  }
+  if (frameSize > 0) {
+    code.push_back(Mips::addiu(Reg::SP, Reg::SP, -frameSize));
+  }
+  if (savesRa) code.push_back(Mips::sw(Reg::RA, slot(-4), base));
+  for (int i = 0; i < (int)fn.savedRegs.size(); ++i) {
+    code.push_back(Mips::sw(fn.savedRegs[i], slot(savedBase - 4 * i), base));
+  }
+
+  auto restoreFrame = [&]() {
+    for (int i = 0; i < (int)fn.savedRegs.size(); ++i) {
+      code.push_back(
+          Mips::lw(fn.savedRegs[i], slot(savedBase - 4 * i), base));
+    }
+    if (savesRa) code.push_back(Mips::lw(Reg::RA, slot(-4), base));
+    int pop = 4 * fn.stackParams();
+    if (usesFp) {
+      code.push_back(Mips::move(Reg::SP, Reg::FP));
+      code.push_back(Mips::lw(Reg::FP, 0, Reg::SP));
+    } else {
+      pop += frameSize;
+    }
+    if (pop > 0) code.push_back(Mips::addiu(Reg::SP, Reg::SP, pop));
+  };
+
+  // Una llamada de cola deshace el frame y salta a la otra función, que
+  // regresa directo a nuestro caller con el mismo $ra.
+  for (auto inst : fn.code) {
+    bool frameAccess = inst.op == Op::LW || inst.op == Op::SW ||
+                       inst.op == Op::ADDIU;
+    if (frameAccess && inst.rs == Reg::FP && !usesFp) {
+      inst.rs = Reg::SP;
+      inst.imm = slot(inst.imm);
+    }
+    if (inst.op == Op::TAILCALL) {
+      restoreFrame();
+      code.push_back(Mips::jump(Op::J, inst.label));
+    } else {
+      code.push_back(inst);
+    }
+  }
+
+  restoreFrame();
+  if (fn.name == "main") {
+    code.push_back(Mips::li(Reg::V0, 10));
+    code.push_back(Mips::syscall());
+  } else {
+    code.push_back(Mips::jr(Reg::RA));
+  }
+  fn.code = std::move(code);
 }
 
 template <typename Node>
@@ -89,6 +341,7 @@ void CodeGenerator::generateForNode(Node* tree) {
 
 void CodeGenerator::visitImpl(ProgramNode* node) {
   for (auto& child : node->declarationList) {
+    isInGlobals = child->declarationKind == DeclarationKind::VarD;
     generateForNode(child.get());
   }
 }
@@ -97,52 +350,86 @@ void CodeGenerator::visitImpl(VarDeclarationNode* node) {
   if (isInGlobals) {
     if (emittedGlobals.count(node->id)) return;
     emittedGlobals.insert(node->id);
-    fileToWrite << node->id << ": " << nodeToMIPS(node) << std::endl;
+    assembly += node->id + ": " + nodeToMIPS(node) + "\n";
+    if (needsObjectCode()) {
+      dataObjects.push_back(
+          {node->id, 4 * node->arraySize.value_or(1), "", false});
+    }
   } else {
+    if (!node->arraySize) {
+      // Las variables escalares viven en un registro virtual; el asignador
+      // decide si terminan en un registro físico o en el stack.
+      varRegs[node->id] = current->newVirtual();
+      emit(Mips::comment("Local var '" + node->id + "' in " +
+                         Mips::regName(varRegs[node->id])));
+      return;
+    }
+    // El arreglo ocupa una palabra por elemento; a[0] queda en la dirección
+    // más baja.
+    int size = *node->arraySize;
+    currentStackOffset -= 4 * (size - 1);
     localOffsets[node->id] = currentStackOffset;
-    fileToWrite << "  # Allocate local var '" << node->id << "' at "
-                << currentStackOffset << "($fp)\n";
+    localArraySizes[node->id] = size;
+    emit(Mips::comment("Allocate local array '" + node->id + "' (" +
+                       std::to_string(size) + " words) at " +
+                       std::to_string(currentStackOffset) + "($fp)"));
     currentStackOffset -= 4;
   }
 }
 
 void CodeGenerator::visitImpl(FunDeclarationNode* node) {
-  fileToWrite << "\n" << node->id << "_entry:" << std::endl;
+  functions.emplace_back();
+  current = &functions.back();
+  current->name = node->id;
+  current->exitLabel = node->id + "_exit";
+  current->numParams = node->params.size();
+  current->returnsValue = node->type == "int";
 
   localOffsets.clear();
-  currentStackOffset = -4;
-
-  fileToWrite << "  move $fp, $sp\n";
-  fileToWrite << "  sw $fp, 0($sp)\n";
-  fileToWrite << "  addiu $sp, $sp, -4\n";
-  fileToWrite << "  sw $ra, 0($sp)\n";
-  fileToWrite << "  addiu $sp, $sp, -4\n";
-
-  offsets.clear();
-  int paramOffset = 8;
-  for (const auto& param : node->params) {
-    offsets[param->id] = paramOffset;
-    paramOffset += 4;
+  localArraySizes.clear();
+  arrayParams.clear();
+  varRegs.clear();
+  paramRegs.clear();
+  bodyLabel.clear();
+  currentStackOffset = -8;
+
+  // Cada parámetro se copia una sola vez a su registro virtual: los cuatro
+  // primeros desde $a0-$a3 y el resto desde el stack.
+  int paramOffset = 4;
+  for (int i = 0; i < (int)node->params.size(); ++i) {
+    int reg = current->newVirtual();
+    varRegs[node->params[i]->id] = reg;
+    paramRegs.push_back(reg);
+    if (node->params[i]->isArray) arrayParams.insert(node->params[i]->id);
+    if (i < Reg::ARG_REGS) {
+      emit(Mips::move(reg, Reg::A0 + i));
+    } else {
+      current->scalarSlots.insert(paramOffset);
+      emit(Mips::lw(reg, paramOffset, Reg::FP));
+      paramOffset += 4;
+    }
   }
 
-  generateForNode(node->compoundStatement.get());
+  // La recursión de cola salta aquí, después de copiar los parámetros.
+  forEachStatement(node->compoundStatement.get(), [&](StatementNode* stmt) {
+    auto ret = dynamic_cast<ReturnStatementNode*>(stmt);
+    CallNode* call = ret ? asCall(ret->expression.get()) : nullptr;
+    if (call && call->id == node->id) bodyLabel = node->id + "_body";
+  });
+  if (!bodyLabel.empty()) emit(Mips::label(bodyLabel));
 
-  int totalArgsBytes = 4 * node->params.size();
+  generateForNode(node->compoundStatement.get());
 
-  if (node->id == "main") {
-    fileToWrite << "  lw $ra, 4($sp)\n";
-    fileToWrite << "  lw $fp, 0($sp)\n";
-    fileToWrite << "  addiu $sp, $sp, " << std::to_string(totalArgsBytes)
-                << "\n";
-    fileToWrite << "  li $v0, 10\n";
-    fileToWrite << "  syscall\n";
-  } else {
-    fileToWrite << "  lw $ra, 4($sp)\n";
-    fileToWrite << "  lw $fp, 0($sp)\n";
-    fileToWrite << "  addiu $sp, $sp, " << std::to_string(totalArgsBytes)
-                << "\n";
-    fileToWrite << "  jr $ra\n";
+  // Los bloques poco probables van al final, fuera del camino que cae.
+  if (!coldCode.empty()) {
+    emit(Mips::jump(Op::J, current->exitLabel));
+    current->code.insert(current->code.end(), coldCode.begin(),
+                         coldCode.end());
+    coldCode.clear();
   }
+
+  current->localsSize = -8 - currentStackOffset;
+  emit(Mips::label(current->exitLabel));
 }
 
 void CodeGenerator::visitImpl(CompoundStatementNode* node) {
@@ -150,9 +437,60 @@ void CodeGenerator::visitImpl(CompoundStatementNode* node) {
   for (auto& stmt : node->statements) generateForNode(stmt.get());
 }
 
+bool CodeGenerator::isTailCallable(CallNode* node) {
+  if (node->id == "input" || node->id == "output") return false;
+  // La dirección de un arreglo local deja de ser válida en cuanto se
+  // reutiliza el frame.
+  for (auto& arg : node->argsList) {
+    VarNode* var = bareVar(asFactor(arg.get()));
+    if (var && localArraySizes.count(var->id)) return false;
+  }
+  if (node->id == current->name) return true;
+  // Los argumentos tienen que caber en $a0-$a3, porque el frame del caller
+  // ya no existe cuando empieza la otra función.
+  return current->name != "main" &&
+         (int)node->argsList.size() <= Reg::ARG_REGS;
+}
+
+void CodeGenerator::generateTailCall(CallNode* node) {
+  std::vector<int> args;
+  for (auto& arg : node->argsList) args.push_back(generateValue(arg.get()));
+
+  if (node->id != current->name) {
+    for (int i = 0; i < (int)args.size(); ++i) {
+      emit(Mips::move(Reg::A0 + i, args[i]));
+    }
+    emit(Mips::tailCall(node->id + "_entry"));
+    return;
+  }
+
+  // Recursión de cola: se reasignan los parámetros y se vuelve al inicio del
+  // cuerpo. Un argumento que es otro parámetro se copia antes para que la
+  // reasignación no lo pise, como en gcd(v, u).
+  for (int i = 0; i < (int)args.size(); ++i) {
+    bool isParam = std::count(paramRegs.begin(), paramRegs.end(), args[i]);
+    if (isParam && args[i] != paramRegs[i]) {
+      int copy = current->newVirtual();
+      emit(Mips::move(copy, args[i]));
+      args[i] = copy;
+    }
+  }
+  for (int i = 0; i < (int)args.size(); ++i) {
+    if (args[i] != paramRegs[i]) emit(Mips::move(paramRegs[i], args[i]));
+  }
+  emit(Mips::jump(Op::J, bodyLabel));
+}
+
 void CodeGenerator::visitImpl(ReturnStatementNode* node) {
-  generateForNode(node->expression.get());
-  fileToWrite << "  move $v0, $t0\n";
+  CallNode* call = asCall(node->expression.get());
+  if (call && isTailCallable(call)) {
+    generateTailCall(call);
+    return;
+  }
+  if (node->expression) {
+    emit(Mips::move(Reg::V0, generateValue(node->expression.get())));
+  }
+  emit(Mips::jump(Op::J, current->exitLabel));
 }
 
 void CodeGenerator::visitImpl(ExpressionStatementNode* node) {
@@ -162,24 +500,43 @@ void CodeGenerator::visitImpl(ExpressionStatementNode* node) {
 void CodeGenerator::visitImpl(IterationStatementNode* node) {
   std::string loop = "loop" + std::to_string(labelCounter);
   std::string end = "endloop" + std::to_string(labelCounter++);
-  fileToWrite << loop << ":\n";
-  generateForNode(node);
-  fileToWrite << "  beq $t0, $zero, " << end << "\n";
-  generateForNode(node);
-  fileToWrite << "  j " << loop << "\n";
-  fileToWrite << end << ":\n";
+  // Loop rotado: la condición se prueba una vez antes de entrar y después al
+  // final de cada vuelta, así cada iteración ejecuta un solo branch.
+  generateBranch(node->expression.get(), false, end);
+  emit(Mips::label(loop));
+  generateForNode(node->statement.get());
+  generateBranch(node->expression.get(), true, loop);
+  emit(Mips::label(end));
 }
 
 void CodeGenerator::visitImpl(SelectionStatementNode* node) {
-  std::string trueLbl = "true" + std::to_string(labelCounter);
+  std::string thenLbl = "then" + std::to_string(labelCounter);
+  std::string elseLbl = "else" + std::to_string(labelCounter);
   std::string endLbl = "endif" + std::to_string(labelCounter++);
-  generateForNode(node->condition.get());
-  fileToWrite << "  bne $t0, $zero, " << trueLbl << "\n";
-  if (node->elseStatement) generateForNode(node->elseStatement.get());
-  fileToWrite << "  j " << endLbl << "\n";
-  fileToWrite << trueLbl << ":\n";
-  generateForNode(node->statement.get());
-  fileToWrite << endLbl << ":\n";
+  // Las etiquetas del then y del else siempre se emiten para que el perfil
+  // pueda contarlas sin importar cómo se acomodaron.
+  if (thenIsLikely(node, current->name, profile, thenLbl, elseLbl)) {
+    generateBranch(node->condition.get(), false, elseLbl);
+    emit(Mips::label(thenLbl));
+    generateForNode(node->statement.get());
+    if (node->elseStatement) emit(Mips::jump(Op::J, endLbl));
+    emit(Mips::label(elseLbl));
+    if (node->elseStatement) generateForNode(node->elseStatement.get());
+  } else {
+    generateBranch(node->condition.get(), true, thenLbl);
+    emit(Mips::label(elseLbl));
+    if (node->elseStatement) generateForNode(node->elseStatement.get());
+
+    // El then se genera aparte y se agrega al final de la función.
+    std::vector<Instruction> hot;
+    std::swap(hot, current->code);
+    emit(Mips::label(thenLbl));
+    generateForNode(node->statement.get());
+    emit(Mips::jump(Op::J, endLbl));
+    std::swap(hot, current->code);
+    coldCode.insert(coldCode.end(), hot.begin(), hot.end());
+  }
+  emit(Mips::label(endLbl));
 }
 
 void CodeGenerator::visitImpl(ExpressionNode* node) {
@@ -212,50 +569,205 @@ void CodeGenerator::visitImpl(StatementNode* node) {
   }
 }
 
+int CodeGenerator::generateValue(ExpressionNode* node) {
+  generateForNode(node);
+  return result;
+}
+
+// Evalúa primero el operando que necesita más registros, así el resultado
+// del otro no tiene que seguir vivo mientras se calcula el más pesado.
+std::pair<int, int> CodeGenerator::generateOperands(ExpressionNode* left,
+                                                    ExpressionNode* right) {
+  if (registerNeed(right) > registerNeed(left) && !hasSideEffects(left) &&
+      !hasSideEffects(right)) {
+    int second = generateValue(right);
+    return {generateValue(left), second};
+  }
+  int first = generateValue(left);
+  return {first, generateValue(right)};
+}
+
+// La misma comparación con los operandos volteados: a < b es b > a.
+static TokenType swapRelop(TokenType relop) {
+  switch (relop) {
+    case TokenType::LT:
+      return TokenType::GT;
+    case TokenType::LTE:
+      return TokenType::GTE;
+    case TokenType::GT:
+      return TokenType::LT;
+    case TokenType::GTE:
+      return TokenType::LTE;
+    default:
+      return relop;
+  }
+}
+
+static bool isZero(ExpressionNode* expr) {
+  FactorNode* factor = asFactor(expr);
+  return factor && isLiteral(factor) && factor->value == 0;
+}
+
+/*
+ *  Salta a target cuando la condición vale jumpIf. Una comparación se
+ *  convierte directo en branch sin calcular antes el 0 o 1: contra cero usa
+ *  blez/bgtz/bltz/bgez, la igualdad beq/bne y el resto slt seguido de un
+ *  branch.
+ * */
+void CodeGenerator::generateBranch(ExpressionNode* condition, bool jumpIf,
+                                   const std::string& target) {
+  SimpleExpressionNode* compare = asComparison(condition);
+  if (!compare) {
+    int value = generateValue(condition);
+    emit(Mips::branch(jumpIf ? Op::BNE : Op::BEQ, value, Reg::ZERO, target));
+    return;
+  }
+
+  TokenType relop = jumpIf ? compare->relop : negateRelop(compare->relop);
+  ExpressionNode* left = compare->additiveLeft.get();
+  ExpressionNode* right = compare->additiveRight.get();
+  if (isZero(left)) {
+    std::swap(left, right);
+    relop = swapRelop(relop);
+  }
+
+  if (isZero(right)) {
+    int value = generateValue(left);
+    switch (relop) {
+      case TokenType::LT:
+        emit(Mips::branchZero(Op::BLTZ, value, target));
+        break;
+      case TokenType::LTE:
+        emit(Mips::branchZero(Op::BLEZ, value, target));
+        break;
+      case TokenType::GT:
+        emit(Mips::branchZero(Op::BGTZ, value, target));
+        break;
+      case TokenType::GTE:
+        emit(Mips::branchZero(Op::BGEZ, value, target));
+        break;
+      case TokenType::EQ:
+        emit(Mips::branch(Op::BEQ, value, Reg::ZERO, target));
+        break;
+      default:
+        emit(Mips::branch(Op::BNE, value, Reg::ZERO, target));
+        break;
+    }
+    return;
+  }
+
+  auto [a, b] = generateOperands(left, right);
+  if (relop == TokenType::EQ || relop == TokenType::NOT_EQ) {
+    emit(Mips::branch(relop == TokenType::EQ ? Op::BEQ : Op::BNE, a, b,
+                      target));
+    return;
+  }
+  // a < b y a >= b salen de slt a, b; a > b y a <= b de slt b, a.
+  bool less = relop == TokenType::LT || relop == TokenType::GTE;
+  bool strict = relop == TokenType::LT || relop == TokenType::GT;
+  int flag = current->newVirtual();
+  emit(less ? Mips::rtype(Op::SLT, flag, a, b)
+            : Mips::rtype(Op::SLT, flag, b, a));
+  emit(Mips::branch(strict ? Op::BNE : Op::BEQ, flag, Reg::ZERO, target));
+}
+
+// Una comparación usada como valor queda en 0 o 1.
 void CodeGenerator::visitImpl(SimpleExpressionNode* node) {
-  if (node->additiveRight) {
-    generateForNode(node->additiveLeft.get());
-    fileToWrite << "  move $t1, $t0\n";
-    generateForNode(node->additiveRight.get());
-    fileToWrite << "  add $t0, $t1, $t0\n";
-  } else {
+  if (!node->additiveRight) {
     generateForNode(node->additiveLeft.get());
+    return;
+  }
+  auto [left, right] = generateOperands(node->additiveLeft.get(),
+                                        node->additiveRight.get());
+  int flag = current->newVirtual();
+  result = current->newVirtual();
+  switch (node->relop) {
+    case TokenType::LT:
+      emit(Mips::rtype(Op::SLT, result, left, right));
+      break;
+    case TokenType::GT:
+      emit(Mips::rtype(Op::SLT, result, right, left));
+      break;
+    case TokenType::LTE:
+      emit(Mips::rtype(Op::SLT, flag, right, left));
+      emit(Mips::immediate(Op::XORI, result, flag, 1));
+      break;
+    case TokenType::GTE:
+      emit(Mips::rtype(Op::SLT, flag, left, right));
+      emit(Mips::immediate(Op::XORI, result, flag, 1));
+      break;
+    case TokenType::EQ:
+      emit(Mips::rtype(Op::XOR, flag, left, right));
+      emit(Mips::immediate(Op::SLTIU, result, flag, 1));
+      break;
+    default:
+      emit(Mips::rtype(Op::XOR, flag, left, right));
+      emit(Mips::rtype(Op::SLTU, result, Reg::ZERO, flag));
+      break;
   }
 }
 
 void CodeGenerator::visitImpl(AdditiveExpressionNode* node) {
-  if (node->rightTerm) {
-    generateForNode(node->leftTerm.get());
-    fileToWrite << "  move $t1, $t0\n";
-    generateForNode(node->rightTerm.get());
-    fileToWrite << "  add $t0, $t1, $t0\n";
-  } else {
+  if (!node->rightTerm) {
     generateForNode(node->leftTerm.get());
+    return;
+  }
+  // La cadena se evalúa de izquierda a derecha: a - b + c es (a - b) + c.
+  // addu y subu dan la vuelta al desbordarse, igual que la VM y el x86;
+  // add y sub terminarían el programa con una excepción.
+  auto [acc, right] = generateOperands(node->leftTerm.get(),
+                                       node->rightTerm->leftTerm.get());
+  for (auto add = node;;) {
+    Op op = add->addop == TokenType::SUB ? Op::SUBU : Op::ADDU;
+    int sum = current->newVirtual();
+    emit(Mips::rtype(op, sum, acc, right));
+    acc = sum;
+    add = add->rightTerm.get();
+    if (!add->rightTerm) break;
+    right = generateValue(add->rightTerm->leftTerm.get());
   }
+  result = acc;
 }
 
 void CodeGenerator::visitImpl(AssignmentExpressionNode* node) {
-  generateForNode(node->simpleExpression.get());
-
-  if (offsets.count(node->var->id)) {
-    fileToWrite << "  sw $t0, " << offsets[node->var->id] << "($fp)\n";
-  } else if (localOffsets.count(node->var->id)) {
-    fileToWrite << "  sw $t0, " << localOffsets[node->var->id] << "($fp)\n";
+  int value = generateValue(node->simpleExpression.get());
+
+  if (node->var->expression) {
+    emit(memoryAccess(Op::SW, value,
+                      generateElementAddress(node->var.get())));
+  } else if (varRegs.count(node->var->id)) {
+    emit(Mips::move(varRegs[node->var->id], value));
+  } else if (globalLayout.isSmall(node->var->id)) {
+    emit(Mips::gpRelative(Op::SW, value, node->var->id));
   } else {
-    fileToWrite << "  la $t1, " << node->var->id << "\n";
-    fileToWrite << "  sw $t0, 0($t1)\n";
+    int address = current->newVirtual();
+    emit(Mips::la(address, node->var->id));
+    emit(Mips::sw(value, 0, address));
   }
+  result = value;
 }
 
 void CodeGenerator::visitImpl(TermNode* node) {
-  if (node->rightFactor) {
-    generateForNode(node->leftFactor.get());
-    fileToWrite << "  move $t1, $t0\n";
-    generateForNode(node->rightFactor.get());
-    fileToWrite << "  mul $t0, $t1, $t0\n";
-  } else {
+  if (!node->rightFactor) {
     generateForNode(node->leftFactor.get());
+    return;
   }
+  auto [acc, right] = generateOperands(node->leftFactor.get(),
+                                       node->rightFactor->leftFactor.get());
+  for (auto term = node;;) {
+    int product = current->newVirtual();
+    if (term->mulop == TokenType::DIV) {
+      emit(Mips::hilo(Op::DIV, acc, right));
+      emit(Mips::moveFrom(Op::MFLO, product));
+    } else {
+      emit(Mips::rtype(Op::MUL, product, acc, right));
+    }
+    acc = product;
+    term = term->rightFactor.get();
+    if (!term->rightFactor) break;
+    right = generateValue(term->rightFactor->leftFactor.get());
+  }
+  result = acc;
 }
 
 void CodeGenerator::visitImpl(FactorNode* node) {
@@ -265,49 +777,154 @@ void CodeGenerator::visitImpl(FactorNode* node) {
     generateForNode(node->var.get());
   } else if (node->call) {
     generateForNode(node->call.get());
+  } else {
+    result = current->newVirtual();
+    emit(Mips::li(result, node->value));
   }
 }
 
 void CodeGenerator::visitImpl(CallNode* node) {
   std::string& funcName = node->id;
   if (funcName == "input") {
-    fileToWrite << "  li $v0, 5\n";
-    fileToWrite << "  syscall\n";
-    fileToWrite << "  move $t0, $v0\n";
+    emit(Mips::li(Reg::V0, 5));
+    emit(Mips::syscall());
+    result = current->newVirtual();
+    emit(Mips::move(result, Reg::V0));
     return;
   }
 
   if (funcName == "output") {
-    generateForNode(node->argsList[0].get());
-    fileToWrite << "  move $a0, $t0\n";
-    fileToWrite << "  li $v0, 1\n";
-    fileToWrite << "  syscall\n";
+    emit(Mips::move(Reg::A0, generateValue(node->argsList[0].get())));
+    emit(Mips::li(Reg::V0, 1));
+    emit(Mips::syscall());
     return;
   }
-  for (int i = node->argsList.size() - 1; i >= 0; --i) {
-    generateForNode(node->argsList[i].get());
-    fileToWrite << "  sw $t0, 0($sp)\n";
-    fileToWrite << "  addiu $sp, $sp, -4\n";
+  // Primero se evalúan todos los argumentos, porque una llamada dentro de
+  // uno de ellos usaría los mismos $a.
+  std::vector<int> args;
+  for (auto& arg : node->argsList) args.push_back(generateValue(arg.get()));
+  for (int i = args.size() - 1; i >= Reg::ARG_REGS; --i) {
+    emit(Mips::sw(args[i], 0, Reg::SP));
+    emit(Mips::addiu(Reg::SP, Reg::SP, -4));
   }
-  fileToWrite << "  jal " << node->id << "_entry\n";
-  fileToWrite << "  move $t0, $v0\n";
+  for (int i = 0; i < (int)args.size() && i < Reg::ARG_REGS; ++i) {
+    emit(Mips::move(Reg::A0 + i, args[i]));
+  }
+  emit(Mips::jump(Op::JAL, node->id + "_entry"));
+  result = current->newVirtual();
+  emit(Mips::move(result, Reg::V0));
 }
 
-void CodeGenerator::visitImpl(VarNode* node) {
-  if (offsets.count(node->id)) {
-    int offset = offsets[node->id];
-    fileToWrite << "  lw $t0, " << offset << "($fp)\n";
-  } else if (localOffsets.count(node->id)) {
-    int offset = localOffsets[node->id];
-    fileToWrite << "  lw $t0, " << offset << "($fp)\n";
+bool CodeGenerator::isArray(const std::string& id) {
+  if (arrayParams.count(id) || localArraySizes.count(id)) return true;
+  return !varRegs.count(id) && globalArraySizes.count(id);
+}
+
+// Número de elementos, o 0 si no se conoce (los parámetros).
+int CodeGenerator::arraySize(const std::string& id) {
+  if (arrayParams.count(id)) return 0;
+  if (localArraySizes.count(id)) return localArraySizes[id];
+  return globalArraySizes.count(id) ? globalArraySizes[id] : 0;
+}
+
+int CodeGenerator::generateArrayBase(const std::string& id) {
+  if (arrayParams.count(id)) return varRegs[id];
+  int base = current->newVirtual();
+  if (localArraySizes.count(id)) {
+    emit(Mips::addiu(base, Reg::FP, localOffsets[id]));
+  } else if (globalLayout.isSmall(id)) {
+    emit(Mips::gpRelative(Op::ADDIU, base, id));
   } else {
-    fileToWrite << "  la $t1, " << node->id << "\n";
-    fileToWrite << "  lw $t0, 0($t1)\n";
+    emit(Mips::la(base, id));
+  }
+  return base;
+}
+
+
+/*
+ *  Dirección de var[índice] como (registro base, desplazamiento). El índice
+ *  se escala con sll; una constante c o un índice de la forma i + c se
+ *  suman al desplazamiento del lw/sw. La base se calcula aparte para que el
+ *  LICM la saque de los loops.
+ * */
+MemoryOperand CodeGenerator::generateElementAddress(VarNode* var) {
+  ExpressionNode* index = var->expression.get();
+  int size = boundsCheck ? arraySize(var->id) : 0;
+
+  // Los paréntesis alrededor de todo el subíndice no cambian nada.
+  FactorNode* factor = asFactor(index);
+  while (factor && factor->expression) {
+    index = factor->expression.get();
+    factor = asFactor(index);
+  }
+  if (isLiteral(factor)) {
+    int constant = factor->value;
+    if (size > 0 && (constant < 0 || constant >= size)) {
+      int value = current->newVirtual();
+      emit(Mips::li(value, constant));
+      emit(Mips::boundsCheck(value, size));
+    }
+    if (localArraySizes.count(var->id)) {
+      return {Reg::FP, localOffsets[var->id] + 4 * constant, ""};
+    }
+    if (!arrayParams.count(var->id) && globalLayout.isSmall(var->id)) {
+      return {Reg::GP, 4 * constant, var->id};
+    }
+    return {generateArrayBase(var->id), 4 * constant, ""};
+  }
+
+  // Con revisión de rango se necesita el índice completo en un registro.
+  int constant = 0;
+  auto simple = dynamic_cast<SimpleExpressionNode*>(index);
+  AdditiveExpressionNode* add =
+      simple && !simple->additiveRight ? simple->additiveLeft.get() : nullptr;
+  if (size == 0 && add && add->rightTerm && !add->rightTerm->rightTerm &&
+      !add->rightTerm->leftTerm->rightFactor &&
+      isLiteral(add->rightTerm->leftTerm->leftFactor.get())) {
+    constant = add->rightTerm->leftTerm->leftFactor->value;
+    if (add->addop == TokenType::SUB) constant = -constant;
+    index = add->leftTerm.get();
+  }
+
+  int value = generateValue(index);
+  if (size > 0) emit(Mips::boundsCheck(value, size));
+  int base = generateArrayBase(var->id);
+  int scaled = current->newVirtual();
+  emit(Mips::shift(Op::SLL, scaled, value, 2));
+  int address = current->newVirtual();
+  emit(Mips::rtype(Op::ADDU, address, base, scaled));
+  return {address, 4 * constant, ""};
+}
+
+void CodeGenerator::visitImpl(VarNode* node) {
+  if (node->expression) {
+    MemoryOperand element = generateElementAddress(node);
+    result = current->newVirtual();
+    emit(memoryAccess(Op::LW, result, element));
+    return;
+  }
+  // Un arreglo sin subíndice solo aparece como argumento: se pasa su
+  // dirección.
+  if (isArray(node->id)) {
+    result = generateArrayBase(node->id);
+    return;
+  }
+  if (varRegs.count(node->id)) {
+    result = varRegs[node->id];
+    return;
+  }
+  result = current->newVirtual();
+  if (globalLayout.isSmall(node->id)) {
+    emit(Mips::gpRelative(Op::LW, result, node->id));
+    return;
   }
+  int address = current->newVirtual();
+  emit(Mips::la(address, node->id));
+  emit(Mips::lw(result, 0, address));
 }
 
 void CodeGenerator::visitImpl(ParamNode* node) {
-  fileToWrite << "  # ParamNode code generation not implemented\n";
+  emit(Mips::comment("ParamNode code generation not implemented"));
 }
 
 void CodeGenerator::visitImpl(DeclarationNode* node) {
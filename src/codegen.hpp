@@ -3,27 +3,129 @@
  *  Este es el header file del generador de código
  * */
 #pragma once
-#include <fstream>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "bounds.hpp"
+#include "ctfe.hpp"
+#include "encoder.hpp"
+#include "globals.hpp"
+#include "layout.hpp"
+#include "mips.hpp"
 #include "parser.hpp"
+#include "passes.hpp"
 #include "semantic.hpp"
+#include "unroll.hpp"
+// Un operando de lw/sw: offset(base), o %gp_rel(symbol + offset)($gp) si
+// symbol no está vacío.
+struct MemoryOperand {
+  int base;
+  int offset = 0;
+  std::string symbol;
+};
+
 class CodeGenerator {
   Semantic& semantic;
-  std::ofstream fileToWrite;
+  // El ensamblador completo; se escribe al archivo al final de generate().
+  std::string assembly;
+  // Lo mismo ya como instrucciones y objetos de datos, para codificarlo
+  // directo a un ELF.
+  std::vector<Instruction> textSection;
+  std::vector<DataObject> dataObjects;
+  // El programa ya codificado, si se pidió.
+  ObjectCode object;
   bool isInGlobals;
   std::unordered_set<std::string> emittedGlobals;
-  std::unordered_map<std::string, int> offsets;
+  // Registro virtual de cada variable escalar local o parámetro.
+  std::unordered_map<std::string, int> varRegs;
   std::unordered_map<std::string, int> localOffsets;
   int currentStackOffset = 0;
+  // Arreglos: los locales empiezan en su localOffsets, los parámetros traen
+  // la dirección en su registro virtual y los globales usan su etiqueta.
+  std::unordered_map<std::string, int> localArraySizes;
+  std::unordered_map<std::string, int> globalArraySizes;
+  std::unordered_set<std::string> arrayParams;
+  // Qué globales quedaron en .sdata.
+  GlobalLayout globalLayout;
+
+  // Las funciones se generan primero en memoria para poder optimizarlas antes
+  // de escribirlas.
+  std::vector<MachineFunction> functions;
+  MachineFunction* current = nullptr;
+  // Los escalares globales, que promote puede tener en registros.
+  std::unordered_set<std::string> globalScalars;
+  // Si quedó alguna revisión de -fbounds-check que salta al manejador.
+  bool needsBoundsHandler = false;
+
+  // Registro donde quedó el valor de la última expresión generada.
+  int result = -1;
+
+  void emit(const Instruction& inst) { current->code.push_back(inst); }
+  // Registros virtuales de los parámetros de la función actual y la etiqueta
+  // a la que salta la recursión de cola.
+  std::vector<int> paramRegs;
+  std::string bodyLabel;
+  // Bloques poco probables que se emiten al final de la función actual.
+  std::vector<Instruction> coldCode;
+
+  int generateValue(ExpressionNode* node);
+  bool isArray(const std::string& id);
+  int arraySize(const std::string& id);
+  int generateArrayBase(const std::string& id);
+  MemoryOperand generateElementAddress(VarNode* var);
+  bool isTailCallable(CallNode* node);
+  void generateTailCall(CallNode* node);
+  void generateBranch(ExpressionNode* condition, bool jumpIf,
+                      const std::string& target);
+  std::pair<int, int> generateOperands(ExpressionNode* left,
+                                       ExpressionNode* right);
+  void lowerFrame(MachineFunction& fn);
+
+  friend void registerPasses(PassManager& passes, CodeGenerator& codegen,
+                             PassReports& reports);
 
  public:
+  // Direcciona el frame desde $sp en las funciones que no lo mueven.
+  bool omitFramePointer = true;
+  // Conteos de una corrida anterior para acomodar los if; vacío usa las
+  // heurísticas estáticas.
+  BranchProfile profile;
+  // Genera para un MIPS con delay slots: cada salto lleva una instrucción
+  // (o un nop) después.
+  bool delaySlots = false;
+  // Revisa en ejecución que los subíndices estén dentro del arreglo, menos
+  // donde el análisis de rangos ya lo prueba.
+  bool boundsCheck = false;
+  // Tamaño máximo en bytes de un global en .sdata; 0 lo desactiva.
+  int smallDataLimit = SMALL_DATA_DEFAULT;
+  // Copias del cuerpo por vuelta cuando corre la pasada unroll. Con 1 solo
+  // se desenrollan completos los loops cortos.
+  int unrollFactor = UNROLL_DEFAULT_FACTOR;
+  // Pasos que se permite evaluar cada llamada pura con argumentos constantes
+  // antes de dejarla para la ejecución; 0 no evalúa ninguna.
+  long long constevalBudget = CTFE_STEP_BUDGET;
+  // Imprime en la terminal el código generado con colores.
+  bool printAssembly = true;
+  // Además de main.mips escribe main.elf con el código ya codificado.
+  bool emitElf = false;
+  // Codifica el programa aunque no se escriba el ELF, para el simulador y
+  // el benchmark de main.cpp (ver getObjectCode).
+  bool encodeObject = false;
+
   CodeGenerator(Semantic& semantic);
 
-  void generate();
+  // Corre las pasadas del pipeline de passes (ver registerPasses) mientras
+  // genera el código.
+  void generate(PassManager& passes);
   void setup();
+  void emitText(const std::vector<Instruction>& code);
+  bool needsObjectCode() const { return emitElf || encodeObject; }
+  // Lo que dejó generate() si needsObjectCode(); errors dice si sirve.
+  const ObjectCode& getObjectCode() const { return object; }
   void writeToFile(std::string& content);
   template <typename Node>
   void generateForNode(Node* tree);
@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de la eliminación de subexpresiones
+ *  comunes.
+ * */
+#include "cse.hpp"
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "cfg.hpp"
+#include "mips.hpp"
+
+// Los operandos tienen que ser virtuales o registros que el cuerpo no
+// cambia por debajo, no los que pisa un jal.
+bool isNumberable(const Instruction& inst) {
+  switch (inst.op) {
+    case Op::ADD:
+    case Op::ADDU:
+    case Op::SUB:
+    case Op::SUBU:
+    case Op::MUL:
+    case Op::XOR:
+    case Op::SLT:
+    case Op::SLTU:
+    case Op::ADDIU:
+    case Op::XORI:
+    case Op::SLTIU:
+    case Op::SLL:
+    case Op::SRL:
+    case Op::SRA:
+    case Op::LI:
+    case Op::LA:
+      break;
+    default:
+      return false;
+  }
+  if (!Mips::isVirtual(inst.rd)) return false;
+  // Un li que cabe en 16 bits cuesta lo mismo que la copia.
+  if (inst.op == Op::LI && inst.imm >= -32768 && inst.imm <= 65535) {
+    return false;
+  }
+  for (int reg : {inst.rs, inst.rt}) {
+    bool fixed = reg == -1 || reg == Reg::ZERO || reg == Reg::GP ||
+                 reg == Reg::FP || reg == Reg::SP;
+    if (!fixed && !Mips::isVirtual(reg)) return false;
+  }
+  return true;
+}
+
+ValueKey valueKey(const Instruction& inst) {
+  int a = inst.rs, b = inst.rt;
+  bool commutative = inst.op == Op::ADD || inst.op == Op::ADDU ||
+                     inst.op == Op::MUL || inst.op == Op::XOR;
+  if (commutative && b < a) std::swap(a, b);
+  return {inst.op, a, b, inst.imm, inst.label};
+}
+
+int eliminateCommonSubexpressions(MachineFunction& fn) {
+  ControlFlowGraph cfg(fn);
+  int reused = 0;
+
+  for (const auto& block : cfg.blocks) {
+    std::map<ValueKey, int> available;
+    // Registros que tienen una copia de otro; sus usos leen del original.
+    std::map<int, int> copyOf;
+
+    for (int i = block.begin; i < block.end; ++i) {
+      Instruction& inst = fn.code[i];
+      for (int* operand : {&inst.rs, &inst.rt}) {
+        if (copyOf.count(*operand)) *operand = copyOf[*operand];
+      }
+
+      bool numberable = isNumberable(inst);
+      ValueKey key;
+      int source = -1;
+      if (numberable) {
+        key = valueKey(inst);
+        auto it = available.find(key);
+        if (it != available.end() && it->second != inst.rd) {
+          source = it->second;
+          inst = Mips::move(inst.rd, source);
+          reused++;
+        }
+      }
+
+      // Lo que se calculó con un registro que se redefine ya no sirve.
+      for (int d : Mips::defs(inst)) {
+        for (auto it = available.begin(); it != available.end();) {
+          const auto& [op, a, b, imm, label] = it->first;
+          if (it->second == d || a == d || b == d) {
+            it = available.erase(it);
+          } else {
+            ++it;
+          }
+        }
+        for (auto it = copyOf.begin(); it != copyOf.end();) {
+          if (it->first == d || it->second == d) {
+            it = copyOf.erase(it);
+          } else {
+            ++it;
+          }
+        }
+      }
+
+      if (source >= 0) {
+        copyOf[inst.rd] = source;
+      } else if (numberable && std::get<1>(key) != inst.rd &&
+                 std::get<2>(key) != inst.rd) {
+        available[key] = inst.rd;
+      }
+    }
+  }
+  return reused;
+}
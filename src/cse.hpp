@@ -0,0 +1,26 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de la eliminación de subexpresiones comunes.
+ * */
+#pragma once
+
+#include <string>
+#include <tuple>
+
+#include "mips.hpp"
+
+// Identifica el valor que calcula una instrucción: operación, operandos (en
+// orden canónico si conmuta), inmediato y símbolo.
+using ValueKey = std::tuple<Op, int, int, int, std::string>;
+
+// Si la instrucción depende solo de sus operandos (no de memoria ni de HI/LO)
+// y escribe un registro virtual.
+bool isNumberable(const Instruction& inst);
+ValueKey valueKey(const Instruction& inst);
+
+// Numeración de valores dentro de cada bloque básico: si una operación sin
+// efectos secundarios ya se calculó con los mismos operandos, se reusa el
+// registro que la tiene y los usos siguientes leen directo de él. Las copias
+// que quedan las borra eliminateDeadCode. Regresa cuántas operaciones se
+// reusaron.
+int eliminateCommonSubexpressions(MachineFunction& fn);
@@ -0,0 +1,351 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de la evaluación de llamadas en tiempo de
+ *  compilación.
+ * */
+#include "ctfe.hpp"
+
+#include <climits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "astutil.hpp"
+#include "parser.hpp"
+
+namespace {
+
+// Lo que hace que una llamada no se pueda evaluar en tiempo de compilación.
+struct EvaluationAborted {
+  std::string reason;
+};
+
+// Los arreglos que llegan como parámetro comparten el del caller.
+struct ArrayValue {
+  std::vector<int> values;
+  std::vector<bool> written;
+};
+
+struct Slot {
+  int value = 0;
+  bool written = false;
+  std::shared_ptr<ArrayValue> array;
+};
+
+// Arreglos locales más grandes no se evalúan.
+constexpr int CTFE_MAX_ARRAY = 1 << 16;
+
+class Evaluator {
+ public:
+  long long steps = 0;
+
+  Evaluator(const std::map<std::string, FunDeclarationNode*>& functions,
+            long long budget)
+      : functions(functions), budget(budget) {}
+
+  int call(FunDeclarationNode* fun, const std::vector<Slot>& args) {
+    if (++depth > CTFE_MAX_DEPTH) throw EvaluationAborted{"recursión profunda"};
+    auto saved = std::move(scopes);
+    scopes.assign(1, {});
+    for (int i = 0; i < (int)fun->params.size(); ++i) {
+      scopes[0][fun->params[i]->id] = args[i];
+    }
+    execute(fun->compoundStatement.get());
+    std::optional<int> value = returnValue;
+    returned = false;
+    returnValue.reset();
+    scopes = std::move(saved);
+    depth--;
+    if (fun->type == "int" && !value) {
+      throw EvaluationAborted{"termina sin return"};
+    }
+    return value.value_or(0);
+  }
+
+ private:
+  const std::map<std::string, FunDeclarationNode*>& functions;
+  long long budget;
+  int depth = 0;
+  std::vector<std::map<std::string, Slot>> scopes;
+  bool returned = false;
+  std::optional<int> returnValue;
+
+  void tick() {
+    if (++steps > budget) throw EvaluationAborted{"excede el límite"};
+  }
+
+  Slot& lookup(const std::string& id) {
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+      auto found = it->find(id);
+      if (found != it->end()) return found->second;
+    }
+    // Lo que no está en el frame es un global, que depende de la ejecución.
+    throw EvaluationAborted{"lee el global " + id};
+  }
+
+  void execute(StatementNode* stmt) {
+    if (!stmt || returned) return;
+    tick();
+    if (auto expr = dynamic_cast<ExpressionStatementNode*>(stmt)) {
+      if (expr->expression) evaluateStatement(expr->expression.get());
+    } else if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+      scopes.emplace_back();
+      for (auto& var : comp->vars) {
+        Slot slot;
+        if (var->arraySize) {
+          if (*var->arraySize > CTFE_MAX_ARRAY) {
+            throw EvaluationAborted{"arreglo muy grande"};
+          }
+          slot.array = std::make_shared<ArrayValue>();
+          slot.array->values.assign(*var->arraySize, 0);
+          slot.array->written.assign(*var->arraySize, false);
+        }
+        scopes.back()[var->id] = slot;
+      }
+      for (auto& child : comp->statements) {
+        execute(child.get());
+        if (returned) break;
+      }
+      scopes.pop_back();
+    } else if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+      if (evaluate(sel->condition.get())) {
+        execute(sel->statement.get());
+      } else {
+        execute(sel->elseStatement.get());
+      }
+    } else if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+      while (!returned && evaluate(iter->expression.get())) {
+        execute(iter->statement.get());
+      }
+    } else if (auto ret = dynamic_cast<ReturnStatementNode*>(stmt)) {
+      if (ret->expression) returnValue = evaluate(ret->expression.get());
+      returned = true;
+    }
+  }
+
+  // Las asignaciones solo se evalúan como statement (o encadenadas, a = b =
+  // c): dentro de una expresión el orden en que el código las ejecuta puede
+  // ser otro.
+  int evaluateStatement(ExpressionNode* expr) {
+    auto assign = dynamic_cast<AssignmentExpressionNode*>(expr);
+    if (!assign) return evaluate(expr);
+    tick();
+    int value = evaluateStatement(assign->simpleExpression.get());
+    Slot& slot = lookup(assign->var->id);
+    if (assign->var->expression) {
+      int index = evaluate(assign->var->expression.get());
+      ArrayValue& array = element(slot, index);
+      array.values[index] = value;
+      array.written[index] = true;
+    } else {
+      if (slot.array) throw EvaluationAborted{"asigna un arreglo"};
+      slot.value = value;
+      slot.written = true;
+    }
+    return value;
+  }
+
+  ArrayValue& element(Slot& slot, int index) {
+    if (!slot.array) throw EvaluationAborted{"subíndice a un escalar"};
+    if (index < 0 || index >= (int)slot.array->values.size()) {
+      throw EvaluationAborted{"índice fuera del arreglo"};
+    }
+    return *slot.array;
+  }
+
+  int read(VarNode* var) {
+    Slot& slot = lookup(var->id);
+    if (var->expression) {
+      int index = evaluate(var->expression.get());
+      ArrayValue& array = element(slot, index);
+      if (!array.written[index]) throw EvaluationAborted{"lee sin inicializar"};
+      return array.values[index];
+    }
+    if (slot.array || !slot.written) {
+      throw EvaluationAborted{"lee sin inicializar"};
+    }
+    return slot.value;
+  }
+
+  int evaluateCall(CallNode* call) {
+    if (call->id == "input" || call->id == "output") {
+      throw EvaluationAborted{"hace entrada o salida"};
+    }
+    auto it = functions.find(call->id);
+    if (it == functions.end()) throw EvaluationAborted{"llamada desconocida"};
+    FunDeclarationNode* fun = it->second;
+
+    // Los argumentos se evalúan de izquierda a derecha, como en el código.
+    std::vector<Slot> args;
+    for (int i = 0; i < (int)call->argsList.size(); ++i) {
+      Slot slot;
+      if (fun->params[i]->isArray) {
+        VarNode* var = bareVar(asFactor(call->argsList[i].get()));
+        if (!var) throw EvaluationAborted{"arreglo sin nombre"};
+        slot = lookup(var->id);
+        if (!slot.array) throw EvaluationAborted{"arreglo sin nombre"};
+      } else {
+        slot.value = evaluate(call->argsList[i].get());
+        slot.written = true;
+      }
+      args.push_back(slot);
+    }
+    return this->call(fun, args);
+  }
+
+  int evaluate(ExpressionNode* expr) {
+    tick();
+    if (auto factor = dynamic_cast<FactorNode*>(expr)) {
+      if (factor->expression) return evaluate(factor->expression.get());
+      if (factor->call) return evaluateCall(factor->call.get());
+      if (factor->var) return read(factor->var.get());
+      return factor->value;
+    }
+    if (auto term = dynamic_cast<TermNode*>(expr)) {
+      int acc = evaluate(term->leftFactor.get());
+      for (TermNode* t = term; t->rightFactor; t = t->rightFactor.get()) {
+        int right = evaluate(t->rightFactor->leftFactor.get());
+        if (t->mulop == TokenType::DIV) {
+          if (right == 0) throw EvaluationAborted{"división entre cero"};
+          if (acc == INT_MIN && right == -1) {
+            throw EvaluationAborted{"desborda la división"};
+          }
+          acc /= right;
+        } else {
+          acc = (int)((unsigned)acc * (unsigned)right);
+        }
+      }
+      return acc;
+    }
+    if (auto add = dynamic_cast<AdditiveExpressionNode*>(expr)) {
+      int acc = evaluate(add->leftTerm.get());
+      for (auto a = add; a->rightTerm; a = a->rightTerm.get()) {
+        unsigned right = evaluate(a->rightTerm->leftTerm.get());
+        acc = (int)(a->addop == TokenType::SUB ? (unsigned)acc - right
+                                               : (unsigned)acc + right);
+      }
+      return acc;
+    }
+    if (auto simple = dynamic_cast<SimpleExpressionNode*>(expr)) {
+      int left = evaluate(simple->additiveLeft.get());
+      if (!simple->additiveRight) return left;
+      int right = evaluate(simple->additiveRight.get());
+      switch (simple->relop) {
+        case TokenType::LT:
+          return left < right;
+        case TokenType::LTE:
+          return left <= right;
+        case TokenType::GT:
+          return left > right;
+        case TokenType::GTE:
+          return left >= right;
+        case TokenType::EQ:
+          return left == right;
+        default:
+          return left != right;
+      }
+    }
+    if (auto call = dynamic_cast<CallNode*>(expr)) return evaluateCall(call);
+    throw EvaluationAborted{"asignación dentro de una expresión"};
+  }
+};
+
+}  // namespace
+
+static std::string describeCall(const std::string& id,
+                                const std::vector<int>& args) {
+  std::string text = id + "(";
+  for (int i = 0; i < (int)args.size(); ++i) {
+    if (i > 0) text += ", ";
+    text += std::to_string(args[i]);
+  }
+  return text + ")";
+}
+
+std::vector<EvaluatedCall> evaluateConstantCalls(
+    ProgramNode* program, const std::vector<std::string>& pure,
+    long long budget) {
+  std::vector<EvaluatedCall> results;
+  if (budget <= 0) return results;
+
+  std::map<std::string, FunDeclarationNode*> functions;
+  for (auto& decl : program->declarationList) {
+    auto fun = dynamic_cast<FunDeclarationNode*>(decl.get());
+    if (fun && fun->compoundStatement) functions[fun->id] = fun;
+  }
+  std::set<std::string> candidates(pure.begin(), pure.end());
+
+  // La misma llamada en otro lugar da lo mismo, incluso si no se pudo
+  // evaluar.
+  std::map<std::pair<std::string, std::vector<int>>, EvaluatedCall> memo;
+  // Las llamadas que ya no se pudieron evaluar no se vuelven a intentar.
+  std::set<CallNode*> tried;
+
+  // Al cambiar una llamada por su valor pueden quedar otras con argumentos
+  // constantes, como en f(g(3) + 1).
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto& decl : program->declarationList) {
+      auto fun = dynamic_cast<FunDeclarationNode*>(decl.get());
+      if (!fun || !fun->compoundStatement) continue;
+
+      std::vector<FactorNode*> sites;
+      forEachExpression(fun->compoundStatement.get(),
+                        [&](ExpressionNode* expr) {
+                          auto factor = dynamic_cast<FactorNode*>(expr);
+                          if (!factor || !factor->call ||
+                              !candidates.count(factor->call->id) ||
+                              tried.count(factor->call.get())) {
+                            return;
+                          }
+                          for (auto& arg : factor->call->argsList) {
+                            if (!isLiteral(asFactor(arg.get()))) return;
+                          }
+                          sites.push_back(factor);
+                        });
+
+      bool folded = false;
+      for (FactorNode* factor : sites) {
+        CallNode* call = factor->call.get();
+        tried.insert(call);
+        std::vector<int> args;
+        for (auto& arg : call->argsList) {
+          args.push_back(asFactor(arg.get())->value);
+        }
+        auto key = std::make_pair(call->id, args);
+        if (!memo.count(key)) {
+          EvaluatedCall result{fun->id, describeCall(call->id, args),
+                               false, 0, 0, ""};
+          Evaluator evaluator(functions, budget);
+          std::vector<Slot> slots;
+          for (int value : args) slots.push_back(Slot{value, true, nullptr});
+          try {
+            result.value = evaluator.call(functions.at(call->id), slots);
+            result.folded = true;
+          } catch (const EvaluationAborted& aborted) {
+            result.reason = aborted.reason;
+          }
+          result.steps = evaluator.steps;
+          memo[key] = result;
+          results.push_back(result);
+        } else {
+          EvaluatedCall result = memo[key];
+          result.caller = fun->id;
+          results.push_back(result);
+        }
+
+        if (memo[key].folded) {
+          factor->value = memo[key].value;
+          factor->call.reset();
+          folded = changed = true;
+        }
+      }
+      if (folded) foldConstants(fun->compoundStatement.get());
+    }
+  }
+  return results;
+}
@@ -0,0 +1,38 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de la evaluación de llamadas en tiempo de
+ *  compilación.
+ * */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+
+// Nodos que el evaluador puede visitar por llamada antes de rendirse;
+// -fconstexpr-steps lo cambia y 0 lo desactiva.
+constexpr long long CTFE_STEP_BUDGET = 1000000;
+// Llamadas anidadas como máximo, para no agotar el stack del compilador.
+constexpr int CTFE_MAX_DEPTH = 1000;
+
+struct EvaluatedCall {
+  // Función donde está la llamada.
+  std::string caller;
+  // La llamada como aparece en el código, como "fib(20)".
+  std::string call;
+  bool folded;
+  int value;
+  long long steps;
+  // Por qué no se pudo evaluar, si no se pudo.
+  std::string reason;
+};
+
+// Evalúa sobre el árbol las llamadas a funciones puras con argumentos
+// literales y cambia cada una por su resultado. La evaluación se rinde (y la
+// llamada se queda) si la función lee un global, hace entrada o salida, se
+// sale de un arreglo, lee algo sin inicializar, divide entre cero o se pasa
+// de budget pasos.
+std::vector<EvaluatedCall> evaluateConstantCalls(
+    ProgramNode* program, const std::vector<std::string>& pure,
+    long long budget);
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de la eliminación de código muerto.
+ * */
+#include "dce.hpp"
+
+#include <set>
+#include <vector>
+
+#include "cfg.hpp"
+#include "mips.hpp"
+
+static bool isRemovable(const Instruction& inst, const MachineFunction& fn) {
+  if (inst.op == Op::SW) return Location::isFrameSlot(inst, fn);
+  return !Mips::hasSideEffects(inst);
+}
+
+static int eraseMarked(MachineFunction& fn, const std::vector<bool>& dead) {
+  std::vector<Instruction> kept;
+  int removed = 0;
+  for (int i = 0; i < (int)fn.code.size(); ++i) {
+    if (dead[i]) {
+      if (!fn.code[i].isLabel() && !fn.code[i].isComment()) removed++;
+    } else {
+      kept.push_back(fn.code[i]);
+    }
+  }
+  fn.code = std::move(kept);
+  return removed;
+}
+
+int removeUnreachableBlocks(MachineFunction& fn) {
+  ControlFlowGraph cfg(fn);
+  std::vector<bool> seen = cfg.reachable();
+  std::vector<bool> dead(fn.code.size(), false);
+  for (int b = 0; b < (int)cfg.blocks.size(); ++b) {
+    // La etiqueta de salida se queda aunque no se llegue a ella, porque el
+    // epílogo se coloca después de ella.
+    if (seen[b] || b == cfg.exitBlock) continue;
+    for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+      dead[i] = true;
+    }
+  }
+  return eraseMarked(fn, dead);
+}
+
+int eliminateDeadCode(MachineFunction& fn) {
+  int total = removeUnreachableBlocks(fn);
+
+  while (true) {
+    ControlFlowGraph cfg(fn);
+    computeLiveness(fn, cfg);
+
+    std::vector<bool> dead(fn.code.size(), false);
+    bool any = false;
+    for (auto& block : cfg.blocks) {
+      std::set<int> live = block.liveOut;
+      for (int i = block.end - 1; i >= block.begin; --i) {
+        const Instruction& inst = fn.code[i];
+        std::vector<int> defs = Location::defs(inst, fn);
+        bool needed = !isRemovable(inst, fn) || defs.empty();
+        for (int d : defs) {
+          if (live.count(d)) needed = true;
+        }
+        if (!needed) {
+          dead[i] = true;
+          any = true;
+          continue;
+        }
+        for (int d : defs) live.erase(d);
+        for (int u : Location::uses(inst, fn)) live.insert(u);
+      }
+    }
+
+    if (!any) break;
+    total += eraseMarked(fn, dead);
+  }
+  return total;
+}
@@ -0,0 +1,16 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de la eliminación de código muerto.
+ * */
+#pragma once
+
+#include "mips.hpp"
+
+// Borra los bloques a los que no se puede llegar desde la entrada de la
+// función. Regresa cuántas instrucciones se eliminaron.
+int removeUnreachableBlocks(MachineFunction& fn);
+
+// Borra las instrucciones sin efectos secundarios cuyo resultado nunca se lee
+// y los sw a slots escalares del frame que no se vuelven a leer. Itera hasta
+// que ya no hay cambios y regresa cuántas instrucciones se eliminaron.
+int eliminateDeadCode(MachineFunction& fn);
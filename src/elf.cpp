@@ -0,0 +1,270 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del escritor de ejecutables ELF.
+ * */
+#include "elf.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "encoder.hpp"
+
+namespace {
+
+// Constantes del formato que se usan aquí (ver elf(5)).
+enum : uint32_t {
+  ET_EXEC = 2,
+  EM_MIPS = 8,
+  // MIPS32 con el ABI o32.
+  EF_MIPS_FLAGS = 0x50001000,
+  PT_LOAD = 1,
+  PF_X = 1,
+  PF_W = 2,
+  PF_R = 4,
+  SHT_PROGBITS = 1,
+  SHT_SYMTAB = 2,
+  SHT_STRTAB = 3,
+  SHF_WRITE = 1,
+  SHF_ALLOC = 2,
+  SHF_EXECINSTR = 4,
+  SHF_MIPS_GPREL = 0x10000000,
+  STB_LOCAL = 0,
+  STB_GLOBAL = 1,
+  STT_NOTYPE = 0,
+  STT_OBJECT = 1,
+  STT_FUNC = 2,
+  SHN_ABS = 0xfff1,
+  ELF_HEADER_SIZE = 52,
+  PROGRAM_HEADER_SIZE = 32,
+  SECTION_HEADER_SIZE = 40,
+  SYMBOL_SIZE = 16,
+  ELF_PAGE = 0x1000,
+};
+
+// Índices de las secciones en la tabla.
+enum ElfSection {
+  SEC_NULL,
+  SEC_TEXT,
+  SEC_SDATA,
+  SEC_DATA,
+  SEC_SYMTAB,
+  SEC_STRTAB,
+  SEC_SHSTRTAB,
+  SEC_COUNT
+};
+
+// Un buffer donde todo se escribe big-endian.
+class ElfBuffer {
+ public:
+  std::vector<uint8_t> bytes;
+
+  void u8(uint8_t value) { bytes.push_back(value); }
+  void u16(uint16_t value) {
+    u8(value >> 8);
+    u8(value);
+  }
+  void u32(uint32_t value) {
+    u16(value >> 16);
+    u16(value);
+  }
+  void append(const std::vector<uint8_t>& data) {
+    bytes.insert(bytes.end(), data.begin(), data.end());
+  }
+  void align(size_t boundary) {
+    while (bytes.size() % boundary) u8(0);
+  }
+  uint32_t size() const { return bytes.size(); }
+};
+
+// Una tabla de strings de ELF: empieza con un byte cero y cada nombre
+// termina en cero.
+class StringTable {
+ public:
+  std::vector<uint8_t> bytes{0};
+
+  uint32_t add(const std::string& name) {
+    uint32_t at = bytes.size();
+    bytes.insert(bytes.end(), name.begin(), name.end());
+    bytes.push_back(0);
+    return at;
+  }
+};
+
+struct SectionHeader {
+  uint32_t name = 0, type = 0, flags = 0, addr = 0, offset = 0, size = 0,
+           link = 0, info = 0, addralign = 0, entsize = 0;
+};
+
+}  // namespace
+
+// La tabla de símbolos: primero los locales, como pide el formato, y al
+// final __start, main y _gp. Regresa el índice del primer global.
+static uint32_t buildSymbols(const ObjectCode& object, ElfBuffer& symtab,
+                             StringTable& strtab) {
+  uint32_t textEnd = TEXT_BASE + 4 * object.text.size();
+  std::set<std::string> functions(object.functions.begin(),
+                                  object.functions.end());
+  const std::set<std::string> globals = {"__start", "main"};
+
+  std::vector<std::pair<uint32_t, std::string>> ordered;
+  for (const auto& [name, address] : object.symbols) {
+    ordered.push_back({address, name});
+  }
+  std::stable_sort(ordered.begin(), ordered.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.first < b.first;
+                   });
+
+  auto symbol = [&](const std::string& name, uint32_t value, uint8_t bind,
+                    uint8_t type, uint16_t section) {
+    symtab.u32(strtab.add(name));
+    symtab.u32(value);
+    symtab.u32(0);
+    symtab.u8((bind << 4) | type);
+    symtab.u8(0);
+    symtab.u16(section);
+  };
+  auto classify = [&](const std::string& name, uint32_t address,
+                      uint8_t bind) {
+    if (address >= TEXT_BASE && address <= textEnd) {
+      uint8_t type = functions.count(name) ? STT_FUNC : STT_NOTYPE;
+      symbol(name, address, bind, type, SEC_TEXT);
+    } else {
+      symbol(name, address, bind, STT_OBJECT,
+             address < object.dataBase ? SEC_SDATA : SEC_DATA);
+    }
+  };
+
+  // El símbolo 0 siempre es nulo.
+  for (int i = 0; i < (int)SYMBOL_SIZE; ++i) symtab.u8(0);
+  uint32_t count = 1;
+  for (const auto& [address, name] : ordered) {
+    if (globals.count(name)) continue;
+    classify(name, address, STB_LOCAL);
+    count++;
+  }
+  uint32_t firstGlobal = count;
+  for (const auto& [address, name] : ordered) {
+    if (globals.count(name)) classify(name, address, STB_GLOBAL);
+  }
+  symbol("_gp", GP_VALUE, STB_GLOBAL, STT_NOTYPE, SHN_ABS);
+  return firstGlobal;
+}
+
+bool writeElf(const std::string& path, const ObjectCode& object) {
+  ElfBuffer file;
+  SectionHeader sections[SEC_COUNT];
+  StringTable names;
+  const char* sectionNames[SEC_COUNT] = {
+      "", ".text", ".sdata", ".data", ".symtab", ".strtab", ".shstrtab"};
+  auto describe = [&](ElfSection index, uint32_t type, uint32_t flags,
+                      uint32_t addr, uint32_t offset, uint32_t size,
+                      uint32_t align) {
+    sections[index] = {names.add(sectionNames[index]),
+                       type,
+                       flags,
+                       addr,
+                       offset,
+                       size,
+                       0,
+                       0,
+                       align,
+                       0};
+  };
+
+  // Los encabezados se llenan al final; aquí solo se reserva su espacio.
+  file.bytes.resize(ELF_HEADER_SIZE + 2 * PROGRAM_HEADER_SIZE);
+
+  // Los segmentos empiezan en páginas para que el desplazamiento en el
+  // archivo coincida con la dirección módulo el tamaño de página.
+  file.align(ELF_PAGE);
+  uint32_t textOffset = file.size();
+  for (uint32_t word : object.text) file.u32(word);
+  uint32_t textSize = file.size() - textOffset;
+  describe(SEC_TEXT, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, TEXT_BASE,
+           textOffset, textSize, 4);
+
+  file.align(ELF_PAGE);
+  uint32_t dataOffset = file.size();
+  file.append(object.sdata);
+  file.append(object.data);
+  uint32_t dataSize = file.size() - dataOffset;
+  describe(SEC_SDATA, SHT_PROGBITS, SHF_ALLOC | SHF_WRITE | SHF_MIPS_GPREL,
+           SDATA_BASE, dataOffset, object.sdata.size(), 4);
+  describe(SEC_DATA, SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, object.dataBase,
+           dataOffset + object.sdata.size(), object.data.size(), 4);
+
+  ElfBuffer symtab;
+  StringTable strtab;
+  uint32_t firstGlobal = buildSymbols(object, symtab, strtab);
+  file.align(4);
+  describe(SEC_SYMTAB, SHT_SYMTAB, 0, 0, file.size(), symtab.size(), 4);
+  sections[SEC_SYMTAB].link = SEC_STRTAB;
+  sections[SEC_SYMTAB].info = firstGlobal;
+  sections[SEC_SYMTAB].entsize = SYMBOL_SIZE;
+  file.append(symtab.bytes);
+  describe(SEC_STRTAB, SHT_STRTAB, 0, 0, file.size(), strtab.bytes.size(), 1);
+  file.append(strtab.bytes);
+  // El nombre de .shstrtab se agrega antes de medirla.
+  uint32_t shstrtabName = names.add(sectionNames[SEC_SHSTRTAB]);
+  sections[SEC_SHSTRTAB] = {shstrtabName, SHT_STRTAB, 0, 0, file.size(),
+                            (uint32_t)names.bytes.size(), 0, 0, 1, 0};
+  file.append(names.bytes);
+
+  file.align(4);
+  uint32_t sectionOffset = file.size();
+  for (const auto& section : sections) {
+    file.u32(section.name);
+    file.u32(section.type);
+    file.u32(section.flags);
+    file.u32(section.addr);
+    file.u32(section.offset);
+    file.u32(section.size);
+    file.u32(section.link);
+    file.u32(section.info);
+    file.u32(section.addralign);
+    file.u32(section.entsize);
+  }
+
+  ElfBuffer header;
+  // "\x7fELF", 32 bits, big-endian, versión 1.
+  for (int byte : {0x7f, 0x45, 0x4c, 0x46, 1, 2, 1}) header.u8(byte);
+  while (header.size() < 16) header.u8(0);
+  header.u16(ET_EXEC);
+  header.u16(EM_MIPS);
+  header.u32(1);
+  header.u32(object.entry);
+  header.u32(ELF_HEADER_SIZE);
+  header.u32(sectionOffset);
+  header.u32(EF_MIPS_FLAGS);
+  header.u16(ELF_HEADER_SIZE);
+  header.u16(PROGRAM_HEADER_SIZE);
+  header.u16(2);
+  header.u16(SECTION_HEADER_SIZE);
+  header.u16(SEC_COUNT);
+  header.u16(SEC_SHSTRTAB);
+  auto segment = [&](uint32_t offset, uint32_t address, uint32_t size,
+                     uint32_t flags) {
+    header.u32(PT_LOAD);
+    header.u32(offset);
+    header.u32(address);
+    header.u32(address);
+    header.u32(size);
+    header.u32(size);
+    header.u32(flags);
+    header.u32(ELF_PAGE);
+  };
+  segment(textOffset, TEXT_BASE, textSize, PF_R | PF_X);
+  segment(dataOffset, SDATA_BASE, dataSize, PF_R | PF_W);
+  std::copy(header.bytes.begin(), header.bytes.end(), file.bytes.begin());
+
+  std::ofstream out(path, std::ios::binary);
+  if (!out) return false;
+  out.write(reinterpret_cast<const char*>(file.bytes.data()), file.size());
+  return (bool)out;
+}
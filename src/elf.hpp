@@ -0,0 +1,16 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del escritor de ejecutables ELF.
+ * */
+#pragma once
+
+#include <string>
+
+#include "encoder.hpp"
+
+// Escribe un ejecutable ELF32 big-endian para MIPS32 con secciones .text,
+// .sdata y .data, una tabla de símbolos con las etiquetas y _gp, y dos
+// segmentos cargables (código y datos). El programa usa las syscalls de
+// SPIM, así que corre en un simulador que las entienda. Regresa false si no
+// se pudo escribir el archivo.
+bool writeElf(const std::string& path, const ObjectCode& object);
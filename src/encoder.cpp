@@ -0,0 +1,367 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del codificador de instrucciones MIPS a
+ *  código máquina.
+ * */
+#include "encoder.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mips.hpp"
+
+namespace {
+
+// Una palabra con un campo que depende de una etiqueta; se llena cuando ya
+// se conocen todas las direcciones.
+struct Fixup {
+  enum Kind { BRANCH, JUMP, HI, LO, GP } kind;
+  int index;
+  std::string label;
+  int addend;
+};
+
+// Campos de opcode (bits 31-26) y funct (bits 5-0).
+enum : uint32_t {
+  SPECIAL = 0x00,
+  REGIMM = 0x01,
+  SPECIAL2 = 0x1c,
+  OP_J = 0x02,
+  OP_JAL = 0x03,
+  OP_BEQ = 0x04,
+  OP_BNE = 0x05,
+  OP_BLEZ = 0x06,
+  OP_BGTZ = 0x07,
+  OP_ADDIU = 0x09,
+  OP_SLTIU = 0x0b,
+  OP_ORI = 0x0d,
+  OP_XORI = 0x0e,
+  OP_LUI = 0x0f,
+  OP_LW = 0x23,
+  OP_SW = 0x2b,
+  FN_SLL = 0x00,
+  FN_SRL = 0x02,
+  FN_SRA = 0x03,
+  FN_JR = 0x08,
+  FN_SYSCALL = 0x0c,
+  FN_MFHI = 0x10,
+  FN_MFLO = 0x12,
+  FN_MULT = 0x18,
+  FN_DIV = 0x1a,
+  FN_ADD = 0x20,
+  FN_ADDU = 0x21,
+  FN_SUB = 0x22,
+  FN_SUBU = 0x23,
+  FN_XOR = 0x26,
+  FN_SLT = 0x2a,
+  FN_SLTU = 0x2b,
+  FN_MUL = 0x02,
+};
+
+class Encoder {
+ public:
+  explicit Encoder(ObjectCode& object) : object(object) {}
+
+  void encode(const Instruction& inst);
+  void resolve();
+
+ private:
+  ObjectCode& object;
+  std::vector<Fixup> fixups;
+
+  uint32_t here() const { return TEXT_BASE + 4 * object.text.size(); }
+
+  void word(uint32_t value) { object.text.push_back(value); }
+
+  void rType(uint32_t rs, uint32_t rt, uint32_t rd, uint32_t shamt,
+             uint32_t funct) {
+    word((SPECIAL << 26) | (rs << 21) | (rt << 16) | (rd << 11) |
+         (shamt << 6) | funct);
+  }
+
+  void iType(uint32_t opcode, uint32_t rs, uint32_t rt, int imm) {
+    word((opcode << 26) | (rs << 21) | (rt << 16) | (imm & 0xffff));
+  }
+
+  void fixup(Fixup::Kind kind, const std::string& label, int addend = 0) {
+    fixups.push_back({kind, (int)object.text.size() - 1, label, addend});
+  }
+
+  // li: el valor se arma en el mismo reg, sin tocar $at.
+  void loadConstant(int reg, int value) {
+    if (value >= -32768 && value <= 32767) {
+      iType(OP_ADDIU, Reg::ZERO, reg, value);
+    } else if (value >= 0 && value <= 65535) {
+      iType(OP_ORI, Reg::ZERO, reg, value);
+    } else {
+      iType(OP_LUI, 0, reg, (uint32_t)value >> 16);
+      if (value & 0xffff) iType(OP_ORI, reg, reg, value & 0xffff);
+    }
+  }
+
+  // lw o sw con un desplazamiento de más de 16 bits: la parte alta se suma
+  // a la base en $at. encode ya revisó que ni la base ni el valor de un sw
+  // sean $at.
+  void memory(uint32_t opcode, int reg, int base, int offset) {
+    if (offset >= -32768 && offset <= 32767) {
+      iType(opcode, base, reg, offset);
+      return;
+    }
+    int high = (int)(((int64_t)offset + 0x8000) >> 16);
+    iType(OP_LUI, 0, Reg::AT, high);
+    rType(Reg::AT, base, Reg::AT, 0, FN_ADDU);
+    iType(opcode, Reg::AT, reg, offset - high * 65536);
+  }
+};
+
+}  // namespace
+
+static uint32_t functFor(Op op) {
+  switch (op) {
+    case Op::ADD:
+      return FN_ADD;
+    case Op::ADDU:
+      return FN_ADDU;
+    case Op::SUB:
+      return FN_SUB;
+    case Op::SUBU:
+      return FN_SUBU;
+    case Op::XOR:
+      return FN_XOR;
+    case Op::SLT:
+      return FN_SLT;
+    case Op::SLTU:
+      return FN_SLTU;
+    case Op::MULT:
+      return FN_MULT;
+    case Op::DIV:
+      return FN_DIV;
+    case Op::MFHI:
+      return FN_MFHI;
+    case Op::MFLO:
+      return FN_MFLO;
+    case Op::SLL:
+      return FN_SLL;
+    case Op::SRL:
+      return FN_SRL;
+    default:
+      return FN_SRA;
+  }
+}
+
+void Encoder::encode(const Instruction& inst) {
+  // La expansión arma el inmediato o la dirección en $at antes de leer los
+  // operandos, así que si alguno es $at ya se perdió.
+  if (Mips::usesAssemblerTemporary(inst)) {
+    std::vector<int> uses = Mips::uses(inst);
+    if (std::count(uses.begin(), uses.end(), Reg::AT)) {
+      std::string text = Mips::toString(inst);
+      text.erase(0, text.find_first_not_of(' '));
+      object.errors.push_back("$at se usa en " + text +
+                              ", que lo necesita para expandirse");
+      return;
+    }
+  }
+
+  switch (inst.op) {
+    case Op::LABEL:
+      if (!object.symbols.emplace(inst.label, here()).second) {
+        object.errors.push_back("etiqueta repetida " + inst.label);
+      }
+      return;
+    case Op::COMMENT:
+      return;
+    case Op::ADD:
+    case Op::ADDU:
+    case Op::SUB:
+    case Op::SUBU:
+    case Op::XOR:
+    case Op::SLT:
+    case Op::SLTU:
+      rType(inst.rs, inst.rt, inst.rd, 0, functFor(inst.op));
+      return;
+    case Op::MUL:
+      word((SPECIAL2 << 26) | (inst.rs << 21) | (inst.rt << 16) |
+           (inst.rd << 11) | FN_MUL);
+      return;
+    case Op::MULT:
+    case Op::DIV:
+      rType(inst.rs, inst.rt, 0, 0, functFor(inst.op));
+      return;
+    case Op::MFHI:
+    case Op::MFLO:
+      rType(0, 0, inst.rd, 0, functFor(inst.op));
+      return;
+    case Op::ADDIU:
+      if (!inst.label.empty()) {
+        iType(OP_ADDIU, inst.rs, inst.rd, 0);
+        fixup(Fixup::GP, inst.label, inst.imm);
+      } else if (inst.imm >= -32768 && inst.imm <= 32767) {
+        iType(OP_ADDIU, inst.rs, inst.rd, inst.imm);
+      } else {
+        loadConstant(Reg::AT, inst.imm);
+        rType(inst.rs, Reg::AT, inst.rd, 0, FN_ADDU);
+      }
+      return;
+    case Op::XORI:
+      if (inst.imm >= 0 && inst.imm <= 65535) {
+        iType(OP_XORI, inst.rs, inst.rd, inst.imm);
+      } else {
+        loadConstant(Reg::AT, inst.imm);
+        rType(inst.rs, Reg::AT, inst.rd, 0, FN_XOR);
+      }
+      return;
+    case Op::SLTIU:
+      if (inst.imm >= -32768 && inst.imm <= 32767) {
+        iType(OP_SLTIU, inst.rs, inst.rd, inst.imm);
+      } else {
+        loadConstant(Reg::AT, inst.imm);
+        rType(inst.rs, Reg::AT, inst.rd, 0, FN_SLTU);
+      }
+      return;
+    case Op::SLL:
+    case Op::SRL:
+    case Op::SRA:
+      rType(0, inst.rs, inst.rd, inst.imm & 31, functFor(inst.op));
+      return;
+    case Op::LI:
+      loadConstant(inst.rd, inst.imm);
+      return;
+    case Op::LA:
+      iType(OP_LUI, 0, inst.rd, 0);
+      fixup(Fixup::HI, inst.label);
+      iType(OP_ORI, inst.rd, inst.rd, 0);
+      fixup(Fixup::LO, inst.label);
+      return;
+    case Op::MOVE:
+      rType(inst.rs, Reg::ZERO, inst.rd, 0, FN_ADDU);
+      return;
+    case Op::LW:
+    case Op::SW: {
+      uint32_t opcode = inst.op == Op::LW ? OP_LW : OP_SW;
+      int reg = inst.op == Op::LW ? inst.rd : inst.rt;
+      if (!inst.label.empty()) {
+        iType(opcode, inst.rs, reg, 0);
+        fixup(Fixup::GP, inst.label, inst.imm);
+      } else {
+        memory(opcode, reg, inst.rs, inst.imm);
+      }
+      return;
+    }
+    case Op::BEQ:
+    case Op::BNE:
+      iType(inst.op == Op::BEQ ? OP_BEQ : OP_BNE, inst.rs, inst.rt, 0);
+      fixup(Fixup::BRANCH, inst.label);
+      return;
+    case Op::BLEZ:
+    case Op::BGTZ:
+      iType(inst.op == Op::BLEZ ? OP_BLEZ : OP_BGTZ, inst.rs, 0, 0);
+      fixup(Fixup::BRANCH, inst.label);
+      return;
+    case Op::BLTZ:
+    case Op::BGEZ:
+      // Con REGIMM el campo rt dice cuál branch es.
+      iType(REGIMM, inst.rs, inst.op == Op::BGEZ ? 1 : 0, 0);
+      fixup(Fixup::BRANCH, inst.label);
+      return;
+    case Op::J:
+    case Op::JAL:
+    case Op::TAILCALL:
+      word((inst.op == Op::JAL ? OP_JAL : OP_J) << 26);
+      fixup(Fixup::JUMP, inst.label);
+      return;
+    case Op::JR:
+      rType(inst.rs, 0, 0, 0, FN_JR);
+      return;
+    case Op::SYSCALL:
+      rType(0, 0, 0, 0, FN_SYSCALL);
+      return;
+    case Op::NOP:
+      word(0);
+      return;
+    case Op::CHECK:
+      object.errors.push_back("revisión de rango sin bajar");
+      return;
+  }
+}
+
+void Encoder::resolve() {
+  for (const auto& fix : fixups) {
+    auto it = object.symbols.find(fix.label);
+    if (it == object.symbols.end()) {
+      object.errors.push_back("la etiqueta " + fix.label + " no existe");
+      continue;
+    }
+    uint32_t target = it->second + fix.addend;
+    uint32_t pc = TEXT_BASE + 4 * fix.index;
+    uint32_t& inst = object.text[fix.index];
+    switch (fix.kind) {
+      case Fixup::BRANCH: {
+        int64_t offset = ((int64_t)target - (pc + 4)) / 4;
+        if (offset < -32768 || offset > 32767) {
+          object.errors.push_back("branch a " + fix.label + " fuera de rango");
+        }
+        inst |= offset & 0xffff;
+        break;
+      }
+      case Fixup::JUMP:
+        // j y jal solo cambian los 28 bits bajos del pc.
+        if ((target & 0xf0000000) != ((pc + 4) & 0xf0000000)) {
+          object.errors.push_back("salto a " + fix.label + " fuera de rango");
+        }
+        inst |= (target >> 2) & 0x03ffffff;
+        break;
+      case Fixup::HI:
+        inst |= target >> 16;
+        break;
+      case Fixup::LO:
+        inst |= target & 0xffff;
+        break;
+      case Fixup::GP: {
+        int64_t offset = (int64_t)target - GP_VALUE;
+        if (offset < -32768 || offset > 32767) {
+          object.errors.push_back(fix.label + " está fuera del alcance de $gp");
+        }
+        inst |= offset & 0xffff;
+        break;
+      }
+    }
+  }
+}
+
+// Acomoda los objetos uno tras otro, alineados a palabra, y registra sus
+// direcciones.
+static void layoutData(const std::vector<DataObject>& data, bool small,
+                       uint32_t base, std::vector<uint8_t>& bytes,
+                       ObjectCode& object) {
+  for (const auto& item : data) {
+    if (item.small != small) continue;
+    while (bytes.size() % 4) bytes.push_back(0);
+    object.symbols[item.label] = base + bytes.size();
+    size_t end = bytes.size() + std::max<size_t>(item.size,
+                                                 item.contents.size());
+    bytes.insert(bytes.end(), item.contents.begin(), item.contents.end());
+    bytes.resize(end, 0);
+  }
+  while (bytes.size() % 4) bytes.push_back(0);
+}
+
+ObjectCode encodeProgram(const std::vector<Instruction>& text,
+                         const std::vector<DataObject>& data) {
+  ObjectCode object;
+  layoutData(data, true, SDATA_BASE, object.sdata, object);
+  object.dataBase = SDATA_BASE + object.sdata.size();
+  layoutData(data, false, object.dataBase, object.data, object);
+
+  Encoder encoder(object);
+  // El arranque: SPIM ya pone $gp, aquí lo hace el programa.
+  encoder.encode(Mips::label("__start"));
+  object.functions.push_back("__start");
+  encoder.encode(Mips::li(Reg::GP, GP_VALUE));
+  for (const auto& inst : text) encoder.encode(inst);
+  encoder.resolve();
+  object.entry = TEXT_BASE;
+  return object;
+}
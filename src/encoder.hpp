@@ -0,0 +1,55 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del codificador de instrucciones MIPS a código
+ *  máquina.
+ * */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mips.hpp"
+
+// El mismo mapa de memoria que usa SPIM: el código empieza en TEXT_BASE, los
+// globales chicos en SDATA_BASE y $gp apunta 32 KB adentro para alcanzarlos
+// con un desplazamiento de 16 bits. Los demás datos van después.
+constexpr uint32_t TEXT_BASE = 0x00400000;
+constexpr uint32_t SDATA_BASE = 0x10000000;
+constexpr uint32_t GP_VALUE = 0x10008000;
+
+// Un objeto de la sección de datos: espacio en ceros o un string.
+struct DataObject {
+  std::string label;
+  int size = 0;
+  // Los bytes iniciales; si está vacío el objeto empieza en ceros.
+  std::string contents;
+  // Va en .sdata, al alcance de $gp.
+  bool small = false;
+};
+
+struct ObjectCode {
+  std::vector<uint32_t> text;
+  std::vector<uint8_t> sdata;
+  std::vector<uint8_t> data;
+  uint32_t dataBase = 0;
+  uint32_t entry = TEXT_BASE;
+  // Dirección de cada etiqueta del código y de los datos.
+  std::map<std::string, uint32_t> symbols;
+  // Etiquetas de funciones, para marcarlas como tales en la tabla de
+  // símbolos.
+  std::vector<std::string> functions;
+  // Lo que no se pudo codificar (etiquetas que no existen, saltos fuera de
+  // alcance, expansiones que pisarían un operando en $at); si hay algo el
+  // objeto no sirve.
+  std::vector<std::string> errors;
+};
+
+// Codifica las instrucciones en formato R, I y J. Las pseudo-instrucciones
+// se expanden como lo haría el ensamblador (li y la a lui + ori, move a
+// addu, inmediatos que no caben en 16 bits a través de $at). Las etiquetas
+// se resuelven en una segunda vuelta con una tabla de fixups. Antes del
+// código va un arranque que pone $gp y cae en main.
+ObjectCode encodeProgram(const std::vector<Instruction>& text,
+                         const std::vector<DataObject>& data);
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del acomodo de las variables globales.
+ * */
+#include "globals.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "astutil.hpp"
+
+namespace {
+
+class UseCounter {
+ public:
+  std::unordered_map<std::string, long long> uses;
+  // Nombres que la función actual declara como locales o parámetros.
+  std::unordered_set<std::string> shadowed;
+
+  void countExpression(ExpressionNode* expr, long long weight) {
+    forEachExpression(expr, [&](ExpressionNode* e) {
+      VarNode* var = nullptr;
+      if (auto factor = dynamic_cast<FactorNode*>(e)) var = factor->var.get();
+      if (auto assign = dynamic_cast<AssignmentExpressionNode*>(e)) {
+        var = assign->var.get();
+      }
+      if (var && !shadowed.count(var->id)) uses[var->id] += weight;
+    });
+  }
+
+  void countStatement(StatementNode* stmt, long long weight) {
+    if (!stmt) return;
+    if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+      for (auto& var : comp->vars) shadowed.insert(var->id);
+      for (auto& child : comp->statements) countStatement(child.get(), weight);
+    } else if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+      countExpression(sel->condition.get(), weight);
+      countStatement(sel->statement.get(), weight);
+      countStatement(sel->elseStatement.get(), weight);
+    } else if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+      long long inner = std::min(weight * 8, 1LL << 40);
+      countExpression(iter->expression.get(), inner);
+      countStatement(iter->statement.get(), inner);
+    } else if (auto expr = dynamic_cast<ExpressionStatementNode*>(stmt)) {
+      countExpression(expr->expression.get(), weight);
+    } else if (auto ret = dynamic_cast<ReturnStatementNode*>(stmt)) {
+      countExpression(ret->expression.get(), weight);
+    }
+  }
+};
+
+}  // namespace
+
+GlobalLayout layoutGlobals(ProgramNode* program, int smallLimit) {
+  UseCounter counter;
+  std::vector<VarDeclarationNode*> globals;
+  std::unordered_set<std::string> seen;
+  for (auto& decl : program->declarationList) {
+    if (auto var = dynamic_cast<VarDeclarationNode*>(decl.get())) {
+      if (seen.insert(var->id).second) globals.push_back(var);
+    } else if (auto fun = dynamic_cast<FunDeclarationNode*>(decl.get())) {
+      counter.shadowed.clear();
+      for (auto& param : fun->params) counter.shadowed.insert(param->id);
+      counter.countStatement(fun->compoundStatement.get(), 1);
+    }
+  }
+
+  // Orden estable: a igual número de usos se respeta el de declaración.
+  std::stable_sort(globals.begin(), globals.end(),
+                   [&](VarDeclarationNode* a, VarDeclarationNode* b) {
+                     return counter.uses[a->id] > counter.uses[b->id];
+                   });
+
+  GlobalLayout layout;
+  int used = 0;
+  for (auto* var : globals) {
+    int bytes = 4 * (var->arraySize ? *var->arraySize : 1);
+    if (bytes <= smallLimit && used + bytes <= SMALL_DATA_CAPACITY) {
+      layout.small.push_back(var);
+      layout.smallNames.insert(var->id);
+      used += bytes;
+    } else {
+      layout.large.push_back(var);
+    }
+  }
+  return layout;
+}
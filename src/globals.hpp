@@ -0,0 +1,33 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del acomodo de las variables globales.
+ * */
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "parser.hpp"
+
+// Globales de este tamaño en bytes o menos van en .sdata (como -G de gcc).
+// Por omisión ninguno: SPIM y MARS no aceptan %gp_rel, así que .sdata solo
+// se usa con -G para ensambladores que lo entienden o con -felf.
+constexpr int SMALL_DATA_DEFAULT = 0;
+// .sdata tiene que caber en lo que alcanza un desplazamiento de 16 bits
+// desde $gp.
+constexpr int SMALL_DATA_CAPACITY = 65536;
+
+struct GlobalLayout {
+  // Ordenados de más a menos usados.
+  std::vector<VarDeclarationNode*> small;
+  std::vector<VarDeclarationNode*> large;
+  std::unordered_set<std::string> smallNames;
+
+  bool isSmall(const std::string& id) const { return smallNames.count(id); }
+};
+
+// Cuenta cuántas veces se usa cada global (cada nivel de loop pesa 8 veces
+// más) y pone en .sdata los de hasta smallLimit bytes, empezando por los más
+// usados, mientras quepan. Lo que queda va en .data.
+GlobalLayout layoutGlobals(ProgramNode* program, int smallLimit);
@@ -0,0 +1,141 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del inlining de funciones.
+ * */
+#include "inline.hpp"
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mips.hpp"
+
+static int inlineCounter = 0;
+
+static std::string calleeName(const Instruction& inst) {
+  // Los jal apuntan a <función>_entry.
+  const std::string suffix = "_entry";
+  return inst.label.substr(0, inst.label.size() - suffix.size());
+}
+
+static int codeSize(const MachineFunction& fn) {
+  int size = 0;
+  for (const auto& inst : fn.code) {
+    if (!inst.isLabel() && !inst.isComment()) size++;
+  }
+  return size;
+}
+
+// Si no se puede copiar la función sin su frame regresa por qué.
+static std::string cannotInline(const MachineFunction& fn) {
+  if (fn.name == "main") return "es main";
+  if (fn.stackParams() > 0) return "recibe argumentos en el stack";
+  if (fn.localsSize > 0) return "tiene arreglos locales";
+  for (const auto& inst : fn.code) {
+    if (inst.op == Op::TAILCALL) return "termina en una llamada de cola";
+  }
+  return "";
+}
+
+// Copia el cuerpo de callee en lugar del jal. Los registros virtuales se
+// recorren para no chocar con los del caller y las etiquetas llevan un
+// sufijo nuevo.
+static std::vector<Instruction> expand(MachineFunction& caller,
+                                       const MachineFunction& callee) {
+  std::string suffix = "_inl" + std::to_string(inlineCounter++);
+  int shift = caller.nextVirtual - Reg::VIRTUAL;
+  caller.nextVirtual += callee.nextVirtual - Reg::VIRTUAL;
+
+  std::vector<Instruction> body;
+  for (Instruction inst : callee.code) {
+    for (int* reg : {&inst.rd, &inst.rs, &inst.rt}) {
+      if (Mips::isVirtual(*reg)) *reg += shift;
+    }
+    if (inst.isLabel() || inst.hasTarget()) inst.label += suffix;
+    body.push_back(inst);
+  }
+  return body;
+}
+
+std::vector<InlineDecision> inlineFunctions(
+    std::vector<MachineFunction>& functions) {
+  std::map<std::string, MachineFunction*> byName;
+  for (auto& fn : functions) byName[fn.name] = &fn;
+
+  // Call graph y número de llamadas a cada función.
+  std::map<std::string, std::set<std::string>> calls;
+  std::map<std::string, int> callSites;
+  for (auto& fn : functions) {
+    for (const auto& inst : fn.code) {
+      if (inst.op == Op::JAL || inst.op == Op::TAILCALL) {
+        calls[fn.name].insert(calleeName(inst));
+        callSites[calleeName(inst)]++;
+      }
+    }
+  }
+
+  // Una función es recursiva si puede llegar a sí misma en el call graph.
+  auto reaches = [&](const std::string& from, const std::string& to) {
+    std::set<std::string> seen;
+    std::vector<std::string> stack = {from};
+    while (!stack.empty()) {
+      std::string name = stack.back();
+      stack.pop_back();
+      for (const auto& next : calls[name]) {
+        if (next == to) return true;
+        if (seen.insert(next).second) stack.push_back(next);
+      }
+    }
+    return false;
+  };
+
+  // Orden de las hojas hacia arriba.
+  std::vector<MachineFunction*> order;
+  std::set<std::string> visited;
+  std::function<void(const std::string&)> visit = [&](const std::string& name) {
+    if (!byName.count(name) || !visited.insert(name).second) return;
+    for (const auto& next : calls[name]) visit(next);
+    order.push_back(byName[name]);
+  };
+  for (auto& fn : functions) visit(fn.name);
+
+  std::vector<InlineDecision> decisions;
+  for (MachineFunction* caller : order) {
+    std::vector<Instruction> code;
+    int callerSize = codeSize(*caller);
+    for (const auto& inst : caller->code) {
+      if (inst.op != Op::JAL || !byName.count(calleeName(inst))) {
+        code.push_back(inst);
+        continue;
+      }
+      const MachineFunction& callee = *byName[calleeName(inst)];
+      int size = codeSize(callee);
+      std::string reason = cannotInline(callee);
+      if (reason.empty() && reaches(callee.name, callee.name)) {
+        reason = "es recursiva";
+      } else if (reason.empty() && callerSize + size > INLINE_CALLER_LIMIT) {
+        reason = caller->name + " ya es muy grande";
+      } else if (reason.empty() && size > INLINE_SMALL_SIZE &&
+                 (callSites[callee.name] > 1 ||
+                  size > INLINE_SINGLE_CALL_SIZE)) {
+        reason = "muy grande (" + std::to_string(size) + " instrucciones)";
+      }
+
+      if (!reason.empty()) {
+        decisions.push_back({caller->name, callee.name, false, reason});
+        code.push_back(inst);
+        continue;
+      }
+      decisions.push_back({caller->name, callee.name, true,
+                           std::to_string(size) + " instrucciones"});
+      callerSize += size;
+      for (const auto& copied : expand(*caller, callee)) {
+        code.push_back(copied);
+      }
+    }
+    caller->code = std::move(code);
+  }
+  return decisions;
+}
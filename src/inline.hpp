@@ -0,0 +1,32 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del inlining de funciones.
+ * */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mips.hpp"
+
+struct InlineDecision {
+  std::string caller;
+  std::string callee;
+  bool inlined;
+  std::string reason;
+};
+
+// Funciones con este número de instrucciones o menos siempre se copian en
+// donde se llaman; las que se llaman desde un solo lugar se copian hasta el
+// límite mayor.
+constexpr int INLINE_SMALL_SIZE = 16;
+constexpr int INLINE_SINGLE_CALL_SIZE = 64;
+// Una función no crece más de esto por copiar otras.
+constexpr int INLINE_CALLER_LIMIT = 400;
+
+// Cambia cada jal a una función pequeña y no recursiva por una copia de su
+// cuerpo. Recorre el call graph de las hojas hacia arriba para que lo que se
+// copia ya tenga sus propias llamadas resueltas. Regresa qué se decidió en
+// cada llamada.
+std::vector<InlineDecision> inlineFunctions(
+    std::vector<MachineFunction>& functions);
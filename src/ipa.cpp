@@ -0,0 +1,419 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del análisis interprocedural.
+ * */
+#include "ipa.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "astutil.hpp"
+#include "parser.hpp"
+
+namespace {
+
+// Lo que una llamada pasa en la posición de un parámetro. SAME es una
+// llamada recursiva que pasa el mismo parámetro sin cambiarlo.
+struct ArgumentValue {
+  enum Kind { UNKNOWN, CONSTANT, SAME } kind;
+  int value;
+};
+
+struct CallSite {
+  FunDeclarationNode* caller;
+  CallNode* call;
+};
+
+using FunctionTable = std::map<std::string, FunDeclarationNode*>;
+
+// Las llamadas que hace cada función y quién llama a cada nombre, para no
+// recorrer todo el programa por cada función que se especializa. Una
+// entrada en callers puede sobrar después de doblar constantes; las
+// llamadas se filtran por nombre al usarlas.
+struct CallIndex {
+  std::map<FunDeclarationNode*, std::vector<CallNode*>> callsFrom;
+  std::map<std::string, std::set<std::string>> callers;
+};
+// Pares (posición del parámetro, constante), de la última posición a la
+// primera para poder borrar en orden.
+using Bindings = std::vector<std::pair<int, int>>;
+
+}  // namespace
+
+static FunctionTable functionTable(ProgramNode* program) {
+  FunctionTable table;
+  for (auto& decl : program->declarationList) {
+    auto fun = dynamic_cast<FunDeclarationNode*>(decl.get());
+    if (fun && fun->compoundStatement) table[fun->id] = fun;
+  }
+  return table;
+}
+
+// Las llamadas a funciones del programa (sin input y output).
+static std::vector<CallNode*> callsIn(FunDeclarationNode* fun) {
+  std::vector<CallNode*> calls;
+  forEachExpression(fun->compoundStatement.get(), [&](ExpressionNode* expr) {
+    auto call = dynamic_cast<CallNode*>(expr);
+    if (call && call->id != "input" && call->id != "output") {
+      calls.push_back(call);
+    }
+  });
+  return calls;
+}
+
+static void indexCalls(CallIndex& index, FunDeclarationNode* fun) {
+  index.callsFrom[fun] = callsIn(fun);
+  for (CallNode* call : index.callsFrom[fun]) {
+    index.callers[call->id].insert(fun->id);
+  }
+}
+
+// Las funciones alcanzables desde main en postorden: cada una queda después
+// de las que llama, salvo en los ciclos de recursión.
+static std::vector<std::string> postorderFromMain(const FunctionTable& table) {
+  std::vector<std::string> order;
+  std::set<std::string> seen;
+  std::function<void(const std::string&)> visit = [&](const std::string& id) {
+    auto it = table.find(id);
+    if (it == table.end() || !seen.insert(id).second) return;
+    for (CallNode* call : callsIn(it->second)) visit(call->id);
+    order.push_back(id);
+  };
+  visit("main");
+  return order;
+}
+
+static std::set<std::string> recursiveFunctions(const FunctionTable& table) {
+  std::set<std::string> recursive;
+  for (const auto& [id, fun] : table) {
+    std::set<std::string> seen;
+    std::vector<std::string> work;
+    for (CallNode* call : callsIn(fun)) work.push_back(call->id);
+    while (!work.empty()) {
+      std::string next = work.back();
+      work.pop_back();
+      if (next == id) {
+        recursive.insert(id);
+        break;
+      }
+      auto it = table.find(next);
+      if (it == table.end() || !seen.insert(next).second) continue;
+      for (CallNode* call : callsIn(it->second)) work.push_back(call->id);
+    }
+  }
+  return recursive;
+}
+
+void removeUnreachableFunctions(ProgramNode* program,
+                                std::vector<std::string>& removed) {
+  FunctionTable table = functionTable(program);
+  if (!table.count("main")) return;
+  std::vector<std::string> order = postorderFromMain(table);
+  std::set<std::string> reachable(order.begin(), order.end());
+
+  auto& list = program->declarationList;
+  for (auto it = list.begin(); it != list.end();) {
+    auto fun = dynamic_cast<FunDeclarationNode*>(it->get());
+    if (fun && fun->compoundStatement && !reachable.count(fun->id)) {
+      removed.push_back(fun->id);
+      it = list.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+// Los parámetros que se pueden cambiar por una constante: escalares que la
+// función nunca asigna ni esconde con otra declaración.
+static std::vector<bool> fixableParams(FunDeclarationNode* fun) {
+  std::set<std::string> scalars = singleScalars(fun);
+  std::set<std::string> assigned;
+  forEachExpression(fun->compoundStatement.get(), [&](ExpressionNode* expr) {
+    if (auto assign = dynamic_cast<AssignmentExpressionNode*>(expr)) {
+      assigned.insert(assign->var->id);
+    }
+  });
+  std::vector<bool> fixable;
+  for (auto& param : fun->params) {
+    fixable.push_back(scalars.count(param->id) && !assigned.count(param->id));
+  }
+  return fixable;
+}
+
+static ArgumentValue argumentValue(const CallSite& site, int position,
+                                   FunDeclarationNode* callee) {
+  FactorNode* factor = asFactor(site.call->argsList[position].get());
+  if (isLiteral(factor)) return {ArgumentValue::CONSTANT, factor->value};
+  VarNode* var = bareVar(factor);
+  if (site.caller == callee && var &&
+      var->id == callee->params[position]->id) {
+    return {ArgumentValue::SAME, 0};
+  }
+  return {ArgumentValue::UNKNOWN, 0};
+}
+
+static void dropArguments(CallNode* call, const Bindings& bindings) {
+  for (const auto& [position, value] : bindings) {
+    call->argsList.erase(call->argsList.begin() + position);
+  }
+}
+
+// Cambia cada lectura de los parámetros por su constante y los quita de la
+// firma. Regresa las constantes como texto para el reporte.
+static std::vector<std::string> bindParameters(FunDeclarationNode* fun,
+                                               const Bindings& bindings) {
+  std::map<std::string, int> values;
+  std::vector<std::string> described;
+  for (const auto& [position, value] : bindings) {
+    const std::string& id = fun->params[position]->id;
+    values[id] = value;
+    described.insert(described.begin(), id + " = " + std::to_string(value));
+  }
+
+  std::vector<FactorNode*> uses;
+  forEachExpression(fun->compoundStatement.get(), [&](ExpressionNode* expr) {
+    auto factor = dynamic_cast<FactorNode*>(expr);
+    VarNode* var = bareVar(factor);
+    if (var && values.count(var->id)) uses.push_back(factor);
+  });
+  for (FactorNode* factor : uses) {
+    factor->value = values[factor->var->id];
+    factor->var.reset();
+  }
+  for (const auto& [position, value] : bindings) {
+    fun->params.erase(fun->params.begin() + position);
+  }
+  return described;
+}
+
+// Si alguno de los parámetros fijados es el límite o el paso (i = i + k) de
+// un while: con constantes el loop se puede desenrollar y reducir.
+static bool controlsLoop(FunDeclarationNode* fun, const Bindings& bindings) {
+  std::set<std::string> names;
+  for (const auto& [position, value] : bindings) {
+    names.insert(fun->params[position]->id);
+  }
+  auto isStep = [&](StatementNode* stmt) {
+    auto expr = dynamic_cast<ExpressionStatementNode*>(stmt);
+    auto assign = expr ? dynamic_cast<AssignmentExpressionNode*>(
+                             expr->expression.get())
+                       : nullptr;
+    if (!assign || assign->var->expression) return false;
+    auto simple =
+        dynamic_cast<SimpleExpressionNode*>(assign->simpleExpression.get());
+    if (!simple || simple->additiveRight) return false;
+    auto add = simple->additiveLeft.get();
+    if (!add->rightTerm || add->rightTerm->rightTerm) return false;
+    VarNode* left = bareVar(asFactor(add->leftTerm.get()));
+    VarNode* right = bareVar(asFactor(add->rightTerm->leftTerm.get()));
+    return left && right && left->id == assign->var->id &&
+           names.count(right->id);
+  };
+
+  bool found = false;
+  forEachStatement(fun->compoundStatement.get(), [&](StatementNode* stmt) {
+    auto iter = dynamic_cast<IterationStatementNode*>(stmt);
+    if (!iter) return;
+    forEachExpression(iter->expression.get(), [&](ExpressionNode* expr) {
+      VarNode* var = bareVar(dynamic_cast<FactorNode*>(expr));
+      if (var && names.count(var->id)) found = true;
+    });
+    forEachStatement(iter->statement.get(), [&](StatementNode* inner) {
+      if (isStep(inner)) found = true;
+    });
+  });
+  return found;
+}
+
+static std::unique_ptr<FunDeclarationNode> cloneFunction(
+    FunDeclarationNode* fun, const std::string& id) {
+  auto clone = std::make_unique<FunDeclarationNode>(
+      fun->type, id, fun->getLineno(), fun->getPosition());
+  for (auto& param : fun->params) {
+    auto copy = std::make_unique<ParamNode>(
+        param->type, param->id, param->getLineno(), param->getPosition());
+    copy->isArray = param->isArray;
+    clone->params.push_back(std::move(copy));
+  }
+  clone->compoundStatement.reset(static_cast<CompoundStatementNode*>(
+      cloneStatement(fun->compoundStatement.get()).release()));
+  return clone;
+}
+
+static void specialize(ProgramNode* program, FunctionTable& table,
+                       CallIndex& index, FunDeclarationNode* fun,
+                       bool recursive, InterproceduralReport& report) {
+  std::vector<CallSite> outside, self;
+  for (const auto& id : index.callers[fun->id]) {
+    FunDeclarationNode* caller = table[id];
+    for (CallNode* call : index.callsFrom[caller]) {
+      if (call->id != fun->id) continue;
+      (caller == fun ? self : outside).push_back({caller, call});
+    }
+  }
+  if (outside.empty()) return;
+  std::vector<bool> fixable = fixableParams(fun);
+
+  // Parámetros que reciben la misma constante en todas las llamadas; las
+  // recursivas también pueden pasar el parámetro tal cual.
+  Bindings uniform;
+  for (int p = fun->params.size() - 1; p >= 0; --p) {
+    if (!fixable[p]) continue;
+    ArgumentValue first = argumentValue(outside[0], p, fun);
+    bool same = first.kind == ArgumentValue::CONSTANT;
+    for (const auto& site : outside) {
+      ArgumentValue arg = argumentValue(site, p, fun);
+      if (arg.kind != ArgumentValue::CONSTANT || arg.value != first.value) {
+        same = false;
+      }
+    }
+    for (const auto& site : self) {
+      ArgumentValue arg = argumentValue(site, p, fun);
+      if (arg.kind == ArgumentValue::UNKNOWN ||
+          (arg.kind == ArgumentValue::CONSTANT && arg.value != first.value)) {
+        same = false;
+      }
+    }
+    if (same) uniform.push_back({p, first.value});
+  }
+  if (!uniform.empty()) {
+    for (const auto& site : outside) dropArguments(site.call, uniform);
+    for (const auto& site : self) dropArguments(site.call, uniform);
+    report.specializations.push_back(
+        {fun->id, "", bindParameters(fun, uniform)});
+    fixable = fixableParams(fun);
+  }
+
+  // Con constantes distintas se copia la función para cada combinación,
+  // empezando por la que más se usa, si la copia se simplifica. Lo que ya
+  // era constante en la original no cuenta.
+  if (foldConstants(fun->compoundStatement.get()) > 0) indexCalls(index, fun);
+  int size = 0;
+  forEachExpression(fun->compoundStatement.get(), [&](ExpressionNode* expr) {
+    if (dynamic_cast<FactorNode*>(expr)) size++;
+  });
+  if (recursive || size > IPA_CLONE_SIZE_LIMIT) return;
+
+  std::map<Bindings, std::vector<CallSite>> groups;
+  for (const auto& site : outside) {
+    Bindings key;
+    for (int p = fun->params.size() - 1; p >= 0; --p) {
+      ArgumentValue arg = argumentValue(site, p, fun);
+      if (fixable[p] && arg.kind == ArgumentValue::CONSTANT) {
+        key.push_back({p, arg.value});
+      }
+    }
+    if (!key.empty()) groups[key].push_back(site);
+  }
+  std::vector<std::pair<Bindings, std::vector<CallSite>>> ordered(
+      groups.begin(), groups.end());
+  std::stable_sort(ordered.begin(), ordered.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.second.size() > b.second.size();
+                   });
+
+  auto& list = program->declarationList;
+  int clones = 0;
+  for (const auto& [bindings, sites] : ordered) {
+    if (clones == IPA_MAX_CLONES) break;
+    // Los identificadores de C- solo tienen letras, así que el nombre de la
+    // copia no choca con ninguna función del programa.
+    auto clone = cloneFunction(fun, fun->id + "_" + std::to_string(clones + 1));
+    bool loopBound = controlsLoop(clone.get(), bindings);
+    std::vector<std::string> constants = bindParameters(clone.get(), bindings);
+    if (foldConstants(clone->compoundStatement.get()) == 0 && !loopBound) {
+      continue;
+    }
+
+    for (const auto& site : sites) {
+      site.call->id = clone->id;
+      dropArguments(site.call, bindings);
+      index.callers[clone->id].insert(site.caller->id);
+    }
+    report.specializations.push_back({fun->id, clone->id, constants});
+    table[clone->id] = clone.get();
+    indexCalls(index, clone.get());
+    auto at = std::find_if(list.begin(), list.end(),
+                           [&](const auto& decl) { return decl.get() == fun; });
+    list.insert(at + 1 + clones, std::move(clone));
+    clones++;
+  }
+}
+
+// Una función es pura si solo asigna sus escalares y sus arreglos locales,
+// no hace entrada o salida y solo llama a funciones puras. Puede leer
+// globales.
+static std::set<std::string> findPureFunctions(const FunctionTable& table) {
+  std::set<std::string> pure;
+  std::map<std::string, std::set<std::string>> callees;
+  for (const auto& [id, fun] : table) {
+    if (id == "main") continue;
+    std::set<std::string> locals;
+    for (auto& param : fun->params) {
+      if (!param->isArray) locals.insert(param->id);
+    }
+    for (auto& var : fun->compoundStatement->vars) locals.insert(var->id);
+
+    bool effects = false;
+    forEachExpression(fun->compoundStatement.get(), [&](ExpressionNode* expr) {
+      if (auto assign = dynamic_cast<AssignmentExpressionNode*>(expr)) {
+        if (!locals.count(assign->var->id)) effects = true;
+      } else if (auto call = dynamic_cast<CallNode*>(expr)) {
+        if (call->id == "input" || call->id == "output") effects = true;
+        callees[id].insert(call->id);
+      }
+    });
+    if (!effects) pure.insert(id);
+  }
+
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (const auto& id : std::set<std::string>(pure)) {
+      for (const auto& callee : callees[id]) {
+        if (!pure.count(callee)) {
+          pure.erase(id);
+          changed = true;
+          break;
+        }
+      }
+    }
+  }
+  return pure;
+}
+
+InterproceduralReport optimizeInterprocedural(ProgramNode* program) {
+  InterproceduralReport report;
+  removeUnreachableFunctions(program, report.removed);
+  FunctionTable table = functionTable(program);
+  if (!table.count("main")) return report;
+
+  // Los que llaman van primero, para que las constantes que aparecen al
+  // especializar una función sigan bajando a las que ella llama.
+  std::set<std::string> recursive = recursiveFunctions(table);
+  std::vector<std::string> order = postorderFromMain(table);
+  CallIndex index;
+  for (const auto& [id, fun] : table) indexCalls(index, fun);
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    if (*it == "main") continue;
+    specialize(program, table, index, table[*it], recursive.count(*it),
+               report);
+  }
+
+  // Las llamadas a funciones puras se dejan aunque no se use su valor: que
+  // no tengan efectos no prueba que terminen ni que no fallen.
+  std::set<std::string> pure = findPureFunctions(table);
+
+  // Las funciones que quedaron sin llamadas, porque todas se cambiaron por
+  // copias, ya no se generan.
+  removeUnreachableFunctions(program, report.removed);
+  for (const auto& [id, fun] : functionTable(program)) {
+    if (pure.count(id)) report.pure.push_back(id);
+  }
+  return report;
+}
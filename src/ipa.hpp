@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del análisis interprocedural.
+ * */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+
+// Tamaño máximo, en operandos, de una función que se copia para
+// especializarla con constantes.
+constexpr int IPA_CLONE_SIZE_LIMIT = 64;
+// Copias especializadas por función.
+constexpr int IPA_MAX_CLONES = 4;
+
+struct Specialization {
+  std::string function;
+  // Nombre de la copia, o vacío si se especializó la función misma porque
+  // todas las llamadas pasan la misma constante.
+  std::string clone;
+  // Parámetros fijados, como "k = 3".
+  std::vector<std::string> constants;
+};
+
+struct InterproceduralReport {
+  std::vector<Specialization> specializations;
+  // Funciones sin efectos: no escriben globales ni arreglos que reciben, no
+  // hacen entrada o salida y solo llaman a otras funciones puras.
+  std::vector<std::string> pure;
+  // Funciones que main nunca alcanza.
+  std::vector<std::string> removed;
+};
+
+// Con el grafo de llamadas del programa propaga a cada función los
+// argumentos constantes: si todas las llamadas pasan la misma constante el
+// parámetro desaparece, y si pasan constantes distintas se hacen copias
+// especializadas cuando eso simplifica el cuerpo. Después busca las
+// funciones puras y quita las funciones a las que main ya no llega.
+InterproceduralReport optimizeInterprocedural(ProgramNode* program);
+
+// Quita las funciones a las que main ya no llega y agrega sus nombres a
+// removed.
+void removeUnreachableFunctions(ProgramNode* program,
+                                std::vector<std::string>& removed);
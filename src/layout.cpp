@@ -0,0 +1,67 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de las heurísticas para acomodar los
+ *  bloques.
+ * */
+#include "layout.hpp"
+
+#include <fstream>
+
+#include "astutil.hpp"
+
+bool loadBranchProfile(const std::string& path, BranchProfile& profile) {
+  std::ifstream file(path);
+  if (!file) return false;
+  std::string label;
+  long long count;
+  while (file >> label >> count) profile[label] += count;
+  return true;
+}
+
+static bool endsInReturn(StatementNode* stmt) {
+  if (!stmt) return false;
+  if (dynamic_cast<ReturnStatementNode*>(stmt)) return true;
+  if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+    return !comp->statements.empty() &&
+           endsInReturn(comp->statements.back().get());
+  }
+  if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+    return endsInReturn(sel->statement.get()) &&
+           endsInReturn(sel->elseStatement.get());
+  }
+  return false;
+}
+
+static bool callsItself(StatementNode* stmt, const std::string& function) {
+  if (!stmt) return false;
+  bool found = false;
+  forEachExpression(stmt, [&](ExpressionNode* expr) {
+    auto call = dynamic_cast<CallNode*>(expr);
+    if (call && call->id == function) found = true;
+  });
+  return found;
+}
+
+bool thenIsLikely(SelectionStatementNode* node, const std::string& function,
+                  const BranchProfile& profile, const std::string& thenLabel,
+                  const std::string& elseLabel) {
+  auto thenCount = profile.find(thenLabel);
+  auto elseCount = profile.find(elseLabel);
+  if (thenCount != profile.end() || elseCount != profile.end()) {
+    long long taken = thenCount == profile.end() ? 0 : thenCount->second;
+    long long notTaken = elseCount == profile.end() ? 0 : elseCount->second;
+    return taken >= notTaken;
+  }
+
+  StatementNode* then = node->statement.get();
+  StatementNode* otherwise = node->elseStatement.get();
+  bool thenRecurses = callsItself(then, function);
+  if (thenRecurses != callsItself(otherwise, function)) return thenRecurses;
+
+  bool thenReturns = endsInReturn(then);
+  if (thenReturns != endsInReturn(otherwise)) return !thenReturns;
+
+  SimpleExpressionNode* cmp = asComparison(node->condition.get());
+  if (cmp && cmp->relop == TokenType::EQ) return false;
+  return true;
+}
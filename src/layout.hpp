@@ -0,0 +1,27 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de las heurísticas para acomodar los bloques.
+ * */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "parser.hpp"
+
+// Cuántas veces se ejecutó cada etiqueta en una corrida anterior. El archivo
+// tiene una línea `etiqueta veces` por etiqueta.
+using BranchProfile = std::unordered_map<std::string, long long>;
+bool loadBranchProfile(const std::string& path, BranchProfile& profile);
+
+// Decide si el then de un if es el camino probable, para que ese quede
+// después del branch sin saltar. Si el perfil tiene las etiquetas del then o
+// del else se usan sus conteos; si no:
+//  - el lado que llama recursivamente a la función es el probable,
+//  - el lado que termina en return es el poco probable (casos base y
+//    errores),
+//  - una comparación con == casi siempre es falsa,
+//  - en cualquier otro caso se supone que el then se toma.
+bool thenIsLikely(SelectionStatementNode* node, const std::string& function,
+                  const BranchProfile& profile, const std::string& thenLabel,
+                  const std::string& elseLabel);
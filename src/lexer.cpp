@@ -237,7 +237,7 @@ std::tuple<TokenType, std::string, int> Lexer::getToken(bool imprime) {
       if (ch == '=') {
         state = StateType::DONE;
         tokenType = TokenType::EQ;
-      } else if (ch == ' ') {
+      } else {
         state = StateType::DONE;
         if (position <= programLength) {
           position--;
@@ -248,10 +248,18 @@ std::tuple<TokenType, std::string, int> Lexer::getToken(bool imprime) {
     } else if (state == StateType::INEXC) {
       if (ch == '=') {
         state = StateType::DONE;
+        tokenType = TokenType::NOT_EQ;
+      }
+    } else if (state == StateType::INST || state == StateType::INGT) {
+      bool less = state == StateType::INST;
+      state = StateType::DONE;
+      if (ch == '=') {
+        tokenType = less ? TokenType::LTE : TokenType::GTE;
+      } else {
         if (position <= programLength) {
           position--;
         }
-        tokenType = TokenType::NOT_EQ;
+        tokenType = less ? TokenType::LT : TokenType::GT;
         save = false;
       }
     } else if (state == StateType::INSLASH) {
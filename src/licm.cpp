@@ -0,0 +1,226 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del movimiento de código invariante.
+ * */
+#include "licm.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "cfg.hpp"
+#include "cse.hpp"
+#include "mips.hpp"
+
+static int hoistFromLoop(MachineFunction& fn, const ControlFlowGraph& cfg,
+                         const Loop& loop) {
+  const auto& code = fn.code;
+  const BasicBlock& header = cfg.blocks[loop.header];
+
+  // Si el bloque anterior al header está dentro del loop y cae al header, no
+  // hay dónde poner el preheader sin romper el loop.
+  if (loop.header == 0) return 0;
+  const BasicBlock& before = cfg.blocks[loop.header - 1];
+  if (loop.blocks.count(loop.header - 1) &&
+      !code[before.end - 1].endsBlock()) {
+    return 0;
+  }
+
+  std::vector<int> body;
+  for (int b : loop.blocks) {
+    for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+      body.push_back(i);
+    }
+  }
+  std::sort(body.begin(), body.end());
+
+  std::map<int, int> defCount;
+  std::map<int, int> defSite;
+  bool writesMemory = false;
+  for (int i : body) {
+    for (int d : Location::defs(code[i], fn)) {
+      defCount[d]++;
+      defSite[d] = i;
+    }
+    if (code[i].op == Op::JAL ||
+        (code[i].op == Op::SW && !Location::isFrameSlot(code[i], fn))) {
+      writesMemory = true;
+    }
+  }
+
+  // Marcamos las instrucciones invariantes: sus operandos no se definen en el
+  // loop o se definen una sola vez por otra instrucción invariante.
+  std::set<int> invariant;
+  auto isInvariantUse = [&](int loc) {
+    if (!defCount.count(loc)) return true;
+    return defCount[loc] == 1 && invariant.count(defSite[loc]);
+  };
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i : body) {
+      const Instruction& inst = code[i];
+      if (invariant.count(i) || Mips::hasSideEffects(inst)) continue;
+      std::vector<int> defs = Location::defs(inst, fn);
+      if (defs.size() != 1 || defCount[defs[0]] != 1) continue;
+      if (inst.op == Op::LW && !Location::isFrameSlot(inst, fn)) {
+        // Solo leemos globales por adelantado: la base tiene que ser $gp o
+        // venir de un la invariante y nada en el loop puede escribir a
+        // memoria.
+        bool global = inst.rs == Reg::GP ||
+                      (defCount.count(inst.rs) &&
+                       code[defSite[inst.rs]].op == Op::LA);
+        if (writesMemory || !global) continue;
+      }
+      bool ok = true;
+      for (int u : Location::uses(inst, fn)) {
+        if (!isInvariantUse(u)) ok = false;
+      }
+      if (ok) {
+        invariant.insert(i);
+        changed = true;
+      }
+    }
+  }
+
+  // De las invariantes solo movemos las que siguen siendo correctas fuera del
+  // loop: el valor que definen no puede estar vivo al entrar al header, y si
+  // está vivo a la salida, la instrucción tiene que dominar todas las salidas.
+  std::vector<int> exits;
+  std::set<int> liveAtExit;
+  for (int b : loop.blocks) {
+    for (int s : cfg.blocks[b].succs) {
+      if (loop.blocks.count(s)) continue;
+      exits.push_back(b);
+      liveAtExit.insert(cfg.blocks[s].liveIn.begin(),
+                        cfg.blocks[s].liveIn.end());
+    }
+  }
+  auto blockOf = [&](int i) {
+    for (int b : loop.blocks) {
+      if (i >= cfg.blocks[b].begin && i < cfg.blocks[b].end) return b;
+    }
+    return -1;
+  };
+
+  std::set<int> hoist;
+  for (int i : invariant) {
+    int dest = Location::defs(code[i], fn)[0];
+    if (header.liveIn.count(dest)) continue;
+    if (liveAtExit.count(dest)) {
+      bool dominatesExits = true;
+      for (int e : exits) {
+        if (!cfg.dominates(blockOf(i), e)) dominatesExits = false;
+      }
+      if (!dominatesExits) continue;
+    }
+    hoist.insert(i);
+  }
+  // Una instrucción solo sale si sus dependencias dentro del loop también
+  // salen y quedan antes que ella.
+  changed = true;
+  while (changed) {
+    changed = false;
+    for (int i : std::set<int>(hoist)) {
+      for (int u : Location::uses(code[i], fn)) {
+        if (!defCount.count(u)) continue;
+        if (!hoist.count(defSite[u]) || defSite[u] > i) {
+          hoist.erase(i);
+          changed = true;
+          break;
+        }
+      }
+    }
+  }
+  if (hoist.empty()) return 0;
+
+  // Las copias de un loop desenrollado o de una función inlined varias veces
+  // sacan la misma constante o dirección: en el preheader basta una y los
+  // usos de las demás leen de ella.
+  std::map<int, int> totalDefs;
+  for (const auto& inst : code) {
+    for (int d : Mips::defs(inst)) totalDefs[d]++;
+  }
+  std::map<int, int> renamed;
+  auto rename = [&](Instruction& inst) {
+    for (int* operand : {&inst.rs, &inst.rt}) {
+      if (renamed.count(*operand)) *operand = renamed[*operand];
+    }
+  };
+  std::map<ValueKey, int> available;
+  std::set<int> merged;
+  for (int h : hoist) {
+    Instruction inst = code[h];
+    rename(inst);
+    bool numberable = isNumberable(inst) ||
+                      (inst.op == Op::LI && Mips::isVirtual(inst.rd));
+    if (!numberable || totalDefs[inst.rd] != 1) continue;
+    auto [it, inserted] = available.emplace(valueKey(inst), inst.rd);
+    if (!inserted) {
+      renamed[inst.rd] = it->second;
+      merged.insert(h);
+    }
+  }
+
+  // El preheader va justo antes del header; los saltos que entran al loop
+  // desde afuera ahora van al preheader.
+  std::string preLabel = header.label + "_pre";
+  std::set<int> entering;
+  for (int p : header.preds) {
+    if (!loop.blocks.count(p)) entering.insert(cfg.blocks[p].end - 1);
+  }
+  std::vector<Instruction> result;
+  for (int i = 0; i < (int)code.size(); ++i) {
+    if (i == header.begin) {
+      result.push_back(Mips::label(preLabel));
+      for (int h : hoist) {
+        if (merged.count(h)) continue;
+        result.push_back(code[h]);
+        rename(result.back());
+      }
+    }
+    if (hoist.count(i)) continue;
+    result.push_back(code[i]);
+    rename(result.back());
+    if (entering.count(i) && code[i].hasTarget() &&
+        code[i].label == header.label) {
+      result.back().label = preLabel;
+    }
+  }
+  fn.code = std::move(result);
+  return hoist.size();
+}
+
+std::vector<LoopMotionReport> hoistLoopInvariants(MachineFunction& fn) {
+  std::vector<LoopMotionReport> reports;
+  std::set<std::string> visited;
+
+  while (true) {
+    ControlFlowGraph cfg(fn);
+    computeLiveness(fn, cfg);
+    cfg.computeDominators();
+    std::vector<Loop> loops = findNaturalLoops(cfg);
+
+    // Primero los loops internos, para que lo que salga de ellos pueda seguir
+    // subiendo en los loops que los contienen.
+    std::sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) {
+      return a.blocks.size() < b.blocks.size();
+    });
+
+    bool moved = false;
+    for (const auto& loop : loops) {
+      const std::string& label = cfg.blocks[loop.header].label;
+      if (visited.count(label)) continue;
+      visited.insert(label);
+      int hoisted = hoistFromLoop(fn, cfg, loop);
+      reports.push_back({label, hoisted});
+      if (hoisted > 0) {
+        moved = true;
+        break;
+      }
+    }
+    if (!moved) break;
+  }
+  return reports;
+}
@@ -0,0 +1,20 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del movimiento de código invariante de loops.
+ * */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mips.hpp"
+
+struct LoopMotionReport {
+  std::string loop;
+  int hoisted;
+};
+
+// Saca a un preheader las instrucciones de cada loop natural que calculan
+// siempre lo mismo y no tienen efectos secundarios. Regresa cuántas
+// instrucciones se sacaron de cada loop.
+std::vector<LoopMotionReport> hoistLoopInvariants(MachineFunction& fn);
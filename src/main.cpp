@@ -5,25 +5,79 @@
  * */
 
 // Importes de librería estándar
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
 #include <string>
 
 // Importes de folder include/
+#include "astutil.cpp"
+#include "astutil.hpp"
+#include "bounds.cpp"
+#include "bounds.hpp"
+#include "bytecode.cpp"
+#include "bytecode.hpp"
+#include "cfg.cpp"
+#include "cfg.hpp"
 #include "codegen.cpp"
 #include "codegen.hpp"
+#include "cse.cpp"
+#include "cse.hpp"
+#include "ctfe.cpp"
+#include "ctfe.hpp"
+#include "dce.cpp"
+#include "dce.hpp"
+#include "elf.cpp"
+#include "elf.hpp"
+#include "encoder.cpp"
+#include "encoder.hpp"
 #include "errors.cpp"
 #include "errors.hpp"
+#include "globals.cpp"
+#include "globals.hpp"
+#include "inline.cpp"
+#include "inline.hpp"
+#include "ipa.cpp"
+#include "ipa.hpp"
+#include "layout.cpp"
+#include "layout.hpp"
 #include "lexer.cpp"
 #include "lexer.hpp"
+#include "licm.cpp"
+#include "licm.hpp"
+#include "mips.cpp"
+#include "mips.hpp"
 #include "parser.cpp"
 #include "parser.hpp"
+#include "passes.cpp"
+#include "passes.hpp"
+#include "peephole.cpp"
+#include "peephole.hpp"
+#include "promote.cpp"
+#include "promote.hpp"
+#include "regalloc.cpp"
+#include "regalloc.hpp"
+#include "schedule.cpp"
+#include "schedule.hpp"
 #include "semantic.cpp"
 #include "semantic.hpp"
+#include "simulator.cpp"
+#include "simulator.hpp"
+#include "strength.cpp"
+#include "strength.hpp"
+#include "unroll.cpp"
+#include "unroll.hpp"
 #include "visitor.cpp"
 #include "visitor.hpp"
+#include "vm.cpp"
+#include "vm.hpp"
+#include "x86.cpp"
+#include "x86.hpp"
 
-int main() {
+int main(int argc, char* argv[]) {
   // Instanciamos el programa en un string, sobre el que iteraremos.
   std::string fileName = "sample.c-";
   std::ifstream archivo(fileName);
@@ -54,8 +108,128 @@ int main() {
   semantic.analyze();
 
   CodeGenerator codegen(semantic);
+  bool useVm = false;
+  bool emitX86 = false;
+  bool linkX86 = false;
+  // Correr el programa ya compilado en el simulador y en la VM.
+  bool simulate = false;
+  SimulationOptions simulation;
+  std::string profileOutput;
+  int vmBenchmarkRuns = 0;
+  // El pipeline lo da el último -O; las banderas -f solo prenden o apagan
+  // pasadas sueltas encima de él.
+  OptLevel optLevel = OptLevel::O1;
+  std::map<std::string, bool> passOverrides;
+  for (int i = 1; i < argc; ++i) {
+    std::string flag = argv[i];
+    if (flag.rfind("-O", 0) == 0) {
+      optLevel = parseOptLevel(flag, optLevel);
+    }
+    if (flag == "-fno-print-asm") codegen.printAssembly = false;
+    if (flag == "-felf") codegen.emitElf = true;
+    if (flag == "-fvm") useVm = true;
+    if (flag == "-fx86") emitX86 = true;
+    if (flag == "-fnative") emitX86 = linkX86 = true;
+    if (flag.rfind("-fvm-bench=", 0) == 0) {
+      vmBenchmarkRuns = std::stoi(flag.substr(11));
+    }
+    if (flag == "-fsimulate") simulate = true;
+    if (flag == "-fsimulate-pipeline") simulate = simulation.pipeline = true;
+    if (flag == "-fno-omit-frame-pointer") codegen.omitFramePointer = false;
+    if (flag == "-fomit-frame-pointer") codegen.omitFramePointer = true;
+    if (flag == "-fschedule-insns") passOverrides["schedule"] = true;
+    if (flag == "-fdelayed-branch") codegen.delaySlots = true;
+    if (flag == "-fbounds-check") codegen.boundsCheck = true;
+    if (flag == "-funroll-loops") {
+      codegen.unrollFactor = UNROLL_DEFAULT_FACTOR;
+      passOverrides["unroll"] = true;
+    }
+    if (flag.rfind("-funroll-loops=", 0) == 0) {
+      codegen.unrollFactor = std::stoi(flag.substr(15));
+      passOverrides["unroll"] = codegen.unrollFactor > 0;
+    }
+    if (flag.rfind("-fconstexpr-steps=", 0) == 0) {
+      codegen.constevalBudget = std::stoll(flag.substr(18));
+    }
+    if (flag.rfind("-G", 0) == 0 && flag.size() > 2) {
+      codegen.smallDataLimit = std::stoi(flag.substr(2));
+    }
+    if (flag.rfind("-fprofile-generate=", 0) == 0) {
+      simulate = true;
+      profileOutput = flag.substr(19);
+    }
+    if (flag.rfind("-fprofile-use=", 0) == 0) {
+      std::string path = flag.substr(std::string("-fprofile-use=").size());
+      if (!loadBranchProfile(path, codegen.profile)) {
+        std::cerr << "Cannot read profile " << path << std::endl;
+      }
+    }
+  }
+  codegen.encodeObject = simulate || vmBenchmarkRuns > 0;
+
+  if (useVm) {
+    // Sin pasar por MIPS: el árbol revisado se compila a bytecode y corre
+    // en la VM.
+    BytecodeProgram bytecode =
+        compileBytecode(semantic.getTree().get(), codegen.boundsCheck);
+    VirtualMachine vm(bytecode);
+    VmResult run = vm.run(readProgramInput(std::cin));
+    std::cout << run.output;
+    if (!run.exited) std::cerr << "Error: " << run.error << std::endl;
+    return run.exited ? 0 : 1;
+  }
 
-  codegen.generate();
+  if (emitX86) {
+    // El backend de x86-64: main.s y, con -fnative, el ejecutable main.
+    std::string assembly =
+        generateX86(semantic.getTree().get(), codegen.boundsCheck);
+    std::ofstream file("main.s", std::ios::binary);
+    file.write(assembly.data(), assembly.size());
+    file.close();
+    if (linkX86 && !linkNative("main.s", "main")) {
+      std::cerr << "Error: no se pudo ensamblar y ligar main.s" << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // La VM compila el árbol como lo dejó Semantic, antes de que las pasadas
+  // de generate() lo cambien.
+  BytecodeProgram bytecode;
+  double bytecodeMilliseconds = 0;
+  if (vmBenchmarkRuns > 0) {
+    auto start = std::chrono::steady_clock::now();
+    bytecode = compileBytecode(semantic.getTree().get(), codegen.boundsCheck);
+    bytecodeMilliseconds = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+  }
+
+  PassManager passes(optLevel);
+  for (const auto& [name, enabled] : passOverrides) {
+    passes.setEnabled(name, enabled);
+  }
+  PassReports reports;
+  registerPasses(passes, codegen, reports);
+  codegen.generate(passes);
+  printPassReports(reports, passes, codegen);
+
+  const ObjectCode& object = codegen.getObjectCode();
+  if (!codegen.encodeObject || !object.errors.empty()) return 0;
+  // La simulación y el benchmark corren el programa varias veces, así que
+  // stdin se lee completo una sola vez.
+  std::string input(std::istreambuf_iterator<char>(std::cin),
+                    (std::istreambuf_iterator<char>()));
+  if (simulate) {
+    std::istringstream in(input);
+    simulation.input = &in;
+    simulation.delaySlots = codegen.delaySlots;
+    runSimulation(object, simulation, profileOutput);
+  }
+  if (vmBenchmarkRuns > 0) {
+    benchmarkBackends(bytecode, bytecodeMilliseconds, object, input,
+                      vmBenchmarkRuns, codegen.delaySlots);
+  }
 
   return 0;
 }
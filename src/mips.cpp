@@ -0,0 +1,528 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de las instrucciones MIPS.
+ * */
+#include "mips.hpp"
+
+#include <charconv>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace Mips {
+
+static void appendInt(std::string& out, int value) {
+  char digits[12];
+  auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+  out.append(digits, end);
+}
+
+static void appendReg(std::string& out, int reg) {
+  static const char* names[] = {
+      "zero", "at", "v0", "v1", "a0", "a1", "a2", "a3", "t0", "t1", "t2",
+      "t3",   "t4", "t5", "t6", "t7", "s0", "s1", "s2", "s3", "s4", "s5",
+      "s6",   "s7", "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra"};
+  if (reg >= 0 && reg < 32) {
+    out += '$';
+    out += names[reg];
+  } else if (reg == Reg::HI) {
+    out += "$hi";
+  } else if (reg == Reg::LO) {
+    out += "$lo";
+  } else if (isVirtual(reg)) {
+    out += '%';
+    appendInt(out, reg - Reg::VIRTUAL);
+  } else {
+    out += "$?";
+    appendInt(out, reg);
+  }
+}
+
+std::string regName(int reg) {
+  std::string name;
+  appendReg(name, reg);
+  return name;
+}
+
+bool isVirtual(int reg) { return reg >= Reg::VIRTUAL; }
+
+static const char* opName(Op op) {
+  switch (op) {
+    case Op::ADD:
+      return "add";
+    case Op::ADDU:
+      return "addu";
+    case Op::SUB:
+      return "sub";
+    case Op::SUBU:
+      return "subu";
+    case Op::MUL:
+      return "mul";
+    case Op::XOR:
+      return "xor";
+    case Op::SLT:
+      return "slt";
+    case Op::SLTU:
+      return "sltu";
+    case Op::MULT:
+      return "mult";
+    case Op::DIV:
+      return "div";
+    case Op::MFHI:
+      return "mfhi";
+    case Op::MFLO:
+      return "mflo";
+    case Op::ADDIU:
+      return "addiu";
+    case Op::XORI:
+      return "xori";
+    case Op::SLTIU:
+      return "sltiu";
+    case Op::SLL:
+      return "sll";
+    case Op::SRL:
+      return "srl";
+    case Op::SRA:
+      return "sra";
+    case Op::LI:
+      return "li";
+    case Op::LA:
+      return "la";
+    case Op::MOVE:
+      return "move";
+    case Op::LW:
+      return "lw";
+    case Op::SW:
+      return "sw";
+    case Op::BEQ:
+      return "beq";
+    case Op::BNE:
+      return "bne";
+    case Op::BLEZ:
+      return "blez";
+    case Op::BGTZ:
+      return "bgtz";
+    case Op::BLTZ:
+      return "bltz";
+    case Op::BGEZ:
+      return "bgez";
+    case Op::J:
+    case Op::TAILCALL:
+      return "j";
+    case Op::JAL:
+      return "jal";
+    case Op::JR:
+      return "jr";
+    case Op::SYSCALL:
+      return "syscall";
+    case Op::NOP:
+      return "nop";
+    default:
+      return "";
+  }
+}
+
+// El desplazamiento de un lw, sw o addiu como se escribe en el ensamblador.
+static void appendOffset(std::string& out, const Instruction& inst) {
+  if (inst.label.empty()) {
+    appendInt(out, inst.imm);
+    return;
+  }
+  out += "%gp_rel(";
+  out += inst.label;
+  if (inst.imm > 0) out += '+';
+  if (inst.imm != 0) appendInt(out, inst.imm);
+  out += ')';
+}
+
+// Agrega una lista de operandos de registro separados por comas.
+static void appendRegs(std::string& out, std::initializer_list<int> regs) {
+  bool first = true;
+  for (int reg : regs) {
+    if (!first) out += ", ";
+    appendReg(out, reg);
+    first = false;
+  }
+}
+
+void appendTo(std::string& out, const Instruction& inst) {
+  switch (inst.op) {
+    case Op::LABEL:
+      out += inst.label;
+      out += ':';
+      return;
+    case Op::COMMENT:
+      out += "  # ";
+      out += inst.label;
+      return;
+    case Op::CHECK:
+      out += "  # check ";
+      appendReg(out, inst.rs);
+      out += " < ";
+      appendInt(out, inst.imm);
+      return;
+    default:
+      break;
+  }
+
+  out += "  ";
+  out += opName(inst.op);
+  switch (inst.op) {
+    case Op::ADD:
+    case Op::ADDU:
+    case Op::SUB:
+    case Op::SUBU:
+    case Op::MUL:
+    case Op::XOR:
+    case Op::SLT:
+    case Op::SLTU:
+      out += ' ';
+      appendRegs(out, {inst.rd, inst.rs, inst.rt});
+      break;
+    case Op::MULT:
+    case Op::DIV:
+      out += ' ';
+      appendRegs(out, {inst.rs, inst.rt});
+      break;
+    case Op::MFHI:
+    case Op::MFLO:
+      out += ' ';
+      appendReg(out, inst.rd);
+      break;
+    case Op::ADDIU:
+      out += ' ';
+      appendRegs(out, {inst.rd, inst.rs});
+      out += ", ";
+      appendOffset(out, inst);
+      break;
+    case Op::XORI:
+    case Op::SLTIU:
+    case Op::SLL:
+    case Op::SRL:
+    case Op::SRA:
+      out += ' ';
+      appendRegs(out, {inst.rd, inst.rs});
+      out += ", ";
+      appendInt(out, inst.imm);
+      break;
+    case Op::LI:
+      out += ' ';
+      appendReg(out, inst.rd);
+      out += ", ";
+      appendInt(out, inst.imm);
+      break;
+    case Op::LA:
+      out += ' ';
+      appendReg(out, inst.rd);
+      out += ", ";
+      out += inst.label;
+      break;
+    case Op::MOVE:
+      out += ' ';
+      appendRegs(out, {inst.rd, inst.rs});
+      break;
+    case Op::LW:
+    case Op::SW:
+      out += ' ';
+      appendReg(out, inst.op == Op::LW ? inst.rd : inst.rt);
+      out += ", ";
+      appendOffset(out, inst);
+      out += '(';
+      appendReg(out, inst.rs);
+      out += ')';
+      break;
+    case Op::BEQ:
+    case Op::BNE:
+      out += ' ';
+      appendRegs(out, {inst.rs, inst.rt});
+      out += ", ";
+      out += inst.label;
+      break;
+    case Op::BLEZ:
+    case Op::BGTZ:
+    case Op::BLTZ:
+    case Op::BGEZ:
+      out += ' ';
+      appendReg(out, inst.rs);
+      out += ", ";
+      out += inst.label;
+      break;
+    case Op::J:
+    case Op::JAL:
+    case Op::TAILCALL:
+      out += ' ';
+      out += inst.label;
+      break;
+    case Op::JR:
+      out += ' ';
+      appendReg(out, inst.rs);
+      break;
+    default:
+      break;
+  }
+}
+
+std::string toString(const Instruction& inst) {
+  std::string text;
+  appendTo(text, inst);
+  return text;
+}
+
+std::vector<int> defs(const Instruction& inst) {
+  switch (inst.op) {
+    case Op::JAL:
+      // Una llamada puede modificar todos los registros que no preserva el
+      // callee.
+      return {Reg::V0, Reg::V1, Reg::A0, Reg::A1, Reg::A2, Reg::A3,
+              Reg::T0, Reg::T1, Reg::T2, Reg::T3, Reg::T4, Reg::T5,
+              Reg::T6, Reg::T7, Reg::T8, Reg::T9, Reg::RA, Reg::HI,
+              Reg::LO};
+    case Op::SYSCALL:
+      return {Reg::V0};
+    case Op::MULT:
+    case Op::DIV:
+      return {Reg::HI, Reg::LO};
+    default:
+      if (inst.rd >= 0) return {inst.rd};
+      return {};
+  }
+}
+
+std::vector<int> uses(const Instruction& inst) {
+  switch (inst.op) {
+    case Op::JAL:
+    case Op::TAILCALL:
+      return {Reg::A0, Reg::A1, Reg::A2, Reg::A3, Reg::SP};
+    case Op::SYSCALL:
+      return {Reg::V0, Reg::A0};
+    case Op::MFHI:
+      return {Reg::HI};
+    case Op::MFLO:
+      return {Reg::LO};
+    default: {
+      std::vector<int> result;
+      if (inst.rs >= 0) result.push_back(inst.rs);
+      if (inst.rt >= 0) result.push_back(inst.rt);
+      return result;
+    }
+  }
+}
+
+bool hasSideEffects(const Instruction& inst) {
+  switch (inst.op) {
+    case Op::ADD:
+    case Op::ADDU:
+    case Op::SUB:
+    case Op::SUBU:
+    case Op::MUL:
+    case Op::XOR:
+    case Op::SLT:
+    case Op::SLTU:
+    case Op::MULT:
+    case Op::DIV:
+    case Op::MFHI:
+    case Op::MFLO:
+    case Op::ADDIU:
+    case Op::XORI:
+    case Op::SLTIU:
+    case Op::SLL:
+    case Op::SRL:
+    case Op::SRA:
+    case Op::LI:
+    case Op::LA:
+    case Op::MOVE:
+    case Op::LW:
+    case Op::NOP:
+      return false;
+    default:
+      return true;
+  }
+}
+
+bool usesAssemblerTemporary(const Instruction& inst) {
+  bool fits = inst.imm >= -32768 && inst.imm <= 32767;
+  switch (inst.op) {
+    case Op::ADDIU:
+    case Op::SLTIU:
+    case Op::LW:
+    case Op::SW:
+      return !fits && inst.label.empty();
+    case Op::XORI:
+      return inst.imm < 0 || inst.imm > 65535;
+    default:
+      return false;
+  }
+}
+
+Instruction rtype(Op op, int rd, int rs, int rt) {
+  Instruction inst{op};
+  inst.rd = rd;
+  inst.rs = rs;
+  inst.rt = rt;
+  return inst;
+}
+
+Instruction addiu(int rd, int rs, int imm) {
+  Instruction inst{Op::ADDIU};
+  inst.rd = rd;
+  inst.rs = rs;
+  inst.imm = imm;
+  return inst;
+}
+
+Instruction immediate(Op op, int rd, int rs, int imm) {
+  Instruction inst{op};
+  inst.rd = rd;
+  inst.rs = rs;
+  inst.imm = imm;
+  return inst;
+}
+
+Instruction shift(Op op, int rd, int rs, int shamt) {
+  Instruction inst{op};
+  inst.rd = rd;
+  inst.rs = rs;
+  inst.imm = shamt;
+  return inst;
+}
+
+Instruction hilo(Op op, int rs, int rt) {
+  Instruction inst{op};
+  inst.rs = rs;
+  inst.rt = rt;
+  return inst;
+}
+
+Instruction moveFrom(Op op, int rd) {
+  Instruction inst{op};
+  inst.rd = rd;
+  return inst;
+}
+
+Instruction li(int rd, int imm) {
+  Instruction inst{Op::LI};
+  inst.rd = rd;
+  inst.imm = imm;
+  return inst;
+}
+
+Instruction la(int rd, const std::string& symbol) {
+  Instruction inst{Op::LA};
+  inst.rd = rd;
+  inst.label = symbol;
+  return inst;
+}
+
+Instruction move(int rd, int rs) {
+  Instruction inst{Op::MOVE};
+  inst.rd = rd;
+  inst.rs = rs;
+  return inst;
+}
+
+Instruction lw(int rd, int offset, int base) {
+  Instruction inst{Op::LW};
+  inst.rd = rd;
+  inst.rs = base;
+  inst.imm = offset;
+  return inst;
+}
+
+Instruction sw(int rt, int offset, int base) {
+  Instruction inst{Op::SW};
+  inst.rt = rt;
+  inst.rs = base;
+  inst.imm = offset;
+  return inst;
+}
+
+Instruction gpRelative(Op op, int reg, const std::string& symbol,
+                       int offset) {
+  Instruction inst{op};
+  if (op == Op::SW) {
+    inst.rt = reg;
+  } else {
+    inst.rd = reg;
+  }
+  inst.rs = Reg::GP;
+  inst.imm = offset;
+  inst.label = symbol;
+  return inst;
+}
+
+Instruction branch(Op op, int rs, int rt, const std::string& target) {
+  Instruction inst{op};
+  inst.rs = rs;
+  inst.rt = rt;
+  inst.label = target;
+  return inst;
+}
+
+Instruction branchZero(Op op, int rs, const std::string& target) {
+  Instruction inst{op};
+  inst.rs = rs;
+  inst.label = target;
+  return inst;
+}
+
+Op invertBranch(Op op) {
+  switch (op) {
+    case Op::BEQ:
+      return Op::BNE;
+    case Op::BNE:
+      return Op::BEQ;
+    case Op::BLEZ:
+      return Op::BGTZ;
+    case Op::BGTZ:
+      return Op::BLEZ;
+    case Op::BLTZ:
+      return Op::BGEZ;
+    case Op::BGEZ:
+      return Op::BLTZ;
+    default:
+      return op;
+  }
+}
+
+Instruction jump(Op op, const std::string& target) {
+  Instruction inst{op};
+  inst.label = target;
+  return inst;
+}
+
+Instruction jr(int rs) {
+  Instruction inst{Op::JR};
+  inst.rs = rs;
+  return inst;
+}
+
+Instruction tailCall(const std::string& target) {
+  Instruction inst{Op::TAILCALL};
+  inst.label = target;
+  return inst;
+}
+
+Instruction syscall() { return Instruction{Op::SYSCALL}; }
+
+Instruction nop() { return Instruction{Op::NOP}; }
+
+Instruction boundsCheck(int index, int size) {
+  Instruction inst{Op::CHECK};
+  inst.rs = index;
+  inst.imm = size;
+  return inst;
+}
+
+Instruction label(const std::string& name) {
+  Instruction inst{Op::LABEL};
+  inst.label = name;
+  return inst;
+}
+
+Instruction comment(const std::string& text) {
+  Instruction inst{Op::COMMENT};
+  inst.label = text;
+  return inst;
+}
+
+}  // namespace Mips
@@ -0,0 +1,203 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de la representación en memoria de las
+ *  instrucciones MIPS que genera el CodeGenerator.
+ * */
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+// Números de los registros físicos de MIPS.
+namespace Reg {
+enum : int {
+  ZERO = 0,
+  AT = 1,
+  V0 = 2,
+  V1 = 3,
+  A0 = 4,
+  A1 = 5,
+  A2 = 6,
+  A3 = 7,
+  T0 = 8,
+  T1 = 9,
+  T2 = 10,
+  T3 = 11,
+  T4 = 12,
+  T5 = 13,
+  T6 = 14,
+  T7 = 15,
+  S0 = 16,
+  S7 = 23,
+  T8 = 24,
+  T9 = 25,
+  GP = 28,
+  SP = 29,
+  FP = 30,
+  RA = 31,
+  // HI y LO no son direccionables, pero los tratamos como registros para
+  // que el análisis de liveness vea las dependencias de mult/div.
+  HI = 32,
+  LO = 33,
+  // Del 64 en adelante son registros virtuales; el generador usa uno nuevo
+  // por cada valor y el asignador de registros los cambia por físicos.
+  VIRTUAL = 64,
+};
+// Los primeros argumentos de una llamada van en $a0-$a3; el resto se pasa en
+// el stack.
+constexpr int ARG_REGS = 4;
+}  // namespace Reg
+
+enum class Op {
+  // Aritméticas y lógicas (rd = rs op rt)
+  ADD,
+  ADDU,
+  SUB,
+  SUBU,
+  MUL,
+  XOR,
+  SLT,
+  SLTU,
+  // Multiplicación y división en HI/LO (rs op rt)
+  MULT,
+  DIV,
+  MFHI,
+  MFLO,
+  // Inmediatas y corrimientos (rd = rs op imm)
+  ADDIU,
+  XORI,
+  SLTIU,
+  SLL,
+  SRL,
+  SRA,
+  // Movimiento de datos
+  LI,
+  LA,
+  MOVE,
+  LW,
+  SW,
+  // Control de flujo
+  BEQ,
+  BNE,
+  // Comparan rs contra cero
+  BLEZ,
+  BGTZ,
+  BLTZ,
+  BGEZ,
+  J,
+  JAL,
+  JR,
+  SYSCALL,
+  NOP,
+  // Llamada en posición de cola: el epílogo se pone antes del salto cuando
+  // se arma el frame.
+  TAILCALL,
+  // Revisa que 0 <= rs < imm. Antes de asignar registros se quita o se
+  // cambia por sltiu + beq al manejador de error.
+  CHECK,
+  // Pseudo-instrucciones que solo existen en el listado
+  LABEL,
+  COMMENT,
+};
+
+/*
+ *  Todas las instrucciones usan la misma forma normalizada: rd es siempre el
+ *  registro destino, rs y rt son las fuentes. En lw/sw rs es la base e imm el
+ *  desplazamiento; en sw rt es el valor que se guarda. label guarda el destino
+ *  de un salto, el símbolo de un la, el nombre de una etiqueta o el texto de un
+ *  comentario. Un lw, sw o addiu con base $gp y label es relativo a un global
+ *  de .sdata: el desplazamiento real es %gp_rel(label + imm).
+ * */
+struct Instruction {
+  Op op;
+  int rd = -1;
+  int rs = -1;
+  int rt = -1;
+  int imm = 0;
+  std::string label;
+
+  // Los campos se llenan con los constructores de Mips::.
+  explicit Instruction(Op op = Op::NOP) : op(op) {}
+
+  bool isLabel() const { return op == Op::LABEL; }
+  bool isComment() const { return op == Op::COMMENT; }
+  bool isBranch() const {
+    return op == Op::BEQ || op == Op::BNE || op == Op::BLEZ ||
+           op == Op::BGTZ || op == Op::BLTZ || op == Op::BGEZ;
+  }
+  // Instrucciones después de las cuales el flujo nunca continúa en la
+  // siguiente.
+  bool endsBlock() const {
+    return op == Op::J || op == Op::JR || op == Op::TAILCALL;
+  }
+  bool hasTarget() const { return isBranch() || op == Op::J; }
+};
+
+struct MachineFunction {
+  std::string name;
+  std::vector<Instruction> code;
+  std::string exitLabel;
+  int numParams = 0;
+  int stackParams() const {
+    return numParams > Reg::ARG_REGS ? numParams - Reg::ARG_REGS : 0;
+  }
+  int localsSize = 0;
+  // Los primeros bytes de las variables locales (desde -8($fp) hacia abajo)
+  // son los slots de los valores que el asignador mandó al stack.
+  int spillSize = 0;
+  bool returnsValue = false;
+  // Desplazamientos respecto a $fp de las variables escalares. Solo estos
+  // slots se consideran en el análisis de liveness de memoria.
+  std::set<int> scalarSlots;
+  // Registros $s que usó el asignador; el prólogo los guarda y el epílogo
+  // los restaura.
+  std::vector<int> savedRegs;
+  int nextVirtual = Reg::VIRTUAL;
+
+  int newVirtual() { return nextVirtual++; }
+};
+
+namespace Mips {
+std::string regName(int reg);
+bool isVirtual(int reg);
+std::string toString(const Instruction& inst);
+// Como toString, pero agrega el texto al final de out sin crear strings
+// intermedios.
+void appendTo(std::string& out, const Instruction& inst);
+
+std::vector<int> defs(const Instruction& inst);
+std::vector<int> uses(const Instruction& inst);
+bool hasSideEffects(const Instruction& inst);
+// Si el ensamblador la expande a varias instrucciones que pasan por $at: un
+// inmediato o desplazamiento que no cabe en 16 bits. li y la no cuentan,
+// arman el valor en su propio destino.
+bool usesAssemblerTemporary(const Instruction& inst);
+
+Instruction rtype(Op op, int rd, int rs, int rt);
+Instruction addiu(int rd, int rs, int imm);
+Instruction immediate(Op op, int rd, int rs, int imm);
+Instruction shift(Op op, int rd, int rs, int shamt);
+Instruction hilo(Op op, int rs, int rt);
+Instruction moveFrom(Op op, int rd);
+Instruction li(int rd, int imm);
+Instruction la(int rd, const std::string& symbol);
+Instruction move(int rd, int rs);
+Instruction lw(int rd, int offset, int base);
+Instruction sw(int rt, int offset, int base);
+// lw, sw o addiu de %gp_rel(symbol + offset)($gp).
+Instruction gpRelative(Op op, int reg, const std::string& symbol,
+                       int offset = 0);
+Instruction branch(Op op, int rs, int rt, const std::string& target);
+Instruction branchZero(Op op, int rs, const std::string& target);
+// El branch que salta exactamente cuando el original no salta.
+Op invertBranch(Op op);
+Instruction jump(Op op, const std::string& target);
+Instruction jr(int rs);
+Instruction tailCall(const std::string& target);
+Instruction syscall();
+Instruction nop();
+Instruction boundsCheck(int index, int size);
+Instruction label(const std::string& name);
+Instruction comment(const std::string& text);
+}  // namespace Mips
@@ -149,9 +149,10 @@ ExpressionStatementNode* Parser::parseExpressionStatement() {
 
 ExpressionNode* Parser::parseExpression() { return parseSimpleExpression(); }
 
-AssignmentExpressionNode* Parser::parseAssignmentExpression() {
+AssignmentExpressionNode* Parser::parseAssignmentExpression(
+    std::unique_ptr<VarNode> var) {
   auto node = std::make_unique<AssignmentExpressionNode>(lineno, position);
-  node->var = std::unique_ptr<VarNode>(parseVar(mostRecentId));
+  node->var = std::move(var);
   match(TokenType::ASSIGN);
   node->simpleExpression =
       std::unique_ptr<ExpressionNode>(parseSimpleExpression());
@@ -163,7 +164,17 @@ ExpressionNode* Parser::parseSimpleExpression() {
   node->additiveLeft =
       std::unique_ptr<AdditiveExpressionNode>(parseAdditiveExpression());
   if (currToken == TokenType::ASSIGN) {
-    return parseAssignmentExpression();
+    // Lo que ya se leyó tiene que ser una sola variable, con todo y su
+    // subíndice.
+    AdditiveExpressionNode* add = node->additiveLeft.get();
+    TermNode* term = add->rightTerm ? nullptr : add->leftTerm.get();
+    FactorNode* factor =
+        term && !term->rightFactor ? term->leftFactor.get() : nullptr;
+    if (!factor || !factor->var) {
+      throw ParserSyntaxError("Invalid assignment target on line " +
+                              std::to_string(lexer.getLineNo()));
+    }
+    return parseAssignmentExpression(std::move(factor->var));
   }
   if (currToken == TokenType::LT || currToken == TokenType::LTE ||
       currToken == TokenType::GT || currToken == TokenType::GTE ||
@@ -289,6 +300,11 @@ ParamNode* Parser::parseParam() {
   }
 
   auto node = std::make_unique<ParamNode>(type, name, lineno, position);
+  if (currToken == TokenType::O_BRACKET) {
+    match(TokenType::O_BRACKET);
+    match(TokenType::C_BRACKET);
+    node->isArray = true;
+  }
   return node.release();
 }
 
@@ -495,5 +511,5 @@ void VarNode::print(int depth) {
 void ParamNode::print(int depth) {
   indent(depth);
   std::cout << "ParamNode: " << id << " : " << tokenTypeToString(type)
-            << std::endl;
+            << (isArray ? " []" : "") << std::endl;
 }
@@ -51,6 +51,8 @@ class ParamNode : public TreeNode<ParamNode> {
  public:
   TokenType type;
   std::string id;
+  // int a[]: el arreglo llega por referencia.
+  bool isArray = false;
 
   void print(int depth);
   ParamNode(TokenType t, const std::string& i, int line, int pos)
@@ -261,7 +263,8 @@ class Parser {
   IterationStatementNode* parseIterationStatement();
   ReturnStatementNode* parseReturnStatement();
   ExpressionNode* parseExpression();
-  AssignmentExpressionNode* parseAssignmentExpression();
+  AssignmentExpressionNode* parseAssignmentExpression(
+      std::unique_ptr<VarNode> var);
   ExpressionNode* parseSimpleExpression();
   AdditiveExpressionNode* parseAdditiveExpression();
   TermNode* parseTerm();
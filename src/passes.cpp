@@ -0,0 +1,448 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del manejador de pasadas.
+ * */
+#include "passes.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "astutil.hpp"
+#include "codegen.hpp"
+#include "colors.hpp"
+#include "cse.hpp"
+#include "dce.hpp"
+#include "peephole.hpp"
+#include "strength.hpp"
+
+// Las pasadas de cada nivel, en el orden en que corren; las de cada tipo
+// (árbol, módulo, función) corren en el orden en que aparecen aquí.
+// regalloc y frame son las que convierten el código en MIPS real, bounds
+// baja las revisiones de -fbounds-check y delay-slots llena los de
+// -fdelayed-branch, así que están en todos los niveles. -O2 agrega las que
+// hacen crecer el código o tardan más: unroll y schedule. La lista de -O2
+// tiene todas las pasadas, así que también da el orden de las que se prenden
+// con -f en otro nivel.
+static const std::vector<std::string>& pipeline(OptLevel level) {
+  static const std::vector<std::string> o0 = {"bounds", "regalloc", "frame",
+                                              "delay-slots"};
+  static const std::vector<std::string> o1 = {
+      // Sobre el árbol.
+      "ipa", "ctfe", "iv-strength",
+      // Sobre todas las funciones.
+      "inline",
+      // Sobre cada función.
+      "strength", "bounds", "cse", "dce", "promote", "licm", "regalloc",
+      "frame", "peephole", "delay-slots"};
+  static const std::vector<std::string> o2 = {
+      "ipa", "ctfe", "unroll", "iv-strength", "inline", "strength", "bounds",
+      "cse", "dce", "promote", "licm", "regalloc", "frame", "peephole",
+      "schedule", "delay-slots"};
+  switch (level) {
+    case OptLevel::O0:
+      return o0;
+    case OptLevel::O1:
+      return o1;
+    default:
+      return o2;
+  }
+}
+
+OptLevel parseOptLevel(const std::string& flag, OptLevel current) {
+  if (flag == "-O0") return OptLevel::O0;
+  if (flag == "-O1" || flag == "-O") return OptLevel::O1;
+  if (flag == "-O2" || flag == "-O3") return OptLevel::O2;
+  return current;
+}
+
+std::string optLevelName(OptLevel level) {
+  switch (level) {
+    case OptLevel::O0:
+      return "-O0";
+    case OptLevel::O1:
+      return "-O1";
+    default:
+      return "-O2";
+  }
+}
+
+void AnalysisCache::invalidate(const std::set<std::string>& preserved) {
+  for (auto it = results.begin(); it != results.end();) {
+    if (preserved.count(it->first)) {
+      ++it;
+    } else {
+      it = results.erase(it);
+    }
+  }
+}
+
+// Memoria residente del proceso en este momento, en KB. Es la segunda
+// columna de /proc/self/statm, en páginas; donde no existe se reporta 0.
+static long residentMemoryKb() {
+  std::ifstream statm("/proc/self/statm");
+  long size = 0, resident = 0;
+  if (!(statm >> size >> resident)) return 0;
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static long treeSize(ProgramNode* program) {
+  long size = 0;
+  for (auto& decl : program->declarationList) {
+    auto fun = dynamic_cast<FunDeclarationNode*>(decl.get());
+    if (!fun || !fun->compoundStatement) continue;
+    forEachStatement(fun->compoundStatement.get(), [&](StatementNode*) {
+      size++;
+    });
+    forEachExpression(fun->compoundStatement.get(),
+                      [&](ExpressionNode*) { size++; });
+  }
+  return size;
+}
+
+void PassManager::setEnabled(const std::string& name, bool enabled) {
+  overrides[name] = enabled;
+}
+
+bool PassManager::runs(const std::string& name) const {
+  auto it = overrides.find(name);
+  if (it != overrides.end()) return it->second;
+  const auto& names = pipeline(level);
+  return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+void PassManager::addTreePass(const std::string& name, TreePass pass,
+                              std::set<std::string> preserved) {
+  treePasses[name] = {std::move(pass), std::move(preserved)};
+}
+
+void PassManager::addModulePass(const std::string& name, ModulePass pass,
+                                std::set<std::string> preserved) {
+  modulePasses[name] = {std::move(pass), std::move(preserved)};
+}
+
+void PassManager::addFunctionPass(const std::string& name, FunctionPass pass,
+                                  std::set<std::string> preserved) {
+  functionPasses[name] = {std::move(pass), std::move(preserved)};
+}
+
+template <typename Pass, typename Unit>
+void PassManager::runPipeline(std::map<std::string, Registered<Pass>>& passes,
+                              Unit& unit, const std::string& unitName,
+                              const std::function<long()>& size) {
+  for (const auto& name : pipeline(OptLevel::O2)) {
+    auto it = passes.find(name);
+    if (it == passes.end() || !runs(name)) continue;
+
+    PassStatistics& stat = stats[name];
+    stat.name = name;
+    stat.unit = unitName;
+    stat.runs++;
+    stat.sizeBefore += size();
+    long memory = residentMemoryKb();
+    auto start = std::chrono::steady_clock::now();
+    it->second.run(unit);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    stat.milliseconds += elapsed.count();
+    stat.memoryKb += residentMemoryKb() - memory;
+    stat.sizeAfter += size();
+
+    analyses.invalidate(it->second.preserved);
+  }
+}
+
+void PassManager::runTreePasses(ProgramNode* program) {
+  runPipeline(treePasses, program, "nodos",
+              [&]() { return treeSize(program); });
+}
+
+void PassManager::runModulePasses(std::vector<MachineFunction>& functions) {
+  runPipeline(modulePasses, functions, "instrucciones", [&]() {
+    long size = 0;
+    for (const auto& fn : functions) size += fn.code.size();
+    return size;
+  });
+}
+
+void PassManager::runFunctionPasses(MachineFunction& fn) {
+  runPipeline(functionPasses, fn, "instrucciones",
+              [&]() { return (long)fn.code.size(); });
+}
+
+std::vector<PassStatistics> PassManager::statistics() const {
+  std::vector<PassStatistics> result;
+  for (const auto& name : pipeline(OptLevel::O2)) {
+    auto it = stats.find(name);
+    if (it != stats.end()) result.push_back(it->second);
+  }
+  return result;
+}
+
+void registerPasses(PassManager& passes, CodeGenerator& codegen,
+                    PassReports& reports) {
+  passes.addTreePass("ipa", [&](ProgramNode* program) {
+    reports.interprocedural = optimizeInterprocedural(program);
+  });
+  passes.addTreePass("ctfe", [&](ProgramNode* program) {
+    auto& pure = reports.interprocedural.pure;
+    reports.evaluatedCalls =
+        evaluateConstantCalls(program, pure, codegen.constevalBudget);
+    // Las funciones que solo se llamaban con constantes ya no hacen falta.
+    std::vector<std::string> evaluatedAway;
+    removeUnreachableFunctions(program, evaluatedAway);
+    for (const auto& id : evaluatedAway) {
+      pure.erase(std::remove(pure.begin(), pure.end(), id), pure.end());
+      reports.interprocedural.removed.push_back(id);
+    }
+  });
+  passes.addTreePass("unroll", [&](ProgramNode* program) {
+    reports.unrollDecisions = unrollLoops(program, codegen.unrollFactor);
+  });
+  passes.addTreePass("iv-strength", [](ProgramNode* program) {
+    reduceInductionMultiplies(program);
+  });
+
+  passes.addModulePass("inline", [&](std::vector<MachineFunction>& fns) {
+    reports.inlineDecisions = inlineFunctions(fns);
+  });
+
+  // Lo que cada función lee y escribe de los globales solo cambia al
+  // copiar funciones en otras; las pasadas por función lo preservan.
+  const std::set<std::string> keepsModRef = {"modref"};
+  passes.addFunctionPass(
+      "strength", [](MachineFunction& fn) { reduceStrength(fn); },
+      keepsModRef);
+  if (codegen.boundsCheck) {
+    passes.addFunctionPass(
+        "bounds",
+        [&](MachineFunction& fn) {
+          BoundsReport report = eliminateBoundsChecks(fn);
+          if (report.removed < report.checks) {
+            codegen.needsBoundsHandler = true;
+          }
+          if (report.checks > 0) reports.bounds.push_back({fn.name, report});
+        },
+        keepsModRef);
+  }
+  passes.addFunctionPass(
+      "cse", [](MachineFunction& fn) { eliminateCommonSubexpressions(fn); },
+      keepsModRef);
+  passes.addFunctionPass(
+      "dce", [](MachineFunction& fn) { eliminateDeadCode(fn); }, keepsModRef);
+  passes.addFunctionPass(
+      "promote",
+      [&](MachineFunction& fn) {
+        const ModRefTable& modRef = passes.analyses.get<ModRefTable>(
+            "modref", [&]() { return computeModRef(codegen.functions); });
+        for (const auto& report :
+             promoteGlobals(fn, modRef, codegen.globalScalars)) {
+          reports.promotions.push_back({fn.name, report});
+        }
+      },
+      keepsModRef);
+  passes.addFunctionPass(
+      "licm",
+      [&](MachineFunction& fn) {
+        for (const auto& report : hoistLoopInvariants(fn)) {
+          reports.loops.push_back({fn.name, report});
+        }
+      },
+      keepsModRef);
+  passes.addFunctionPass(
+      "regalloc",
+      [&](MachineFunction& fn) {
+        reports.allocations.push_back({fn.name, allocateRegisters(fn)});
+      },
+      keepsModRef);
+  passes.addFunctionPass(
+      "frame", [&](MachineFunction& fn) { codegen.lowerFrame(fn); },
+      keepsModRef);
+  passes.addFunctionPass(
+      "peephole",
+      [&](MachineFunction& fn) { runPeephole(fn, reports.peepholeHits); },
+      keepsModRef);
+  passes.addFunctionPass(
+      "schedule",
+      [&](MachineFunction& fn) {
+        reports.schedules.push_back(
+            {fn.name, scheduleFunction(fn, true, false)});
+      },
+      keepsModRef);
+  if (codegen.delaySlots) {
+    passes.addFunctionPass(
+        "delay-slots",
+        [&](MachineFunction& fn) {
+          ScheduleReport filled = scheduleFunction(fn, false, true);
+          // Si schedule ya reordenó la función, se completa su reporte.
+          auto& schedules = reports.schedules;
+          if (schedules.empty() || schedules.back().first != fn.name) {
+            schedules.push_back({fn.name, filled});
+            return;
+          }
+          ScheduleReport& report = schedules.back().second;
+          report.loadUseAfter = filled.loadUseAfter;
+          report.filledSlots = filled.filledSlots;
+          report.nops = filled.nops;
+        },
+        keepsModRef);
+  }
+}
+
+void printPassReports(const PassReports& reports, const PassManager& passes,
+                      const CodeGenerator& codegen) {
+  const InterproceduralReport& interprocedural = reports.interprocedural;
+  bool anyInterprocedural = !interprocedural.specializations.empty() ||
+                            !interprocedural.pure.empty() ||
+                            !interprocedural.removed.empty();
+  if (anyInterprocedural) {
+    std::cout << Style::bold("\nInterprocedural:\n");
+    for (const auto& spec : interprocedural.specializations) {
+      std::cout << "  " << Style::cyan(spec.function);
+      if (!spec.clone.empty()) std::cout << " -> " << Style::cyan(spec.clone);
+      std::cout << ":";
+      for (const auto& constant : spec.constants) std::cout << " " << constant;
+      std::cout << (spec.clone.empty() ? " en todas las llamadas\n" : "\n");
+    }
+    if (!interprocedural.pure.empty()) {
+      std::cout << "  " << Style::green("puras") << ":";
+      for (const auto& id : interprocedural.pure) std::cout << " " << id;
+      std::cout << "\n";
+    }
+    if (!interprocedural.removed.empty()) {
+      std::cout << "  " << Style::yellow("eliminadas") << ":";
+      for (const auto& id : interprocedural.removed) std::cout << " " << id;
+      std::cout << "\n";
+    }
+  }
+
+  if (!reports.evaluatedCalls.empty()) {
+    std::cout << Style::bold("\nCompile-time evaluation:\n");
+    int folded = 0;
+    for (const auto& call : reports.evaluatedCalls) {
+      std::cout << "  " << Style::cyan(call.caller) << ": " << call.call;
+      if (call.folded) {
+        folded++;
+        std::cout << " = " << Style::green(std::to_string(call.value));
+      } else {
+        std::cout << ": " << Style::yellow(call.reason);
+      }
+      std::cout << " (" << call.steps << " pasos)\n";
+    }
+    std::cout << "  " << folded << " de " << reports.evaluatedCalls.size()
+              << " llamadas evaluadas, límite de " << codegen.constevalBudget
+              << " pasos por llamada\n";
+  }
+
+  if (!reports.unrollDecisions.empty()) {
+    std::cout << Style::bold("\nLoop unrolling:\n");
+    for (const auto& decision : reports.unrollDecisions) {
+      std::cout << "  " << Style::cyan(decision.function) << " (línea "
+                << decision.line << "): ";
+      if (decision.factor == 0) {
+        std::cout << Style::green("completo") << " (" << decision.trips
+                  << " vueltas)\n";
+      } else {
+        bool exact = decision.trips >= 0 &&
+                     decision.trips % decision.factor == 0;
+        std::cout << Style::green("x" + std::to_string(decision.factor))
+                  << (exact ? " sin loop de residuo\n"
+                            : " con loop de residuo\n");
+      }
+    }
+  }
+
+  if (!reports.inlineDecisions.empty()) {
+    std::cout << Style::bold("\nInlining:\n");
+    for (const auto& decision : reports.inlineDecisions) {
+      std::cout << "  " << Style::cyan(decision.caller) << " -> "
+                << Style::cyan(decision.callee) << ": "
+                << (decision.inlined ? Style::green("inline")
+                                     : Style::yellow("llamada"))
+                << " (" << decision.reason << ")\n";
+    }
+  }
+
+  if (!reports.promotions.empty()) {
+    std::cout << Style::bold("\nGlobal promotion:\n");
+    for (const auto& [function, report] : reports.promotions) {
+      std::cout << "  " << Style::cyan(function) << " "
+                << Style::yellow(report.loop) << ":";
+      for (const auto& global : report.globals) std::cout << " " << global;
+      std::cout << " en registros\n";
+    }
+  }
+
+  if (!reports.loops.empty()) {
+    std::cout << Style::bold("\nLoop-invariant code motion:\n");
+    for (const auto& [function, report] : reports.loops) {
+      std::cout << "  " << Style::cyan(function) << " "
+                << Style::yellow(report.loop) << ": " << report.hoisted
+                << " instrucciones movidas al preheader\n";
+    }
+  }
+
+  std::cout << Style::bold("\nRegister allocation:\n");
+  for (const auto& [function, report] : reports.allocations) {
+    std::cout << "  " << Style::cyan(function) << ": " << report.virtuals
+              << " registros virtuales, " << report.spilled
+              << " en el stack (" << report.spillLoads << " lw, "
+              << report.spillStores << " sw), " << report.calleeSaved
+              << " registros $s guardados\n";
+  }
+
+  if (!reports.peepholeHits.empty()) {
+    std::cout << Style::bold("\nPeephole:\n");
+    for (const auto& [rule, count] : reports.peepholeHits) {
+      std::cout << "  " << Style::yellow(rule) << ": " << count << "\n";
+    }
+  }
+
+  if (!reports.bounds.empty()) {
+    std::cout << Style::bold("\nBounds checks:\n");
+    for (const auto& [function, report] : reports.bounds) {
+      std::cout << "  " << Style::cyan(function) << ": " << report.removed
+                << " de " << report.checks
+                << " revisiones eliminadas por el análisis de rangos\n";
+    }
+  }
+
+  if (!reports.schedules.empty()) {
+    std::cout << Style::bold("\nScheduling:\n");
+    for (const auto& [function, report] : reports.schedules) {
+      std::cout << "  " << Style::cyan(function) << ": "
+                << report.loadUseBefore << " -> " << report.loadUseAfter
+                << " lw seguidos de su uso";
+      if (codegen.delaySlots) {
+        std::cout << ", " << report.filledSlots << " delay slots llenados, "
+                  << report.nops << " nop";
+      }
+      std::cout << "\n";
+    }
+  }
+
+  std::cout << Style::bold("\nPasses (" + optLevelName(passes.getLevel()) +
+                           "):\n");
+  for (const auto& stat : passes.statistics()) {
+    std::ostringstream time;
+    time << std::fixed << std::setprecision(3) << stat.milliseconds;
+    std::cout << "  " << Style::cyan(stat.name) << ": " << time.str()
+              << " ms, " << stat.sizeBefore << " -> " << stat.sizeAfter << " "
+              << stat.unit;
+    if (stat.runs > 1) std::cout << " en " << stat.runs << " funciones";
+    std::cout << ", " << (stat.memoryKb >= 0 ? "+" : "") << stat.memoryKb
+              << " KB\n";
+  }
+  for (const auto& [name, times] : passes.analyses.computed) {
+    std::cout << "  " << Style::green(name) << " calculado " << times
+              << (times == 1 ? " vez\n" : " veces\n");
+  }
+}
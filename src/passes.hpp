@@ -0,0 +1,148 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del manejador de pasadas.
+ * */
+#pragma once
+
+#include <any>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bounds.hpp"
+#include "ctfe.hpp"
+#include "inline.hpp"
+#include "ipa.hpp"
+#include "licm.hpp"
+#include "mips.hpp"
+#include "parser.hpp"
+#include "promote.hpp"
+#include "regalloc.hpp"
+#include "schedule.hpp"
+#include "unroll.hpp"
+
+class CodeGenerator;
+
+// -O0 solo hace lo necesario para generar código, -O1 corre las
+// optimizaciones baratas y -O2 agrega las que hacen crecer el código o
+// tardan más (desenrollar loops y reordenar instrucciones).
+enum class OptLevel { O0, O1, O2 };
+
+OptLevel parseOptLevel(const std::string& flag, OptLevel current);
+std::string optLevelName(OptLevel level);
+
+struct PassStatistics {
+  std::string name;
+  // Sobre qué trabaja: el árbol ("nodos") o el código MIPS
+  // ("instrucciones").
+  std::string unit;
+  int runs = 0;
+  double milliseconds = 0;
+  // Tamaño antes y después, sumado sobre todas las veces que corrió.
+  long sizeBefore = 0;
+  long sizeAfter = 0;
+  // Cuánto cambió la memoria residente del compilador mientras corría, en
+  // KB; es negativo si la pasada liberó más de lo que pidió.
+  long memoryKb = 0;
+};
+
+// Resultados de análisis que comparten varias pasadas. Se calculan la
+// primera vez que se piden y se tiran cuando corre una pasada que no dice
+// preservarlos.
+class AnalysisCache {
+ public:
+  template <typename T>
+  const T& get(const std::string& name, const std::function<T()>& compute) {
+    auto it = results.find(name);
+    if (it == results.end()) {
+      computed[name]++;
+      it = results.emplace(name, compute()).first;
+    }
+    return std::any_cast<const T&>(it->second);
+  }
+  void invalidate(const std::set<std::string>& preserved);
+  // Veces que se calculó cada análisis.
+  std::map<std::string, int> computed;
+
+ private:
+  std::map<std::string, std::any> results;
+};
+
+// Registra las pasadas que sabe hacer el compilador y las corre en el orden
+// del pipeline del nivel de optimización; las que el nivel no incluye se
+// saltan, a menos que se prendan con setEnabled. Hay pasadas sobre el
+// árbol, sobre todas las funciones ya generadas y sobre cada función.
+class PassManager {
+ public:
+  using TreePass = std::function<void(ProgramNode*)>;
+  using ModulePass = std::function<void(std::vector<MachineFunction>&)>;
+  using FunctionPass = std::function<void(MachineFunction&)>;
+
+  AnalysisCache analyses;
+
+  explicit PassManager(OptLevel level) : level(level) {}
+
+  void addTreePass(const std::string& name, TreePass pass,
+                   std::set<std::string> preserved = {});
+  void addModulePass(const std::string& name, ModulePass pass,
+                     std::set<std::string> preserved = {});
+  void addFunctionPass(const std::string& name, FunctionPass pass,
+                       std::set<std::string> preserved = {});
+
+  void runTreePasses(ProgramNode* program);
+  void runModulePasses(std::vector<MachineFunction>& functions);
+  void runFunctionPasses(MachineFunction& fn);
+
+  // Prende o apaga una pasada sin importar el nivel, como las banderas -f.
+  void setEnabled(const std::string& name, bool enabled);
+  bool runs(const std::string& name) const;
+
+  OptLevel getLevel() const { return level; }
+  // Estadísticas en el orden del pipeline, sin las pasadas que no corrieron.
+  std::vector<PassStatistics> statistics() const;
+
+ private:
+  template <typename Pass>
+  struct Registered {
+    Pass run;
+    std::set<std::string> preserved;
+  };
+
+  OptLevel level;
+  std::map<std::string, bool> overrides;
+  std::map<std::string, Registered<TreePass>> treePasses;
+  std::map<std::string, Registered<ModulePass>> modulePasses;
+  std::map<std::string, Registered<FunctionPass>> functionPasses;
+  std::map<std::string, PassStatistics> stats;
+
+  template <typename Pass, typename Unit>
+  void runPipeline(std::map<std::string, Registered<Pass>>& passes,
+                   Unit& unit, const std::string& unitName,
+                   const std::function<long()>& size);
+};
+
+// Lo que dejó cada pasada, para el resumen que imprime main.cpp.
+struct PassReports {
+  InterproceduralReport interprocedural;
+  std::vector<EvaluatedCall> evaluatedCalls;
+  std::vector<UnrollDecision> unrollDecisions;
+  std::vector<InlineDecision> inlineDecisions;
+  std::vector<std::pair<std::string, PromotionReport>> promotions;
+  std::vector<std::pair<std::string, LoopMotionReport>> loops;
+  std::vector<std::pair<std::string, AllocationReport>> allocations;
+  std::map<std::string, int> peepholeHits;
+  std::vector<std::pair<std::string, BoundsReport>> bounds;
+  std::vector<std::pair<std::string, ScheduleReport>> schedules;
+};
+
+// Registra en passes todas las pasadas que sabe hacer codegen, con las
+// opciones que tiene; cuáles corren lo decide el pipeline. Cada pasada deja
+// su resultado en reports, que tiene que vivir hasta después de generate().
+void registerPasses(PassManager& passes, CodeGenerator& codegen,
+                    PassReports& reports);
+// Imprime lo que hicieron las pasadas y sus estadísticas.
+void printPassReports(const PassReports& reports, const PassManager& passes,
+                      const CodeGenerator& codegen);
@@ -0,0 +1,233 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del optimizador peephole.
+ * */
+#include "peephole.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cfg.hpp"
+#include "mips.hpp"
+
+namespace {
+
+// Lo que ven las reglas: el código, lo vivo después de cada instrucción y
+// dónde está cada etiqueta.
+struct Window {
+  const std::vector<Instruction>& code;
+  const std::vector<std::set<int>>& liveAfter;
+  const std::unordered_map<std::string, int>& labels;
+};
+
+// Una regla que coincide en la posición i reemplaza `length` instrucciones
+// por `replacement`.
+struct Rewrite {
+  int length = 0;
+  std::vector<Instruction> replacement;
+};
+
+using RuleFn = bool (*)(const Window& w, int i, Rewrite& out);
+
+struct PeepholeRule {
+  const char* name;
+  RuleFn apply;
+};
+
+}  // namespace
+
+// move r, r
+static bool selfMove(const Window& w, int i, Rewrite& out) {
+  const Instruction& inst = w.code[i];
+  if (inst.op != Op::MOVE || inst.rd != inst.rs) return false;
+  out.length = 1;
+  return true;
+}
+
+// addiu r, r, 0
+static bool addZero(const Window& w, int i, Rewrite& out) {
+  const Instruction& inst = w.code[i];
+  if (inst.op != Op::ADDIU || inst.rd != inst.rs || inst.imm != 0) {
+    return false;
+  }
+  out.length = 1;
+  return true;
+}
+
+// Una instrucción sin efectos secundarios cuyo resultado nadie lee, como un
+// move que se sobreescribe enseguida.
+static bool deadDef(const Window& w, int i, Rewrite& out) {
+  const Instruction& inst = w.code[i];
+  if (inst.isLabel() || inst.isComment() || Mips::hasSideEffects(inst)) {
+    return false;
+  }
+  for (int d : Mips::defs(inst)) {
+    if (w.liveAfter[i].count(d)) return false;
+  }
+  out.length = 1;
+  return true;
+}
+
+// op t, ...; move d, t  ->  op d, ...  si t ya no se usa.
+static bool foldMove(const Window& w, int i, Rewrite& out) {
+  if (i + 1 >= (int)w.code.size()) return false;
+  const Instruction& inst = w.code[i];
+  const Instruction& move = w.code[i + 1];
+  if (move.op != Op::MOVE || move.rs != inst.rd || move.rd == move.rs) {
+    return false;
+  }
+  auto defs = Mips::defs(inst);
+  if (defs.size() != 1 || defs[0] != inst.rd || Mips::hasSideEffects(inst)) {
+    return false;
+  }
+  if (w.liveAfter[i + 1].count(inst.rd)) return false;
+  Instruction folded = inst;
+  folded.rd = move.rd;
+  out.length = 2;
+  out.replacement = {folded};
+  return true;
+}
+
+// sw r, X(b); lw d, X(b)  ->  sw r, X(b); move d, r
+static bool storeLoad(const Window& w, int i, Rewrite& out) {
+  if (i + 1 >= (int)w.code.size()) return false;
+  const Instruction& store = w.code[i];
+  const Instruction& load = w.code[i + 1];
+  if (store.op != Op::SW || load.op != Op::LW || store.rs != load.rs ||
+      store.imm != load.imm || store.label != load.label) {
+    return false;
+  }
+  out.length = 2;
+  out.replacement = {store};
+  if (load.rd != store.rt) {
+    out.replacement.push_back(Mips::move(load.rd, store.rt));
+  }
+  return true;
+}
+
+// j L cuando L es la siguiente etiqueta.
+static bool jumpToNext(const Window& w, int i, Rewrite& out) {
+  const Instruction& inst = w.code[i];
+  if (inst.op != Op::J) return false;
+  for (int j = i + 1; j < (int)w.code.size(); ++j) {
+    if (w.code[j].isComment()) continue;
+    if (!w.code[j].isLabel()) return false;
+    if (w.code[j].label == inst.label) {
+      out.length = 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+// beq r, s, L1; j L2; L1:  ->  bne r, s, L2; L1:  (igual con los demás
+// branches)
+static bool branchOverJump(const Window& w, int i, Rewrite& out) {
+  if (i + 2 >= (int)w.code.size()) return false;
+  const Instruction& branch = w.code[i];
+  const Instruction& jump = w.code[i + 1];
+  const Instruction& next = w.code[i + 2];
+  if (!branch.isBranch() || jump.op != Op::J || !next.isLabel() ||
+      next.label != branch.label) {
+    return false;
+  }
+  Instruction inverted = branch;
+  inverted.op = Mips::invertBranch(branch.op);
+  inverted.label = jump.label;
+  out.length = 2;
+  out.replacement = {inverted};
+  return true;
+}
+
+// Primera instrucción real después de la etiqueta, o -1.
+static int firstAfter(const Window& w, const std::string& label) {
+  if (!w.labels.count(label)) return -1;
+  for (int j = w.labels.at(label) + 1; j < (int)w.code.size(); ++j) {
+    if (!w.code[j].isComment() && !w.code[j].isLabel()) return j;
+  }
+  return -1;
+}
+
+// Un salto a una etiqueta cuya primera instrucción es j L2 salta directo a
+// L2 (siguiendo toda la cadena, sin entrar en ciclos).
+static bool jumpThreading(const Window& w, int i, Rewrite& out) {
+  const Instruction& inst = w.code[i];
+  if (!inst.hasTarget()) return false;
+  std::set<std::string> seen = {inst.label};
+  std::string label = inst.label;
+  for (int j = firstAfter(w, label); j >= 0 && w.code[j].op == Op::J;
+       j = firstAfter(w, label)) {
+    if (!seen.insert(w.code[j].label).second) return false;
+    label = w.code[j].label;
+  }
+  if (label == inst.label) return false;
+  Instruction threaded = inst;
+  threaded.label = label;
+  out.length = 1;
+  out.replacement = {threaded};
+  return true;
+}
+
+// Lo que sigue a un j o jr antes de la siguiente etiqueta nunca se ejecuta.
+static bool unreachable(const Window& w, int i, Rewrite& out) {
+  if (i == 0 || !w.code[i - 1].endsBlock()) return false;
+  const Instruction& inst = w.code[i];
+  if (inst.isLabel() || inst.isComment()) return false;
+  out.length = 1;
+  return true;
+}
+
+static const PeepholeRule rules[] = {
+    {"move al mismo registro", selfMove},
+    {"addiu de cero", addZero},
+    {"resultado sin usar", deadDef},
+    {"move absorbido", foldMove},
+    {"lw después de sw", storeLoad},
+    {"salto a la siguiente etiqueta", jumpToNext},
+    {"branch sobre salto", branchOverJump},
+    {"salto a salto", jumpThreading},
+    {"código inalcanzable", unreachable},
+};
+
+void runPeephole(MachineFunction& fn, std::map<std::string, int>& hits) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    ControlFlowGraph cfg(fn);
+    computeLiveness(fn, cfg);
+    auto liveAfter = computeLiveAfter(fn, cfg);
+    std::unordered_map<std::string, int> labels;
+    for (int i = 0; i < (int)fn.code.size(); ++i) {
+      if (fn.code[i].isLabel()) labels[fn.code[i].label] = i;
+    }
+    Window window{fn.code, liveAfter, labels};
+
+    // Una sola pasada con la liveness de arriba; si algo cambió se vuelve a
+    // calcular y se repite.
+    std::vector<Instruction> code;
+    int i = 0;
+    while (i < (int)fn.code.size()) {
+      Rewrite rewrite;
+      const PeepholeRule* matched = nullptr;
+      for (const auto& rule : rules) {
+        if (rule.apply(window, i, rewrite)) {
+          matched = &rule;
+          break;
+        }
+      }
+      if (!matched) {
+        code.push_back(fn.code[i++]);
+        continue;
+      }
+      hits[matched->name]++;
+      code.insert(code.end(), rewrite.replacement.begin(),
+                  rewrite.replacement.end());
+      i += rewrite.length;
+      changed = true;
+    }
+    fn.code = std::move(code);
+  }
+}
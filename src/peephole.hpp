@@ -0,0 +1,15 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del optimizador peephole.
+ * */
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "mips.hpp"
+
+// Aplica la tabla de reglas de peephole sobre la función ya terminada (con
+// prólogo y epílogo) hasta que ninguna cambia nada. Suma a hits cuántas
+// veces se aplicó cada regla.
+void runPeephole(MachineFunction& fn, std::map<std::string, int>& hits);
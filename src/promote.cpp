@@ -0,0 +1,308 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de la promoción de globales a registros.
+ * */
+#include "promote.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cfg.hpp"
+#include "mips.hpp"
+
+// Los jal y las llamadas de cola apuntan a <función>_entry.
+static std::string calledFunction(const Instruction& inst) {
+  const std::string suffix = "_entry";
+  return inst.label.substr(0, inst.label.size() - suffix.size());
+}
+
+// El global escalar que lee o escribe la instrucción, o "" si no es un
+// lw/sw %gp_rel(x)($gp).
+static std::string promotableAccess(const Instruction& inst) {
+  bool memory = inst.op == Op::LW || inst.op == Op::SW;
+  if (!memory || inst.rs != Reg::GP || inst.imm != 0) return "";
+  return inst.label;
+}
+
+ModRefTable computeModRef(const std::vector<MachineFunction>& functions) {
+  ModRefTable table;
+  std::map<std::string, std::set<std::string>> calls;
+  for (const auto& fn : functions) {
+    GlobalEffects& effects = table[fn.name];
+    for (const auto& inst : fn.code) {
+      if (inst.op == Op::JAL || inst.op == Op::TAILCALL) {
+        calls[fn.name].insert(calledFunction(inst));
+      } else if (inst.op == Op::LW && !inst.label.empty()) {
+        effects.reads.insert(inst.label);
+      } else if (inst.op == Op::SW && !inst.label.empty()) {
+        effects.writes.insert(inst.label);
+      } else if ((inst.op == Op::LA || inst.op == Op::ADDIU) &&
+                 !inst.label.empty()) {
+        // Con la dirección de un arreglo se puede leer y escribir.
+        effects.reads.insert(inst.label);
+        effects.writes.insert(inst.label);
+      }
+    }
+  }
+
+  // Cada función hereda los efectos de lo que llama hasta que ya no cambia.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto& [name, effects] : table) {
+      for (const auto& callee : calls[name]) {
+        if (!table.count(callee) || callee == name) continue;
+        const GlobalEffects& other = table[callee];
+        size_t before = effects.reads.size() + effects.writes.size();
+        effects.reads.insert(other.reads.begin(), other.reads.end());
+        effects.writes.insert(other.writes.begin(), other.writes.end());
+        if (effects.reads.size() + effects.writes.size() != before) {
+          changed = true;
+        }
+      }
+    }
+  }
+  return table;
+}
+
+static std::vector<std::string> promoteInLoop(
+    MachineFunction& fn, const ControlFlowGraph& cfg, const Loop& loop,
+    const ModRefTable& modRef,
+    const std::unordered_set<std::string>& scalars) {
+  const auto& code = fn.code;
+  const BasicBlock& header = cfg.blocks[loop.header];
+
+  // Igual que en LICM, el preheader tiene que poder ir justo antes del
+  // header.
+  if (loop.header == 0 || header.label.empty()) return {};
+  const BasicBlock& before = cfg.blocks[loop.header - 1];
+  if (loop.blocks.count(loop.header - 1) &&
+      !code[before.end - 1].endsBlock()) {
+    return {};
+  }
+
+  std::vector<int> body;
+  for (int b : loop.blocks) {
+    for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+      body.push_back(i);
+    }
+  }
+  std::sort(body.begin(), body.end());
+
+  // Cuántas veces se usa cada global en el loop y cuáles se escriben.
+  std::map<std::string, int> accesses;
+  std::set<std::string> stored;
+  std::vector<int> calls;
+  for (int i : body) {
+    std::string symbol = promotableAccess(code[i]);
+    if (!symbol.empty() && scalars.count(symbol)) {
+      accesses[symbol]++;
+      if (code[i].op == Op::SW) stored.insert(symbol);
+    }
+    if (code[i].op == Op::JAL) calls.push_back(i);
+  }
+  if (accesses.empty()) return {};
+
+  // Lo que lee o escribe cada llamada; sin información se asume todo.
+  auto touches = [&](int call, const std::string& symbol, bool write) {
+    auto it = modRef.find(calledFunction(code[call]));
+    if (it == modRef.end()) return true;
+    const GlobalEffects& effects = it->second;
+    return effects.writes.count(symbol) ||
+           (!write && effects.reads.count(symbol));
+  };
+
+  // Cada llamada que usa el global cuesta un sw antes (si el loop lo
+  // escribe) y un lw después (si la llamada lo escribe). Solo conviene si
+  // eso es menos que los accesos que se quitan.
+  std::vector<std::pair<int, std::string>> candidates;
+  for (const auto& [symbol, count] : accesses) {
+    bool addressed = false;
+    for (const auto& inst : code) {
+      bool memory = inst.op == Op::LW || inst.op == Op::SW ||
+                    inst.op == Op::LA || inst.op == Op::ADDIU;
+      if (memory && inst.label == symbol && promotableAccess(inst).empty()) {
+        addressed = true;
+      }
+    }
+    if (addressed) continue;
+    int fixups = 0;
+    for (int call : calls) {
+      if (stored.count(symbol) && touches(call, symbol, false)) fixups++;
+      if (touches(call, symbol, true)) fixups++;
+    }
+    if (fixups < count) candidates.push_back({count - fixups, symbol});
+  }
+
+  // Un global promovido ocupa un registro durante todo el loop. Se estima
+  // la presión con lo que está vivo a la vez más las constantes distintas,
+  // que LICM va a sacar al preheader, y se promueven primero los más usados
+  // mientras quepan.
+  std::vector<std::set<int>> liveAfter = computeLiveAfter(fn, cfg);
+  int pressure = 0;
+  for (int i : body) {
+    int live = 0;
+    for (int loc : liveAfter[i]) {
+      if (Mips::isVirtual(loc) && loc < Location::SLOT_BASE) live++;
+    }
+    pressure = std::max(pressure, live);
+  }
+  std::set<int> constants;
+  for (int i : body) {
+    if (code[i].op == Op::LI) constants.insert(code[i].imm);
+  }
+  pressure += constants.size();
+  std::stable_sort(
+      candidates.begin(), candidates.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; });
+  std::map<std::string, int> promoted;
+  for (const auto& [benefit, symbol] : candidates) {
+    if (pressure + (int)promoted.size() >= PROMOTION_REGISTER_BUDGET) break;
+    promoted[symbol] = fn.newVirtual();
+  }
+  if (promoted.empty()) return {};
+
+  auto storeAll = [&](std::vector<Instruction>& out) {
+    for (const auto& [symbol, reg] : promoted) {
+      if (stored.count(symbol)) {
+        out.push_back(Mips::gpRelative(Op::SW, reg, symbol));
+      }
+    }
+  };
+
+  std::map<int, std::vector<Instruction>> insertBefore, insertAfter;
+  std::map<int, Instruction> replace;
+  std::map<int, std::string> retarget;
+
+  std::string preLabel = header.label + "_prom";
+  auto& preheader = insertBefore[header.begin];
+  preheader.push_back(Mips::label(preLabel));
+  for (const auto& [symbol, reg] : promoted) {
+    preheader.push_back(Mips::gpRelative(Op::LW, reg, symbol));
+  }
+  for (int p : header.preds) {
+    int last = cfg.blocks[p].end - 1;
+    if (!loop.blocks.count(p) && code[last].hasTarget() &&
+        code[last].label == header.label) {
+      retarget[last] = preLabel;
+    }
+  }
+
+  for (int i : body) {
+    const Instruction& inst = code[i];
+    std::string symbol = promotableAccess(inst);
+    if (promoted.count(symbol)) {
+      int reg = promoted[symbol];
+      replace[i] = inst.op == Op::LW ? Mips::move(inst.rd, reg)
+                                     : Mips::move(reg, inst.rt);
+    } else if (inst.op == Op::JAL) {
+      for (const auto& [symbol, reg] : promoted) {
+        if (stored.count(symbol) && touches(i, symbol, false)) {
+          insertBefore[i].push_back(Mips::gpRelative(Op::SW, reg, symbol));
+        }
+        if (touches(i, symbol, true)) {
+          insertAfter[i].push_back(Mips::gpRelative(Op::LW, reg, symbol));
+        }
+      }
+    } else if (inst.op == Op::TAILCALL) {
+      storeAll(insertBefore[i]);
+    }
+  }
+
+  // Las salidas guardan los globales escritos. Si la salida es caer al
+  // siguiente bloque, el sw va al final del bloque; si es un salto, el salto
+  // pasa por un bloque nuevo que guarda y sigue al destino.
+  bool dirty = false;
+  for (const auto& [symbol, reg] : promoted) {
+    if (stored.count(symbol)) dirty = true;
+  }
+  std::vector<Instruction> stubs;
+  if (dirty) {
+    std::map<int, std::string> stubLabels;
+    for (int b : loop.blocks) {
+      const BasicBlock& block = cfg.blocks[b];
+      const Instruction& last = code[block.end - 1];
+      for (int s : block.succs) {
+        if (loop.blocks.count(s)) continue;
+        bool jumps = last.hasTarget() && last.label == cfg.blocks[s].label;
+        if (jumps) {
+          if (!stubLabels.count(s)) {
+            std::string stub =
+                header.label + "_exit" + std::to_string(stubLabels.size());
+            stubLabels[s] = stub;
+            stubs.push_back(Mips::label(stub));
+            storeAll(stubs);
+            stubs.push_back(Mips::jump(Op::J, cfg.blocks[s].label));
+          }
+          retarget[block.end - 1] = stubLabels[s];
+        }
+        if (!last.endsBlock() && s == b + 1) {
+          storeAll(insertAfter[block.end - 1]);
+        }
+      }
+    }
+  }
+
+  // Los bloques de salida van antes de la etiqueta de salida de la función,
+  // como el código frío.
+  std::vector<Instruction> result;
+  for (int i = 0; i < (int)code.size(); ++i) {
+    if (!stubs.empty() && code[i].isLabel() &&
+        code[i].label == fn.exitLabel) {
+      if (!result.empty() && !result.back().endsBlock()) {
+        result.push_back(Mips::jump(Op::J, fn.exitLabel));
+      }
+      result.insert(result.end(), stubs.begin(), stubs.end());
+    }
+    auto& pre = insertBefore[i];
+    result.insert(result.end(), pre.begin(), pre.end());
+    result.push_back(replace.count(i) ? replace[i] : code[i]);
+    if (retarget.count(i)) result.back().label = retarget[i];
+    auto& post = insertAfter[i];
+    result.insert(result.end(), post.begin(), post.end());
+  }
+  fn.code = std::move(result);
+
+  std::vector<std::string> names;
+  for (const auto& [symbol, reg] : promoted) names.push_back(symbol);
+  return names;
+}
+
+std::vector<PromotionReport> promoteGlobals(
+    MachineFunction& fn, const ModRefTable& modRef,
+    const std::unordered_set<std::string>& scalars) {
+  std::vector<PromotionReport> reports;
+  std::set<std::string> visited;
+
+  while (true) {
+    ControlFlowGraph cfg(fn);
+    computeLiveness(fn, cfg);
+    cfg.computeDominators();
+    std::vector<Loop> loops = findNaturalLoops(cfg);
+
+    // Primero los loops internos; las cargas y los sw que quedan en su
+    // preheader y sus salidas se promueven después en el loop de afuera.
+    std::sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) {
+      return a.blocks.size() < b.blocks.size();
+    });
+
+    bool changed = false;
+    for (const auto& loop : loops) {
+      const std::string& label = cfg.blocks[loop.header].label;
+      if (visited.count(label)) continue;
+      visited.insert(label);
+      std::vector<std::string> globals =
+          promoteInLoop(fn, cfg, loop, modRef, scalars);
+      if (!globals.empty()) {
+        reports.push_back({label, globals});
+        changed = true;
+        break;
+      }
+    }
+    if (!changed) break;
+  }
+  return reports;
+}
@@ -0,0 +1,42 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de la promoción de globales a registros.
+ * */
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "mips.hpp"
+
+// Los globales que una función puede leer o escribir, contando los de las
+// funciones que llama. C- no tiene apuntadores, así que solo se llega a un
+// global por su nombre.
+struct GlobalEffects {
+  std::set<std::string> reads;
+  std::set<std::string> writes;
+};
+using ModRefTable = std::map<std::string, GlobalEffects>;
+
+ModRefTable computeModRef(const std::vector<MachineFunction>& functions);
+
+// De los 18 registros que reparte el asignador ($t0-$t9 y $s0-$s7) se dejan
+// dos de margen: los intervalos del linear scan son más largos que el
+// liveness real.
+constexpr int PROMOTION_REGISTER_BUDGET = 16;
+
+struct PromotionReport {
+  std::string loop;
+  std::vector<std::string> globals;
+};
+
+// Mantiene en un registro virtual los globales escalares que se leen o
+// escriben en un loop: se cargan una vez en el preheader y se guardan en las
+// salidas. Alrededor de las llamadas que los usan se guardan y se vuelven a
+// cargar. Regresa qué globales se promovieron en cada loop.
+std::vector<PromotionReport> promoteGlobals(
+    MachineFunction& fn, const ModRefTable& modRef,
+    const std::unordered_set<std::string>& scalars);
@@ -0,0 +1,226 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del asignador de registros (linear scan).
+ * */
+#include "regalloc.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "cfg.hpp"
+#include "mips.hpp"
+
+namespace {
+
+struct Interval {
+  int reg;
+  int start;
+  int end;
+  // Sigue vivo después de un jal, así que necesita un registro $s.
+  bool crossesCall = false;
+  int assigned = -1;
+};
+
+}  // namespace
+
+static bool isSaved(int reg) { return reg >= Reg::S0 && reg <= Reg::S7; }
+
+// Un intervalo por registro virtual, desde la primera hasta la última
+// instrucción donde está vivo.
+static std::vector<Interval> buildIntervals(const MachineFunction& fn) {
+  ControlFlowGraph cfg(fn);
+  computeLiveness(fn, cfg);
+
+  std::map<int, Interval> byReg;
+  auto extend = [&](int reg, int at) {
+    if (!Mips::isVirtual(reg) || reg >= fn.nextVirtual) return;
+    auto it = byReg.find(reg);
+    if (it == byReg.end()) {
+      byReg[reg] = Interval{reg, at, at};
+    } else {
+      it->second.start = std::min(it->second.start, at);
+      it->second.end = std::max(it->second.end, at);
+    }
+  };
+
+  for (const auto& block : cfg.blocks) {
+    std::set<int> live = block.liveOut;
+    for (int i = block.end - 1; i >= block.begin; --i) {
+      const Instruction& inst = fn.code[i];
+      for (int reg : live) extend(reg, i);
+      if (inst.op == Op::JAL) {
+        for (int reg : live) {
+          if (byReg.count(reg)) byReg[reg].crossesCall = true;
+        }
+      }
+      for (int d : Location::defs(inst, fn)) {
+        extend(d, i);
+        live.erase(d);
+      }
+      for (int u : Location::uses(inst, fn)) {
+        extend(u, i);
+        live.insert(u);
+      }
+    }
+    for (int reg : live) extend(reg, block.begin);
+  }
+
+  std::vector<Interval> intervals;
+  for (auto& [reg, interval] : byReg) intervals.push_back(interval);
+  std::sort(intervals.begin(), intervals.end(),
+            [](const Interval& a, const Interval& b) {
+              return a.start < b.start || (a.start == b.start && a.reg < b.reg);
+            });
+  return intervals;
+}
+
+AllocationReport allocateRegisters(MachineFunction& fn) {
+  AllocationReport report;
+  std::vector<Interval> intervals = buildIntervals(fn);
+  report.virtuals = intervals.size();
+
+  std::set<int> freeTemps, freeSaved;
+  for (int r = Reg::T0; r <= Reg::T7; ++r) freeTemps.insert(r);
+  freeTemps.insert(Reg::T8);
+  freeTemps.insert(Reg::T9);
+  for (int r = Reg::S0; r <= Reg::S7; ++r) freeSaved.insert(r);
+
+  auto release = [&](int reg) {
+    (isSaved(reg) ? freeSaved : freeTemps).insert(reg);
+  };
+  auto take = [&](std::set<int>& pool) {
+    int reg = *pool.begin();
+    pool.erase(pool.begin());
+    return reg;
+  };
+
+  // Intervalos activos ordenados por dónde terminan.
+  std::vector<Interval*> active;
+  std::set<int> spilled;
+  std::set<int> usedSaved;
+
+  for (auto& current : intervals) {
+    // Se liberan los registros de los intervalos que ya terminaron.
+    auto expired = std::remove_if(active.begin(), active.end(), [&](auto* a) {
+      if (a->end >= current.start) return false;
+      release(a->assigned);
+      return true;
+    });
+    active.erase(expired, active.end());
+
+    if (!current.crossesCall && !freeTemps.empty()) {
+      current.assigned = take(freeTemps);
+    } else if (!freeSaved.empty()) {
+      current.assigned = take(freeSaved);
+    } else {
+      // No hay registro libre: se manda al stack el intervalo compatible que
+      // termina más tarde.
+      Interval* victim = nullptr;
+      for (auto* a : active) {
+        if (current.crossesCall && !isSaved(a->assigned)) continue;
+        if (!victim || a->end > victim->end) victim = a;
+      }
+      if (victim && victim->end > current.end) {
+        current.assigned = victim->assigned;
+        victim->assigned = -1;
+        spilled.insert(victim->reg);
+        active.erase(std::find(active.begin(), active.end(), victim));
+      } else {
+        spilled.insert(current.reg);
+        continue;
+      }
+    }
+
+    if (isSaved(current.assigned)) usedSaved.insert(current.assigned);
+    active.insert(std::upper_bound(active.begin(), active.end(), &current,
+                                   [](auto* a, auto* b) {
+                                     return a->end < b->end;
+                                   }),
+                  &current);
+  }
+
+  std::map<int, int> physical;
+  for (const auto& interval : intervals) {
+    if (interval.assigned >= 0) physical[interval.reg] = interval.assigned;
+  }
+  // Los slots de los valores en el stack van antes de las variables locales,
+  // justo debajo de $ra: así su desplazamiento siempre cabe en 16 bits aunque
+  // la función tenga arreglos grandes, y el ensamblador nunca los expande a
+  // través de $at, que es justo donde viaja el valor. Los arreglos locales se
+  // recorren para dejarles lugar.
+  std::map<int, int> slots;
+  int spillBytes = 4 * spilled.size();
+  if (spillBytes > 0) {
+    for (auto& inst : fn.code) {
+      bool frameAccess = inst.op == Op::LW || inst.op == Op::SW ||
+                         inst.op == Op::ADDIU;
+      if (frameAccess && inst.rs == Reg::FP && inst.imm <= -8) {
+        inst.imm -= spillBytes;
+      }
+    }
+  }
+  for (int reg : spilled) slots[reg] = -8 - 4 * (int)slots.size();
+  fn.localsSize += spillBytes;
+  fn.spillSize = spillBytes;
+
+  std::vector<Instruction> code;
+  for (Instruction inst : fn.code) {
+    // Un sw con desplazamiento grande cuya base y valor están en el stack:
+    // el desplazamiento se suma a la base en $v1 para que el sw ya no
+    // necesite $at.
+    if (inst.op == Op::SW && Mips::usesAssemblerTemporary(inst) &&
+        slots.count(inst.rs) && slots.count(inst.rt) && inst.rs != inst.rt) {
+      code.push_back(Mips::lw(Reg::V1, slots[inst.rs], Reg::FP));
+      code.push_back(Mips::addiu(Reg::V1, Reg::V1, inst.imm));
+      report.spillLoads++;
+      inst.rs = Reg::V1;
+      inst.imm = 0;
+    }
+    // Los valores que están en el stack se cargan a $at y $v1 antes de la
+    // instrucción; el resultado se escribe en $at y se guarda después. Si
+    // el ensamblador expande la instrucción a través de $at, los operandos
+    // van primero a $v1.
+    std::map<int, int> scratch;
+    bool expands = Mips::usesAssemblerTemporary(inst);
+    const int scratchRegs[] = {expands ? Reg::V1 : Reg::AT,
+                               expands ? Reg::AT : Reg::V1};
+    for (int* operand : {&inst.rs, &inst.rt}) {
+      if (!slots.count(*operand)) continue;
+      if (!scratch.count(*operand)) {
+        int reg = scratchRegs[scratch.size()];
+        scratch[*operand] = reg;
+        code.push_back(Mips::lw(reg, slots[*operand], Reg::FP));
+        report.spillLoads++;
+      }
+      *operand = scratch[*operand];
+    }
+    int spilledDef = -1;
+    if (slots.count(inst.rd)) {
+      spilledDef = inst.rd;
+      inst.rd = Reg::AT;
+    }
+
+    for (int* operand : {&inst.rd, &inst.rs, &inst.rt}) {
+      if (physical.count(*operand)) *operand = physical[*operand];
+    }
+    // Un move entre dos valores del stack queda como lw y sw por $at; el
+    // move $at, $at sobra pero el guardado no.
+    if (inst.op != Op::MOVE || inst.rd != inst.rs) code.push_back(inst);
+
+    if (spilledDef >= 0) {
+      code.push_back(Mips::sw(Reg::AT, slots[spilledDef], Reg::FP));
+      report.spillStores++;
+    }
+  }
+  fn.code = std::move(code);
+
+  // main termina con exit, así que no tiene a quién preservarle los $s.
+  if (fn.name != "main") {
+    fn.savedRegs.assign(usedSaved.begin(), usedSaved.end());
+  }
+  report.spilled = spilled.size();
+  report.calleeSaved = fn.savedRegs.size();
+  return report;
+}
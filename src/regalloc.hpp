@@ -0,0 +1,23 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del asignador de registros (linear scan).
+ * */
+#pragma once
+
+#include "mips.hpp"
+
+struct AllocationReport {
+  int virtuals = 0;
+  // Registros virtuales que se quedaron en el stack y las cargas y
+  // guardados que se agregaron por ellos.
+  int spilled = 0;
+  int spillLoads = 0;
+  int spillStores = 0;
+  int calleeSaved = 0;
+};
+
+// Cambia todos los registros virtuales de la función por $t0-$t9 y $s0-$s7.
+// Los valores que siguen vivos después de una llamada solo usan registros $s.
+// Cuando no alcanzan se manda al stack el intervalo que termina más tarde, y
+// sus usos pasan por $at y $v1.
+AllocationReport allocateRegisters(MachineFunction& fn);
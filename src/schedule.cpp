@@ -0,0 +1,281 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del scheduling de instrucciones y el
+ *  llenado de delay slots.
+ * */
+#include "schedule.hpp"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "cfg.hpp"
+#include "mips.hpp"
+
+static bool intersects(const std::vector<int>& a, const std::vector<int>& b) {
+  for (int x : a) {
+    if (std::find(b.begin(), b.end(), x) != b.end()) return true;
+  }
+  return false;
+}
+
+static bool isMemory(const Instruction& inst) {
+  return inst.op == Op::LW || inst.op == Op::SW;
+}
+
+static bool hasDelaySlot(const Instruction& inst) {
+  return inst.isBranch() || inst.op == Op::J || inst.op == Op::JAL ||
+         inst.op == Op::JR || inst.op == Op::TAILCALL;
+}
+
+// Lo que no se puede mover de lugar: corta los tramos que se reordenan.
+// Las etiquetas a las que nadie salta no cuentan.
+static bool isBarrier(const Instruction& inst,
+                      const std::set<std::string>& targets) {
+  if (inst.isLabel()) return targets.count(inst.label) > 0;
+  return hasDelaySlot(inst) || inst.isComment() || inst.op == Op::SYSCALL ||
+         inst.op == Op::NOP;
+}
+
+// Las pseudo-instrucciones que el ensamblador expande a dos no caben en un
+// delay slot, ni un inmediato o desplazamiento que no cabe en 16 bits.
+static bool isSingleInstruction(const Instruction& inst) {
+  if (inst.op == Op::LA) return false;
+  if (inst.op == Op::LI) return inst.imm >= -32768 && inst.imm <= 32767;
+  return !Mips::usesAssemblerTemporary(inst);
+}
+
+// Lo que escribe la instrucción ya expandida, que puede incluir $at.
+static std::vector<int> expandedDefs(const Instruction& inst) {
+  std::vector<int> defs = Mips::defs(inst);
+  if (Mips::usesAssemblerTemporary(inst)) defs.push_back(Reg::AT);
+  return defs;
+}
+
+// Si second tiene que quedarse después de first.
+static bool dependsOn(const Instruction& first, const Instruction& second) {
+  std::vector<int> defs1 = expandedDefs(first), uses1 = Mips::uses(first);
+  std::vector<int> defs2 = expandedDefs(second), uses2 = Mips::uses(second);
+  if (intersects(defs1, uses2) || intersects(uses1, defs2) ||
+      intersects(defs1, defs2)) {
+    return true;
+  }
+  if (isMemory(first) && isMemory(second) &&
+      (first.op == Op::SW || second.op == Op::SW)) {
+    // Con la misma base y otro desplazamiento son palabras distintas; si la
+    // base cambia en medio, esa instrucción ya las mantiene en orden. Dos
+    // globales distintos relativos a $gp tampoco se enciman.
+    if (first.rs != second.rs) return true;
+    return first.imm == second.imm && first.label == second.label;
+  }
+  return false;
+}
+
+// Ciclos desde que first empieza hasta que second puede usar su resultado.
+static int latency(const Instruction& first, const Instruction& second) {
+  if (first.op == Op::LW && intersects(Mips::defs(first), Mips::uses(second))) {
+    return 2;
+  }
+  return 1;
+}
+
+static int countLoadUse(const std::vector<Instruction>& code) {
+  int count = 0;
+  for (size_t i = 0; i + 1 < code.size(); ++i) {
+    if (code[i].op == Op::LW && latency(code[i], code[i + 1]) > 1) count++;
+  }
+  return count;
+}
+
+// List scheduling: en cada paso se emite, de las instrucciones cuyas
+// dependencias ya salieron, la que puede empezar antes; si empatan, la que
+// tiene más ciclos por delante hasta el final del tramo.
+static std::vector<Instruction> listSchedule(
+    const std::vector<Instruction>& region, const Instruction* end) {
+  int n = region.size();
+  std::vector<std::vector<int>> succs(n);
+  std::vector<int> preds(n, 0), height(n, 0);
+  for (int i = n - 1; i >= 0; --i) {
+    if (end && dependsOn(region[i], *end)) {
+      height[i] = latency(region[i], *end);
+    }
+    for (int j = i + 1; j < n; ++j) {
+      if (!dependsOn(region[i], region[j])) continue;
+      succs[i].push_back(j);
+      preds[j]++;
+      height[i] =
+          std::max(height[i], latency(region[i], region[j]) + height[j]);
+    }
+  }
+
+  std::vector<Instruction> ordered;
+  std::vector<int> readyAt(n, 0);
+  std::vector<bool> done(n, false);
+  int cycle = 0;
+  for (int step = 0; step < n; ++step) {
+    int best = -1;
+    auto key = [&](int i) {
+      return std::make_tuple(std::max(readyAt[i], cycle), -height[i], i);
+    };
+    for (int i = 0; i < n; ++i) {
+      if (done[i] || preds[i] > 0) continue;
+      if (best < 0 || key(i) < key(best)) best = i;
+    }
+    int issue = std::max(readyAt[best], cycle);
+    done[best] = true;
+    ordered.push_back(region[best]);
+    for (int s : succs[best]) {
+      preds[s]--;
+      readyAt[s] =
+          std::max(readyAt[s], issue + latency(region[best], region[s]));
+    }
+    cycle = issue + 1;
+  }
+  return ordered;
+}
+
+// Si inst puede ejecutarse en el delay slot de jump. jal escribe $ra antes
+// de que corra el slot; el resto solo lee sus operandos.
+static bool canFillSlot(const Instruction& inst, const Instruction& jump) {
+  if (!isSingleInstruction(inst)) return false;
+  if (jump.op == Op::JAL) {
+    std::vector<int> ra = {Reg::RA};
+    return !intersects(Mips::defs(inst), Mips::uses(jump)) &&
+           !intersects(Mips::defs(inst), ra) &&
+           !intersects(Mips::uses(inst), ra);
+  }
+  return !dependsOn(inst, jump);
+}
+
+// La última instrucción del tramo de la que no depende nada de lo que sigue.
+// Si se puede, una que no esté separando un lw de su uso.
+static int findSlotFiller(const std::vector<Instruction>& ordered,
+                          const Instruction& jump) {
+  int n = ordered.size();
+  int fallback = -1;
+  for (int k = n - 1; k >= 0; --k) {
+    if (!canFillSlot(ordered[k], jump)) continue;
+    bool independent = true;
+    for (int m = k + 1; m < n && independent; ++m) {
+      independent = !dependsOn(ordered[k], ordered[m]);
+    }
+    if (!independent) continue;
+    const Instruction& after = k + 1 < n ? ordered[k + 1] : jump;
+    if (k > 0 && ordered[k - 1].op == Op::LW &&
+        latency(ordered[k - 1], after) > 1) {
+      if (fallback < 0) fallback = k;
+      continue;
+    }
+    return k;
+  }
+  return fallback;
+}
+
+// Si inst puede ejecutarse también en el camino donde no estaba: no escribe
+// memoria, no puede fallar (lw, div entre cero) y es una sola instrucción.
+static bool canSpeculate(const Instruction& inst) {
+  if (inst.isLabel() || inst.isComment() || hasDelaySlot(inst)) return false;
+  if (Mips::hasSideEffects(inst) || !isSingleInstruction(inst)) return false;
+  return inst.op != Op::LW && inst.op != Op::DIV && inst.op != Op::NOP;
+}
+
+// Un branch al que no se le encontró nada antes puede llevarse la primera
+// instrucción del camino que cae, si lo que escribe está muerto en el
+// destino.
+static void fillFromFallThrough(
+    std::vector<Instruction>& code, const std::set<std::string>& targets,
+    const std::unordered_map<std::string, std::set<int>>& liveAtLabel,
+    ScheduleReport& report) {
+  for (size_t i = 0; i + 1 < code.size(); ++i) {
+    if (!code[i].isBranch() || code[i + 1].op != Op::NOP) continue;
+    size_t next = i + 2;
+    while (next < code.size() && code[next].isLabel() &&
+           !targets.count(code[next].label)) {
+      next++;
+    }
+    if (next >= code.size() || !canSpeculate(code[next])) continue;
+    auto live = liveAtLabel.find(code[i].label);
+    if (live == liveAtLabel.end()) continue;
+    std::vector<int> liveIn(live->second.begin(), live->second.end());
+    if (intersects(Mips::defs(code[next]), liveIn)) continue;
+    code[i + 1] = code[next];
+    code.erase(code.begin() + next);
+    report.filledSlots++;
+    report.nops--;
+  }
+}
+
+ScheduleReport scheduleFunction(MachineFunction& fn, bool reorder,
+                                bool delaySlots) {
+  ScheduleReport report;
+  report.loadUseBefore = countLoadUse(fn.code);
+
+  // Etiquetas que alguien usa: los destinos de saltos y la entrada.
+  std::set<std::string> targets = {fn.name + "_entry"};
+  for (const auto& inst : fn.code) {
+    if (inst.hasTarget() || inst.op == Op::JAL || inst.op == Op::TAILCALL) {
+      targets.insert(inst.label);
+    }
+  }
+  std::unordered_map<std::string, std::set<int>> liveAtLabel;
+  if (delaySlots) {
+    ControlFlowGraph cfg(fn);
+    computeLiveness(fn, cfg);
+    for (const auto& block : cfg.blocks) {
+      if (!block.label.empty()) liveAtLabel[block.label] = block.liveIn;
+    }
+  }
+
+  std::vector<Instruction> code;
+  std::vector<Instruction> region;
+  // Las etiquetas sin saltos se ponen al inicio de su tramo; como el tramo no
+  // tiene saltos se ejecutan las mismas veces.
+  std::vector<Instruction> floating;
+  auto flush = [&](const Instruction* end) {
+    std::vector<Instruction> ordered =
+        reorder ? listSchedule(region, end) : region;
+    region.clear();
+    code.insert(code.end(), floating.begin(), floating.end());
+    floating.clear();
+    if (!end) {
+      code.insert(code.end(), ordered.begin(), ordered.end());
+      return;
+    }
+    if (!delaySlots || !hasDelaySlot(*end)) {
+      code.insert(code.end(), ordered.begin(), ordered.end());
+      code.push_back(*end);
+      return;
+    }
+    int filler = findSlotFiller(ordered, *end);
+    for (int k = 0; k < (int)ordered.size(); ++k) {
+      if (k != filler) code.push_back(ordered[k]);
+    }
+    code.push_back(*end);
+    if (filler >= 0) {
+      code.push_back(ordered[filler]);
+      report.filledSlots++;
+    } else {
+      code.push_back(Mips::nop());
+      report.nops++;
+    }
+  };
+
+  for (const auto& inst : fn.code) {
+    if (isBarrier(inst, targets)) {
+      flush(&inst);
+    } else if (inst.isLabel()) {
+      floating.push_back(inst);
+    } else {
+      region.push_back(inst);
+    }
+  }
+  flush(nullptr);
+  if (delaySlots) fillFromFallThrough(code, targets, liveAtLabel, report);
+  fn.code = std::move(code);
+
+  report.loadUseAfter = countLoadUse(fn.code);
+  return report;
+}
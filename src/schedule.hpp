@@ -0,0 +1,25 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del scheduling de instrucciones y el llenado de
+ *  delay slots.
+ * */
+#pragma once
+
+#include "mips.hpp"
+
+struct ScheduleReport {
+  // Cargas seguidas directamente de una instrucción que usa el valor, antes
+  // y después de reordenar.
+  int loadUseBefore = 0;
+  int loadUseAfter = 0;
+  int filledSlots = 0;
+  int nops = 0;
+};
+
+// Recorre los bloques de la función ya terminada. Con reorder, cada tramo
+// entre etiquetas, llamadas y saltos se reordena con list scheduling sobre
+// su grafo de dependencias, dando prioridad al camino más largo y separando
+// cada lw de su uso. Con delaySlots, después de cada branch o salto se pone
+// una instrucción independiente del tramo, o un nop si no hay ninguna.
+ScheduleReport scheduleFunction(MachineFunction& fn, bool reorder,
+                                bool delaySlots);
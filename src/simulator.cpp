@@ -0,0 +1,622 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del simulador de MIPS integrado.
+ * */
+#include "simulator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "colors.hpp"
+
+namespace {
+
+// Lo que hace cada instrucción una vez decodificada.
+enum class Exec : uint8_t {
+  ADD,
+  ADDU,
+  SUB,
+  SUBU,
+  XOR,
+  SLT,
+  SLTU,
+  MUL,
+  MULT,
+  DIV,
+  MFHI,
+  MFLO,
+  SLL,
+  SRL,
+  SRA,
+  ADDIU,
+  SLTIU,
+  ORI,
+  XORI,
+  LUI,
+  LW,
+  SW,
+  BEQ,
+  BNE,
+  BLEZ,
+  BGTZ,
+  BLTZ,
+  BGEZ,
+  J,
+  JAL,
+  JR,
+  SYSCALL,
+  NOP,
+  INVALID,
+};
+
+// HI y LO se tratan como un solo registro en el modelo de pipeline.
+constexpr int HILO = 32;
+
+struct Decoded {
+  Exec exec = Exec::INVALID;
+  uint8_t rd = 0, rs = 0, rt = 0;
+  int32_t imm = 0;
+  // Índice de la instrucción destino de un branch, j o jal.
+  uint32_t target = 0;
+  // Para el modelo de pipeline: los registros que lee (0 si no lee) y el que
+  // escribe con su latencia.
+  uint8_t source1 = 0, source2 = 0, dest = 0, latency = 1;
+};
+
+// Decodifica una palabra en la posición index del código. Solo entiende lo
+// que produce el codificador.
+static Decoded decodeWord(uint32_t word, uint32_t index) {
+  Decoded d;
+  uint32_t opcode = word >> 26;
+  d.rs = (word >> 21) & 31;
+  d.rt = (word >> 16) & 31;
+  d.rd = (word >> 11) & 31;
+  uint32_t shamt = (word >> 6) & 31;
+  d.imm = (int16_t)(word & 0xffff);
+  auto reads = [&](int first, int second) {
+    d.source1 = first;
+    d.source2 = second;
+  };
+  auto writes = [&](int reg, int latency = 1) {
+    d.dest = reg;
+    d.latency = latency;
+  };
+  if (word == 0) {
+    d.exec = Exec::NOP;
+    return d;
+  }
+  switch (opcode) {
+    case 0x00:
+      reads(d.rs, d.rt);
+      writes(d.rd);
+      switch (word & 63) {
+        case 0x20:
+          d.exec = Exec::ADD;
+          break;
+        case 0x21:
+          d.exec = Exec::ADDU;
+          break;
+        case 0x22:
+          d.exec = Exec::SUB;
+          break;
+        case 0x23:
+          d.exec = Exec::SUBU;
+          break;
+        case 0x26:
+          d.exec = Exec::XOR;
+          break;
+        case 0x2a:
+          d.exec = Exec::SLT;
+          break;
+        case 0x2b:
+          d.exec = Exec::SLTU;
+          break;
+        case 0x18:
+          d.exec = Exec::MULT;
+          writes(HILO, MULT_LATENCY);
+          break;
+        case 0x1a:
+          d.exec = Exec::DIV;
+          writes(HILO, DIV_LATENCY);
+          break;
+        case 0x10:
+        case 0x12:
+          d.exec = (word & 63) == 0x10 ? Exec::MFHI : Exec::MFLO;
+          reads(HILO, 0);
+          break;
+        case 0x00:
+        case 0x02:
+        case 0x03:
+          d.exec = (word & 63) == 0x00   ? Exec::SLL
+                   : (word & 63) == 0x02 ? Exec::SRL
+                                         : Exec::SRA;
+          d.imm = shamt;
+          reads(d.rt, 0);
+          break;
+        case 0x08:
+          d.exec = Exec::JR;
+          reads(d.rs, 0);
+          writes(0);
+          break;
+        case 0x0c:
+          d.exec = Exec::SYSCALL;
+          // Lee $v0 y $a0 y puede escribir $v0.
+          reads(2, 4);
+          writes(2);
+          break;
+      }
+      return d;
+    case 0x1c:
+      if ((word & 63) == 0x02) {
+        d.exec = Exec::MUL;
+        reads(d.rs, d.rt);
+        writes(d.rd, MULT_LATENCY);
+      }
+      return d;
+    case 0x01:
+    case 0x04:
+    case 0x05:
+    case 0x06:
+    case 0x07:
+      d.exec = opcode == 0x04   ? Exec::BEQ
+               : opcode == 0x05 ? Exec::BNE
+               : opcode == 0x06 ? Exec::BLEZ
+               : opcode == 0x07 ? Exec::BGTZ
+               : d.rt == 1      ? Exec::BGEZ
+                                : Exec::BLTZ;
+      reads(d.rs, opcode == 0x04 || opcode == 0x05 ? d.rt : 0);
+      d.target = index + 1 + d.imm;
+      return d;
+    case 0x02:
+    case 0x03: {
+      uint32_t pc = TEXT_BASE + 4 * index;
+      uint32_t address = ((pc + 4) & 0xf0000000) | ((word & 0x03ffffff) << 2);
+      d.exec = opcode == 0x02 ? Exec::J : Exec::JAL;
+      d.target = (address - TEXT_BASE) / 4;
+      if (opcode == 0x03) writes(31);
+      return d;
+    }
+    case 0x09:
+    case 0x0b:
+    case 0x0d:
+    case 0x0e:
+    case 0x0f:
+      d.exec = opcode == 0x09   ? Exec::ADDIU
+               : opcode == 0x0b ? Exec::SLTIU
+               : opcode == 0x0d ? Exec::ORI
+               : opcode == 0x0e ? Exec::XORI
+                                : Exec::LUI;
+      // ori, xori y lui usan el inmediato sin signo.
+      if (opcode >= 0x0d) d.imm = word & 0xffff;
+      reads(opcode == 0x0f ? 0 : d.rs, 0);
+      writes(d.rt);
+      return d;
+    case 0x23:
+      d.exec = Exec::LW;
+      reads(d.rs, 0);
+      writes(d.rt, LOAD_LATENCY);
+      return d;
+    case 0x2b:
+      d.exec = Exec::SW;
+      reads(d.rs, d.rt);
+      return d;
+  }
+  return d;
+}
+
+class Machine {
+ public:
+  Machine(const ObjectCode& object, const SimulationOptions& options)
+      : object(object), options(options) {
+    code.reserve(object.text.size());
+    for (uint32_t i = 0; i < object.text.size(); ++i) {
+      code.push_back(decodeWord(object.text[i], i));
+    }
+    executed.assign(code.size(), 0);
+    if (options.pipeline) cyclesAt.assign(code.size(), 0);
+    data = object.sdata;
+    data.insert(data.end(), object.data.begin(), object.data.end());
+    data.resize(std::max<size_t>(data.size(), DATA_SEGMENT_SIZE), 0);
+    stack.assign(STACK_SIZE, 0);
+  }
+
+  template <bool Timing>
+  void run(SimulationResult& result);
+
+  std::vector<long long> executed;
+  std::vector<long long> cyclesAt;
+
+ private:
+  const ObjectCode& object;
+  const SimulationOptions& options;
+  std::vector<Decoded> code;
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> stack;
+  uint32_t regs[32] = {};
+  uint32_t hi = 0, lo = 0;
+
+  // La dirección de una palabra en la memoria simulada, o nullptr si no
+  // está en los datos ni en el stack.
+  uint8_t* locate(uint32_t address, uint32_t bytes) {
+    uint32_t stackBase = STACK_TOP + 4 - STACK_SIZE;
+    if (address - SDATA_BASE < data.size() &&
+        data.size() - (address - SDATA_BASE) >= bytes) {
+      return &data[address - SDATA_BASE];
+    }
+    if (address - stackBase < STACK_SIZE &&
+        STACK_SIZE - (address - stackBase) >= bytes) {
+      return &stack[address - stackBase];
+    }
+    return nullptr;
+  }
+
+  bool load(uint32_t address, uint32_t& value) {
+    uint8_t* bytes = address % 4 ? nullptr : locate(address, 4);
+    if (!bytes) return false;
+    value = (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 |
+            (uint32_t)bytes[2] << 8 | bytes[3];
+    return true;
+  }
+
+  bool store(uint32_t address, uint32_t value) {
+    uint8_t* bytes = address % 4 ? nullptr : locate(address, 4);
+    if (!bytes) return false;
+    for (int i = 0; i < 4; ++i) bytes[i] = value >> (24 - 8 * i);
+    return true;
+  }
+
+  // Regresa false si el programa terminó o hubo un error.
+  bool syscall(SimulationResult& result);
+};
+
+}  // namespace
+
+bool Machine::syscall(SimulationResult& result) {
+  std::ostream& out = *options.output;
+  switch (regs[2]) {
+    case 1:
+      // Cada output en su propia línea para poder leer la salida.
+      out << (int32_t)regs[4] << '\n';
+      return true;
+    case 4:
+      for (uint32_t address = regs[4];; ++address) {
+        uint8_t* byte = locate(address, 1);
+        if (!byte) {
+          result.error = "string fuera de la memoria";
+          return false;
+        }
+        if (*byte == 0) break;
+        out << (char)*byte;
+      }
+      return true;
+    case 5: {
+      int value;
+      if (!(*options.input >> value)) {
+        result.error = "no hay más entrada para input()";
+        return false;
+      }
+      regs[2] = value;
+      return true;
+    }
+    case 10:
+      result.exited = true;
+      return false;
+    case 11:
+      out << (char)regs[4];
+      return true;
+  }
+  result.error = "syscall " + std::to_string(regs[2]) + " no soportada";
+  return false;
+}
+
+template <bool Timing>
+void Machine::run(SimulationResult& result) {
+  regs[28] = GP_VALUE;
+  regs[29] = STACK_TOP;
+  // pc es la instrucción que se ejecuta y npc la que sigue; con delay slots
+  // un salto tomado cambia la que sigue a npc.
+  uint32_t pc = (object.entry - TEXT_BASE) / 4, npc = pc + 1;
+  long long steps = 0, cycle = 0;
+  long long ready[HILO + 1] = {};
+  const uint32_t size = code.size();
+  const bool delay = options.delaySlots;
+
+  auto fail = [&](const std::string& message) {
+    std::ostringstream text;
+    text << message << " en 0x" << std::hex << TEXT_BASE + 4 * pc;
+    result.error = text.str();
+  };
+
+  while (true) {
+    if (pc >= size) {
+      result.error = "el programa saltó fuera del código";
+      break;
+    }
+    if (++steps > options.stepLimit) {
+      fail("se pasó del límite de instrucciones");
+      break;
+    }
+    const Decoded& d = code[pc];
+    executed[pc]++;
+    if constexpr (Timing) {
+      long long issue = std::max({cycle + 1, ready[d.source1],
+                                  ready[d.source2]});
+      cyclesAt[pc] += issue - cycle;
+      cycle = issue;
+      if (d.dest) ready[d.dest] = issue + d.latency;
+    }
+    uint32_t after = npc + 1;
+    bool taken = false;
+    uint32_t target = d.target;
+    uint32_t s = regs[d.rs], t = regs[d.rt];
+    switch (d.exec) {
+      case Exec::ADD:
+      case Exec::SUB: {
+        // Como en el hardware, add y sub terminan con una excepción si el
+        // resultado no cabe en 32 bits con signo.
+        int64_t exact = d.exec == Exec::ADD
+                            ? (int64_t)(int32_t)s + (int32_t)t
+                            : (int64_t)(int32_t)s - (int32_t)t;
+        if (exact < INT32_MIN || exact > INT32_MAX) {
+          fail("overflow aritmético");
+          goto done;
+        }
+        regs[d.rd] = (uint32_t)exact;
+        break;
+      }
+      case Exec::ADDU:
+        regs[d.rd] = s + t;
+        break;
+      case Exec::SUBU:
+        regs[d.rd] = s - t;
+        break;
+      case Exec::XOR:
+        regs[d.rd] = s ^ t;
+        break;
+      case Exec::SLT:
+        regs[d.rd] = (int32_t)s < (int32_t)t;
+        break;
+      case Exec::SLTU:
+        regs[d.rd] = s < t;
+        break;
+      case Exec::MUL:
+        regs[d.rd] = (uint32_t)((int64_t)(int32_t)s * (int32_t)t);
+        break;
+      case Exec::MULT: {
+        int64_t product = (int64_t)(int32_t)s * (int32_t)t;
+        lo = (uint32_t)product;
+        hi = (uint32_t)((uint64_t)product >> 32);
+        break;
+      }
+      case Exec::DIV:
+        // Como en el hardware, dividir entre cero deja HI y LO como estaban.
+        if (t != 0 && !((int32_t)s == INT32_MIN && (int32_t)t == -1)) {
+          lo = (int32_t)s / (int32_t)t;
+          hi = (int32_t)s % (int32_t)t;
+        }
+        break;
+      case Exec::MFHI:
+        regs[d.rd] = hi;
+        break;
+      case Exec::MFLO:
+        regs[d.rd] = lo;
+        break;
+      case Exec::SLL:
+        regs[d.rd] = t << d.imm;
+        break;
+      case Exec::SRL:
+        regs[d.rd] = t >> d.imm;
+        break;
+      case Exec::SRA:
+        regs[d.rd] = (uint32_t)((int32_t)t >> d.imm);
+        break;
+      case Exec::ADDIU:
+        regs[d.rt] = s + d.imm;
+        break;
+      case Exec::SLTIU:
+        regs[d.rt] = s < (uint32_t)d.imm;
+        break;
+      case Exec::ORI:
+        regs[d.rt] = s | d.imm;
+        break;
+      case Exec::XORI:
+        regs[d.rt] = s ^ d.imm;
+        break;
+      case Exec::LUI:
+        regs[d.rt] = (uint32_t)d.imm << 16;
+        break;
+      case Exec::LW:
+        if (!load(s + d.imm, regs[d.rt])) {
+          fail("lw fuera de la memoria");
+          goto done;
+        }
+        break;
+      case Exec::SW:
+        if (!store(s + d.imm, t)) {
+          fail("sw fuera de la memoria");
+          goto done;
+        }
+        break;
+      case Exec::BEQ:
+        taken = s == t;
+        break;
+      case Exec::BNE:
+        taken = s != t;
+        break;
+      case Exec::BLEZ:
+        taken = (int32_t)s <= 0;
+        break;
+      case Exec::BGTZ:
+        taken = (int32_t)s > 0;
+        break;
+      case Exec::BLTZ:
+        taken = (int32_t)s < 0;
+        break;
+      case Exec::BGEZ:
+        taken = (int32_t)s >= 0;
+        break;
+      case Exec::JAL:
+        regs[31] = TEXT_BASE + 4 * (pc + (delay ? 2 : 1));
+        taken = true;
+        break;
+      case Exec::J:
+        taken = true;
+        break;
+      case Exec::JR:
+        if ((s - TEXT_BASE) % 4) {
+          fail("jr a una dirección no alineada");
+          goto done;
+        }
+        target = (s - TEXT_BASE) / 4;
+        taken = true;
+        break;
+      case Exec::SYSCALL:
+        if (!syscall(result)) {
+          if (!result.exited && result.error.empty()) fail("syscall");
+          goto done;
+        }
+        break;
+      case Exec::NOP:
+        break;
+      case Exec::INVALID:
+        fail("instrucción desconocida");
+        goto done;
+    }
+    regs[0] = 0;
+    if (taken) {
+      if (delay) {
+        after = target;
+      } else {
+        npc = target;
+        after = target + 1;
+        if constexpr (Timing) {
+          cycle += BRANCH_PENALTY;
+          cyclesAt[pc] += BRANCH_PENALTY;
+        }
+      }
+    }
+    pc = npc;
+    npc = after;
+  }
+done:
+  result.instructions = steps;
+  if constexpr (Timing) {
+    result.cycles = cycle;
+    result.stalls = cycle - steps;
+  }
+}
+
+// Suma los conteos de cada tramo; un tramo va de su etiqueta a la siguiente
+// que esté en otra dirección de bounds.
+static void countRegions(const std::vector<std::pair<uint32_t, std::string>>&
+                             starts,
+                         const std::vector<uint32_t>& bounds,
+                         const Machine& machine,
+                         std::vector<CodeCounts>& counts) {
+  for (const auto& [index, label] : starts) {
+    auto next = std::upper_bound(bounds.begin(), bounds.end(), index);
+    uint32_t end = next == bounds.end() ? machine.executed.size() : *next;
+    CodeCounts region{label};
+    if (index < machine.executed.size()) {
+      region.entries = machine.executed[index];
+    }
+    for (uint32_t i = index; i < end; ++i) {
+      region.instructions += machine.executed[i];
+      if (!machine.cyclesAt.empty()) region.cycles += machine.cyclesAt[i];
+    }
+    counts.push_back(region);
+  }
+}
+
+SimulationResult simulate(const ObjectCode& object,
+                          const SimulationOptions& options) {
+  SimulationResult result;
+  Machine machine(object, options);
+  if (options.pipeline) {
+    machine.run<true>(result);
+  } else {
+    machine.run<false>(result);
+  }
+
+  // Las etiquetas del código ordenadas por dirección; las funciones son un
+  // subconjunto.
+  uint32_t textEnd = TEXT_BASE + 4 * object.text.size();
+  std::vector<std::pair<uint32_t, std::string>> labels, functions;
+  for (const auto& [name, address] : object.symbols) {
+    if (address < TEXT_BASE || address > textEnd) continue;
+    labels.push_back({(address - TEXT_BASE) / 4, name});
+    if (std::find(object.functions.begin(), object.functions.end(), name) !=
+        object.functions.end()) {
+      functions.push_back(labels.back());
+    }
+  }
+  std::sort(labels.begin(), labels.end());
+  std::sort(functions.begin(), functions.end());
+  auto boundsOf = [](const std::vector<std::pair<uint32_t, std::string>>&
+                         starts) {
+    std::vector<uint32_t> bounds;
+    for (const auto& start : starts) bounds.push_back(start.first);
+    return bounds;
+  };
+  countRegions(functions, boundsOf(functions), machine, result.functions);
+  countRegions(labels, boundsOf(labels), machine, result.labels);
+  return result;
+}
+
+bool writeBranchProfile(const std::string& path,
+                        const SimulationResult& result) {
+  std::ofstream file(path);
+  if (!file) return false;
+  for (const auto& label : result.labels) {
+    file << label.label << " " << label.entries << "\n";
+  }
+  return (bool)file;
+}
+
+// La salida del programa va antes de los conteos.
+void runSimulation(const ObjectCode& object, const SimulationOptions& options,
+                   const std::string& profileOutput) {
+  std::cout << Style::bold("\nSimulation:\n");
+  SimulationResult run = simulate(object, options);
+
+  if (!run.exited) std::cout << Style::bold_red("Error: ") << run.error << "\n";
+  std::cout << "  " << run.instructions << " instrucciones";
+  if (options.pipeline) {
+    std::ostringstream cpi;
+    cpi << std::fixed << std::setprecision(2)
+        << (double)run.cycles / std::max(run.instructions, 1LL);
+    std::cout << ", " << run.cycles << " ciclos (" << run.stalls
+              << " detenidos, CPI " << cpi.str() << ")";
+  }
+  std::cout << "\n";
+
+  // Cada función con sus etiquetas debajo, en el orden del código; las
+  // etiquetas que nunca se ejecutaron no se muestran.
+  std::map<std::string, CodeCounts> functionCounts;
+  for (const auto& counts : run.functions) {
+    functionCounts[counts.label] = counts;
+  }
+  for (const auto& counts : run.labels) {
+    bool isFunction = functionCounts.count(counts.label) > 0;
+    const CodeCounts& shown =
+        isFunction ? functionCounts[counts.label] : counts;
+    if (shown.instructions == 0) continue;
+    std::cout << (isFunction ? "  " + Style::cyan(shown.label)
+                             : "    " + Style::yellow(shown.label))
+              << ": " << shown.instructions << " instrucciones, "
+              << shown.entries << (shown.entries == 1 ? " vez" : " veces");
+    if (options.pipeline) std::cout << ", " << shown.cycles << " ciclos";
+    std::cout << "\n";
+  }
+
+  if (!profileOutput.empty() && !writeBranchProfile(profileOutput, run)) {
+    std::cerr << Style::bold_red("Error: ") << "Could not write "
+              << profileOutput << "\n";
+  }
+}
@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del simulador de MIPS integrado.
+ * */
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "encoder.hpp"
+
+// Igual que SPIM: el stack empieza justo debajo de 0x7ffff000.
+constexpr uint32_t STACK_TOP = 0x7fffeffc;
+constexpr uint32_t STACK_SIZE = 8 * 1024 * 1024;
+// Como en SPIM, el segmento de datos sigue después de los globales (ahí iría
+// el heap), así que leer un poco después de un arreglo no es un error.
+constexpr uint32_t DATA_SEGMENT_SIZE = 1024 * 1024;
+constexpr long long SIMULATION_STEP_LIMIT = 1000000000;
+
+// Latencias del modelo de pipeline, en ciclos desde que la instrucción
+// entra hasta que su resultado se puede usar. Con forwarding una ALU no
+// detiene a nadie; un lw detiene un ciclo a la siguiente si usa su valor, y
+// mult/mul/div tardan lo que en un R3000.
+constexpr int LOAD_LATENCY = 2;
+constexpr int MULT_LATENCY = 12;
+constexpr int DIV_LATENCY = 35;
+// Ciclos que se pierden en un salto tomado sin delay slot.
+constexpr int BRANCH_PENALTY = 1;
+
+struct SimulationOptions {
+  // El código usa delay slots: la instrucción después de un salto siempre
+  // se ejecuta y jal guarda pc + 8.
+  bool delaySlots = false;
+  // Cuenta ciclos con el modelo de pipeline además de instrucciones.
+  bool pipeline = false;
+  long long stepLimit = SIMULATION_STEP_LIMIT;
+  std::istream* input = &std::cin;
+  std::ostream* output = &std::cout;
+};
+
+// Conteos de un tramo de código: una función o lo que va de una etiqueta a
+// la siguiente.
+struct CodeCounts {
+  std::string label;
+  // Veces que se llegó a la etiqueta.
+  long long entries = 0;
+  long long instructions = 0;
+  long long cycles = 0;
+};
+
+struct SimulationResult {
+  // Terminó con la syscall 10; si no, error dice por qué se detuvo.
+  bool exited = false;
+  std::string error;
+  long long instructions = 0;
+  // Solo con el modelo de pipeline.
+  long long cycles = 0;
+  long long stalls = 0;
+  std::vector<CodeCounts> functions;
+  std::vector<CodeCounts> labels;
+};
+
+// Ejecuta el código ya codificado. Las palabras se decodifican una sola vez
+// a una forma con los campos separados y los saltos ya convertidos a índices,
+// y el ciclo principal solo despacha sobre esa forma. Soporta las syscalls 1,
+// 4, 5, 10 y 11 de SPIM. add y sub se detienen con error si se desbordan,
+// addu y subu dan la vuelta.
+SimulationResult simulate(const ObjectCode& object,
+                          const SimulationOptions& options);
+
+// Escribe los conteos de etiquetas en el formato que lee loadBranchProfile.
+bool writeBranchProfile(const std::string& path,
+                        const SimulationResult& result);
+
+// Lo que hace -fsimulate: corre el programa e imprime su salida y luego
+// cuántas instrucciones ejecutó cada función y cada etiqueta. Si
+// profileOutput no está vacío, ahí escribe los conteos de etiquetas.
+void runSimulation(const ObjectCode& object, const SimulationOptions& options,
+                   const std::string& profileOutput);
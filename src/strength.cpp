@@ -0,0 +1,448 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de la reducción de fuerza.
+ * */
+#include "strength.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "astutil.hpp"
+#include "cfg.hpp"
+#include "mips.hpp"
+#include "parser.hpp"
+
+/*
+ *  Reducción de fuerza sobre las instrucciones
+ * */
+static bool isPowerOfTwo(unsigned x) { return x && !(x & (x - 1)); }
+
+static int log2Of(unsigned x) {
+  int k = 0;
+  while (x >>= 1) k++;
+  return k;
+}
+
+static int popcount(unsigned x) {
+  int n = 0;
+  for (; x; x &= x - 1) n++;
+  return n;
+}
+
+struct Magic {
+  int multiplier;
+  int shift;
+};
+
+// Número mágico para dividir entre d con signo (Hacker's Delight, 10-1).
+// Requiere 2 <= |d| y d distinto de INT_MIN.
+static Magic signedMagic(int d) {
+  const unsigned two31 = 0x80000000u;
+  unsigned ad = d < 0 ? -(unsigned)d : d;
+  unsigned t = two31 + ((unsigned)d >> 31);
+  unsigned anc = t - 1 - t % ad;
+  int p = 31;
+  unsigned q1 = two31 / anc, r1 = two31 - q1 * anc;
+  unsigned q2 = two31 / ad, r2 = two31 - q2 * ad;
+  unsigned delta;
+  do {
+    p++;
+    q1 *= 2;
+    r1 *= 2;
+    if (r1 >= anc) {
+      q1++;
+      r1 -= anc;
+    }
+    q2 *= 2;
+    r2 *= 2;
+    if (r2 >= ad) {
+      q2++;
+      r2 -= ad;
+    }
+    delta = ad - r2;
+  } while (q1 < delta || (q1 == delta && r1 == 0));
+
+  Magic magic{(int)(q2 + 1), p - 32};
+  if (d < 0) magic.multiplier = -magic.multiplier;
+  return magic;
+}
+
+// Las secuencias usan registros virtuales nuevos como temporales y solo
+// escriben rd en la última instrucción, así que rd puede ser el mismo que x.
+static std::vector<Instruction> multiplyByConstant(MachineFunction& fn, int rd,
+                                                   int x, int c) {
+  using namespace Mips;
+  unsigned m = c < 0 ? -(unsigned)c : c;
+  if (c == 0) return {li(rd, 0)};
+  if (c == 1) return {move(rd, x)};
+  if (c == -1) return {rtype(Op::SUBU, rd, Reg::ZERO, x)};
+
+  std::vector<Instruction> seq;
+  int product = c < 0 ? fn.newVirtual() : rd;
+  if (isPowerOfTwo(m)) {
+    seq.push_back(shift(Op::SLL, product, x, log2Of(m)));
+  } else if (popcount(m) == 2) {
+    int high = fn.newVirtual();
+    int low = log2Of(m & -m);
+    seq.push_back(shift(Op::SLL, high, x, log2Of(m)));
+    if (low == 0) {
+      seq.push_back(rtype(Op::ADDU, product, high, x));
+    } else {
+      int shifted = fn.newVirtual();
+      seq.push_back(shift(Op::SLL, shifted, x, low));
+      seq.push_back(rtype(Op::ADDU, product, high, shifted));
+    }
+  } else if (m < 0x80000000u && isPowerOfTwo(m + 1)) {
+    int high = fn.newVirtual();
+    seq.push_back(shift(Op::SLL, high, x, log2Of(m + 1)));
+    seq.push_back(rtype(Op::SUBU, product, high, x));
+  } else {
+    return {};
+  }
+
+  if (c < 0) seq.push_back(rtype(Op::SUBU, rd, Reg::ZERO, product));
+  return seq;
+}
+
+static std::vector<Instruction> divideByConstant(MachineFunction& fn, int rd,
+                                                 int x, int d) {
+  using namespace Mips;
+  if (d == 0 || d == (int)0x80000000) return {};
+  if (d == 1) return {move(rd, x)};
+  if (d == -1) return {rtype(Op::SUBU, rd, Reg::ZERO, x)};
+
+  unsigned m = d < 0 ? -(unsigned)d : d;
+  std::vector<Instruction> seq;
+  if (isPowerOfTwo(m)) {
+    // Los negativos se redondean hacia cero: se les suma 2^k - 1 antes del
+    // corrimiento aritmético.
+    int k = log2Of(m);
+    int bias = fn.newVirtual();
+    if (k == 1) {
+      seq.push_back(shift(Op::SRL, bias, x, 31));
+    } else {
+      int sign = fn.newVirtual();
+      seq.push_back(shift(Op::SRA, sign, x, 31));
+      seq.push_back(shift(Op::SRL, bias, sign, 32 - k));
+    }
+    int biased = fn.newVirtual();
+    int quotient = d < 0 ? fn.newVirtual() : rd;
+    seq.push_back(rtype(Op::ADDU, biased, x, bias));
+    seq.push_back(shift(Op::SRA, quotient, biased, k));
+    if (d < 0) seq.push_back(rtype(Op::SUBU, rd, Reg::ZERO, quotient));
+    return seq;
+  }
+
+  Magic magic = signedMagic(d);
+  int multiplier = fn.newVirtual();
+  int q = fn.newVirtual();
+  seq.push_back(li(multiplier, magic.multiplier));
+  seq.push_back(hilo(Op::MULT, x, multiplier));
+  seq.push_back(moveFrom(Op::MFHI, q));
+  if (d > 0 && magic.multiplier < 0) {
+    int corrected = fn.newVirtual();
+    seq.push_back(rtype(Op::ADDU, corrected, q, x));
+    q = corrected;
+  } else if (d < 0 && magic.multiplier > 0) {
+    int corrected = fn.newVirtual();
+    seq.push_back(rtype(Op::SUBU, corrected, q, x));
+    q = corrected;
+  }
+  if (magic.shift > 0) {
+    int shifted = fn.newVirtual();
+    seq.push_back(shift(Op::SRA, shifted, q, magic.shift));
+    q = shifted;
+  }
+  // Se suma 1 a los cocientes negativos para redondear hacia cero.
+  int sign = fn.newVirtual();
+  seq.push_back(shift(Op::SRL, sign, q, 31));
+  seq.push_back(rtype(Op::ADDU, rd, q, sign));
+  return seq;
+}
+
+// Indica si alguien puede leer HI (el residuo) después de la instrucción i.
+static bool hiReadAfter(const MachineFunction& fn, const ControlFlowGraph& cfg,
+                        int i) {
+  for (const auto& block : cfg.blocks) {
+    if (i < block.begin || i >= block.end) continue;
+    for (int j = i + 1; j < block.end; ++j) {
+      if (fn.code[j].op == Op::MFHI) return true;
+      for (int d : Mips::defs(fn.code[j])) {
+        if (d == Reg::HI) return false;
+      }
+    }
+    return block.liveOut.count(Reg::HI) > 0;
+  }
+  return true;
+}
+
+int reduceStrength(MachineFunction& fn) {
+  ControlFlowGraph cfg(fn);
+  computeLiveness(fn, cfg);
+
+  const auto& code = fn.code;
+  std::vector<Instruction> result;
+  // Valor conocido de los registros cargados con li dentro del bloque.
+  std::map<int, int> known;
+  int reduced = 0;
+
+  for (int i = 0; i < (int)code.size(); ++i) {
+    const Instruction& inst = code[i];
+    if (inst.isLabel()) known.clear();
+
+    std::vector<Instruction> seq;
+    if (inst.op == Op::MUL && known.count(inst.rt)) {
+      seq = multiplyByConstant(fn, inst.rd, inst.rs, known[inst.rt]);
+    } else if (inst.op == Op::MUL && known.count(inst.rs)) {
+      seq = multiplyByConstant(fn, inst.rd, inst.rt, known[inst.rs]);
+    } else if (inst.op == Op::DIV && known.count(inst.rt) &&
+               i + 1 < (int)code.size() && code[i + 1].op == Op::MFLO &&
+               !hiReadAfter(fn, cfg, i + 1)) {
+      seq = divideByConstant(fn, code[i + 1].rd, inst.rs, known[inst.rt]);
+      if (!seq.empty()) ++i;
+    }
+
+    if (seq.empty()) {
+      seq.push_back(inst);
+    } else {
+      reduced++;
+    }
+    for (const auto& emitted : seq) {
+      for (int d : Mips::defs(emitted)) known.erase(d);
+      if (emitted.op == Op::LI) known[emitted.rd] = emitted.imm;
+      result.push_back(emitted);
+    }
+  }
+
+  fn.code = std::move(result);
+  return reduced;
+}
+
+/*
+ *  Reducción de fuerza de variables de inducción sobre el árbol
+ * */
+static int inductionCounter = 0;
+
+namespace {
+
+// Una asignación i = i + c que aparece como statement dentro de un bloque.
+struct InductionUpdate {
+  CompoundStatementNode* parent;
+  ExpressionStatementNode* stmt;
+  int step;
+};
+
+// Una multiplicación i * k al inicio de una cadena de TermNode.
+struct InductionMultiply {
+  TermNode* term;
+  std::string iv;
+  bool constant;
+  int value;
+  std::string name;
+};
+
+}  // namespace
+
+static void collectUpdates(StatementNode* stmt, CompoundStatementNode* parent,
+                           std::map<std::string, std::vector<InductionUpdate>>&
+                               updates) {
+  if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+    for (auto& child : comp->statements) {
+      collectUpdates(child.get(), comp, updates);
+    }
+  } else if (auto expr = dynamic_cast<ExpressionStatementNode*>(stmt)) {
+    std::string var;
+    int step;
+    if (parent && expr->expression &&
+        matchInductionUpdate(expr, var, step)) {
+      updates[var].push_back({parent, expr, step});
+    }
+  } else if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+    collectUpdates(sel->statement.get(), nullptr, updates);
+    collectUpdates(sel->elseStatement.get(), nullptr, updates);
+  } else if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+    collectUpdates(iter->statement.get(), nullptr, updates);
+  }
+}
+
+static int reduceLoop(std::vector<std::unique_ptr<StatementNode>>& list,
+                      int index, FunDeclarationNode* fun,
+                      const std::set<std::string>& scalars) {
+  auto loop = static_cast<IterationStatementNode*>(list[index].get());
+
+  // Cuántas veces se asigna cada variable dentro del loop, contando también
+  // las asignaciones anidadas en expresiones.
+  std::map<std::string, int> assigned;
+  std::set<TermNode*> chained;
+  std::vector<TermNode*> products;
+  auto scan = [&](ExpressionNode* expr) {
+    if (auto assign = dynamic_cast<AssignmentExpressionNode*>(expr)) {
+      assigned[assign->var->id]++;
+    } else if (auto term = dynamic_cast<TermNode*>(expr)) {
+      if (term->rightFactor) chained.insert(term->rightFactor.get());
+      if (term->rightFactor && term->mulop == TokenType::TIMES) {
+        products.push_back(term);
+      }
+    }
+  };
+  forEachExpression(loop->expression.get(), scan);
+  forEachExpression(loop->statement.get(), scan);
+
+  std::map<std::string, std::vector<InductionUpdate>> updates;
+  collectUpdates(loop->statement.get(), nullptr, updates);
+
+  // Una variable de inducción es un escalar local que solo cambia con
+  // statements i = i + c.
+  auto isInduction = [&](const std::string& id) {
+    return scalars.count(id) && updates.count(id) &&
+           (int)updates[id].size() == assigned[id];
+  };
+  auto isInvariant = [&](const std::string& id) {
+    return scalars.count(id) && !assigned.count(id);
+  };
+
+  std::vector<InductionMultiply> sites;
+  for (TermNode* term : products) {
+    if (chained.count(term)) continue;
+    FactorNode* a = term->leftFactor.get();
+    FactorNode* b = term->rightFactor->leftFactor.get();
+    for (int swap = 0; swap < 2; ++swap) {
+      VarNode* iv = bareVar(swap ? b : a);
+      FactorNode* k = swap ? a : b;
+      if (!iv || !isInduction(iv->id)) continue;
+
+      InductionMultiply site{term, iv->id, isLiteral(k), 0, ""};
+      if (site.constant) {
+        site.value = k->value;
+        // Por potencias de dos ya alcanza con un corrimiento.
+        unsigned m = site.value < 0 ? -(unsigned)site.value : site.value;
+        if (m <= 1 || isPowerOfTwo(m)) continue;
+      } else {
+        VarNode* kv = bareVar(k);
+        if (!kv || kv->id == iv->id || !isInvariant(kv->id)) continue;
+        // Con k variable el paso c * k solo se puede sumar directo si c es
+        // 1 o -1.
+        bool unitSteps = true;
+        for (const auto& update : updates[iv->id]) {
+          if (update.step != 1 && update.step != -1) unitSteps = false;
+        }
+        if (!unitSteps) continue;
+        site.name = kv->id;
+      }
+      sites.push_back(site);
+      break;
+    }
+  }
+  if (sites.empty()) return 0;
+
+  // Una variable auxiliar por cada par (i, k) distinto.
+  std::map<std::string, std::string> temps;
+  std::map<CompoundStatementNode*,
+           std::vector<std::pair<int, std::unique_ptr<StatementNode>>>>
+      inserts;
+  std::vector<std::unique_ptr<StatementNode>> preheader;
+
+  for (auto& site : sites) {
+    std::string key = site.iv + "*" +
+                      (site.constant ? std::to_string(site.value) : site.name);
+    if (!temps.count(key)) {
+      std::string temp = "_iv" + std::to_string(inductionCounter++);
+      temps[key] = temp;
+      fun->compoundStatement->vars.push_back(makeLocal(temp, site.term));
+
+      auto k = site.constant ? makeNumberFactor(site.value, site.term)
+                             : makeVarFactor(site.name, site.term);
+      preheader.push_back(makeAssignment(
+          temp, makeExpression(makeVarFactor(site.iv, site.term),
+                               TokenType::TIMES, std::move(k))));
+
+      for (const auto& update : updates[site.iv]) {
+        auto& stmts = update.parent->statements;
+        int at = 0;
+        while (stmts[at].get() != update.stmt) at++;
+
+        TokenType op = TokenType::ADD;
+        std::unique_ptr<FactorNode> delta;
+        if (site.constant) {
+          int step = update.step * site.value;
+          if (step < 0) op = TokenType::SUB;
+          delta = makeNumberFactor(step < 0 ? -step : step, site.term);
+        } else {
+          if (update.step < 0) op = TokenType::SUB;
+          delta = makeVarFactor(site.name, site.term);
+        }
+        inserts[update.parent].push_back(
+            {at + 1, makeAssignment(temp, makeExpression(
+                                              makeVarFactor(temp, site.term),
+                                              op, std::move(delta)))});
+      }
+    }
+
+    // i * k * resto  ->  temp * resto
+    TermNode* term = site.term;
+    auto rest = std::move(term->rightFactor->rightFactor);
+    term->mulop = term->rightFactor->mulop;
+    term->leftFactor = makeVarFactor(temps[key], term);
+    term->rightFactor = std::move(rest);
+  }
+
+  for (auto& [parent, list] : inserts) {
+    std::stable_sort(list.begin(), list.end(), [](auto& a, auto& b) {
+      return a.first > b.first;
+    });
+    for (auto& [at, stmt] : list) {
+      parent->statements.insert(parent->statements.begin() + at,
+                                std::move(stmt));
+    }
+  }
+  for (int i = preheader.size() - 1; i >= 0; --i) {
+    list.insert(list.begin() + index, std::move(preheader[i]));
+  }
+  return sites.size();
+}
+
+static int reduceStatements(std::vector<std::unique_ptr<StatementNode>>& list,
+                            FunDeclarationNode* fun,
+                            const std::set<std::string>& scalars) {
+  int reduced = 0;
+  for (int i = 0; i < (int)list.size(); ++i) {
+    if (dynamic_cast<IterationStatementNode*>(list[i].get())) {
+      int before = list.size();
+      reduced += reduceLoop(list, i, fun, scalars);
+      i += list.size() - before;
+    }
+
+    StatementNode* stmt = list[i].get();
+    std::vector<StatementNode*> children;
+    if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+      reduced += reduceStatements(comp->statements, fun, scalars);
+    } else if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+      children.push_back(iter->statement.get());
+    } else if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+      children.push_back(sel->statement.get());
+      children.push_back(sel->elseStatement.get());
+    }
+    for (auto child : children) {
+      if (auto comp = dynamic_cast<CompoundStatementNode*>(child)) {
+        reduced += reduceStatements(comp->statements, fun, scalars);
+      }
+    }
+  }
+  return reduced;
+}
+
+int reduceInductionMultiplies(ProgramNode* program) {
+  int reduced = 0;
+  for (auto& decl : program->declarationList) {
+    auto fun = dynamic_cast<FunDeclarationNode*>(decl.get());
+    if (!fun || !fun->compoundStatement) continue;
+
+    std::set<std::string> scalars = singleScalars(fun);
+    reduced += reduceStatements(fun->compoundStatement->statements, fun,
+                                scalars);
+  }
+  return reduced;
+}
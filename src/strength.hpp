@@ -0,0 +1,17 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de la reducción de fuerza.
+ * */
+#pragma once
+
+#include "mips.hpp"
+#include "parser.hpp"
+
+// Cambia mul y div por constantes por corrimientos, sumas o la secuencia de
+// multiplicación por el número mágico. Regresa cuántas operaciones cambió.
+int reduceStrength(MachineFunction& fn);
+
+// Dentro de cada while, cambia las multiplicaciones i * k de una variable de
+// inducción i (que solo cambia con i = i + c) por una variable auxiliar que se
+// actualiza con sumas junto con i. Regresa cuántas multiplicaciones quitó.
+int reduceInductionMultiplies(ProgramNode* program);
@@ -0,0 +1,397 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del desenrollado de loops.
+ * */
+#include "unroll.hpp"
+
+#include <climits>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "astutil.hpp"
+#include "parser.hpp"
+
+namespace {
+
+// Un while de la forma `while (i relop bound)` con i = i + step como único
+// cambio a i. La comparación se normaliza para que i quede a la izquierda.
+struct CountedLoop {
+  std::string iv;
+  int step;
+  TokenType relop;
+  FactorNode* bound;
+  // Posición de i = i + step en el bloque del cuerpo.
+  int update;
+};
+
+}  // namespace
+
+static TokenType flip(TokenType relop) {
+  switch (relop) {
+    case TokenType::LT:
+      return TokenType::GT;
+    case TokenType::LTE:
+      return TokenType::GTE;
+    case TokenType::GT:
+      return TokenType::LT;
+    default:
+      return TokenType::LTE;
+  }
+}
+
+static bool analyzeLoop(IterationStatementNode* loop,
+                        const std::set<std::string>& scalars,
+                        CountedLoop& counted) {
+  // Solo loops internos cuyo cuerpo es un bloque sin declaraciones.
+  auto body = dynamic_cast<CompoundStatementNode*>(loop->statement.get());
+  if (!body || !body->vars.empty()) return false;
+  bool inner = true;
+  forEachStatement(body, [&](StatementNode* s) {
+    if (dynamic_cast<IterationStatementNode*>(s)) inner = false;
+  });
+  if (!inner) return false;
+
+  SimpleExpressionNode* cond = asComparison(loop->expression.get());
+  if (!cond || cond->relop == TokenType::EQ ||
+      cond->relop == TokenType::NOT_EQ) {
+    return false;
+  }
+  FactorNode* left = asFactor(cond->additiveLeft.get());
+  FactorNode* right = asFactor(cond->additiveRight.get());
+  if (!left || !right) return false;
+
+  std::map<std::string, int> assigned;
+  auto scan = [&](ExpressionNode* expr) {
+    if (auto assign = dynamic_cast<AssignmentExpressionNode*>(expr)) {
+      assigned[assign->var->id]++;
+    }
+  };
+  forEachExpression(loop->expression.get(), scan);
+  forEachExpression(body, scan);
+
+  for (int swap = 0; swap < 2; ++swap) {
+    VarNode* iv = bareVar(swap ? right : left);
+    FactorNode* bound = swap ? left : right;
+    if (!iv || !scalars.count(iv->id) || assigned[iv->id] != 1) continue;
+    VarNode* boundVar = bareVar(bound);
+    if (!isLiteral(bound) &&
+        !(boundVar && scalars.count(boundVar->id) &&
+          !assigned.count(boundVar->id))) {
+      continue;
+    }
+
+    // La única asignación a i tiene que ser un statement del bloque, para
+    // que pase exactamente una vez por vuelta.
+    int step = 0, update = -1;
+    for (int k = 0; k < (int)body->statements.size(); ++k) {
+      auto expr =
+          dynamic_cast<ExpressionStatementNode*>(body->statements[k].get());
+      std::string var;
+      int c;
+      if (expr && expr->expression && matchInductionUpdate(expr, var, c) &&
+          var == iv->id) {
+        step = c;
+        update = k;
+      }
+    }
+    TokenType relop = swap ? flip(cond->relop) : cond->relop;
+    bool up = relop == TokenType::LT || relop == TokenType::LTE;
+    if (step == 0 || (step > 0) != up) continue;
+
+    counted = {iv->id, step, relop, bound, update};
+    return true;
+  }
+  return false;
+}
+
+// Vueltas de un loop que empieza con i = init, o -1 si no se sabe.
+static long long tripCount(const CountedLoop& loop, long long init) {
+  if (!isLiteral(loop.bound)) return -1;
+  long long distance = loop.bound->value - init;
+  long long step = loop.step;
+  if (step < 0) {
+    distance = -distance;
+    step = -step;
+  }
+  bool inclusive =
+      loop.relop == TokenType::LTE || loop.relop == TokenType::GTE;
+  if (inclusive) distance++;
+  if (distance <= 0) return 0;
+  return (distance + step - 1) / step;
+}
+
+// Cambia cada lectura de i por la constante value o, si no es literal, por
+// (i + value). Un producto i * c queda como (i * c + value * c) para que la
+// reducción de fuerza lo siga viendo.
+static void substitute(StatementNode* stmt, const std::string& iv,
+                       bool literal, int value) {
+  std::vector<TermNode*> products;
+  std::set<TermNode*> chained;
+  std::set<FactorNode*> inProduct;
+  if (!literal && value != 0) {
+    forEachExpression(stmt, [&](ExpressionNode* expr) {
+      auto term = dynamic_cast<TermNode*>(expr);
+      if (!term || !term->rightFactor) return;
+      chained.insert(term->rightFactor.get());
+      if (term->mulop == TokenType::TIMES &&
+          !term->rightFactor->rightFactor) {
+        products.push_back(term);
+      }
+    });
+  }
+  std::vector<TermNode*> reducible;
+  for (TermNode* term : products) {
+    if (chained.count(term)) continue;
+    FactorNode* a = term->leftFactor.get();
+    FactorNode* b = term->rightFactor->leftFactor.get();
+    VarNode* var = bareVar(isLiteral(b) ? a : b);
+    if (!var || var->id != iv || !(isLiteral(a) || isLiteral(b))) continue;
+    reducible.push_back(term);
+    inProduct.insert(isLiteral(b) ? a : b);
+  }
+
+  std::vector<FactorNode*> uses;
+  forEachExpression(stmt, [&](ExpressionNode* expr) {
+    auto factor = dynamic_cast<FactorNode*>(expr);
+    VarNode* var = bareVar(factor);
+    if (var && var->id == iv && !inProduct.count(factor)) {
+      uses.push_back(factor);
+    }
+  });
+  for (FactorNode* factor : uses) {
+    if (literal) {
+      factor->value = value;
+    } else if (value != 0) {
+      factor->expression = makeExpression(
+          makeVarFactor(iv, factor),
+          value < 0 ? TokenType::SUB : TokenType::ADD,
+          makeNumberFactor(value < 0 ? -value : value, factor));
+    } else {
+      continue;
+    }
+    factor->var.reset();
+  }
+
+  for (TermNode* term : reducible) {
+    FactorNode* b = term->rightFactor->leftFactor.get();
+    int c = isLiteral(b) ? b->value : term->leftFactor->value;
+    int offset = value * c;
+    auto product = std::make_unique<FactorNode>(term->getLineno(),
+                                                term->getPosition());
+    product->expression = makeExpression(makeVarFactor(iv, term),
+                                         TokenType::TIMES,
+                                         makeNumberFactor(c, term));
+    product->expressionType = ExpressionType::Integer;
+    auto sum = std::make_unique<FactorNode>(term->getLineno(),
+                                            term->getPosition());
+    sum->expression = makeExpression(
+        std::move(product), offset < 0 ? TokenType::SUB : TokenType::ADD,
+        makeNumberFactor(offset < 0 ? -offset : offset, term));
+    sum->expressionType = ExpressionType::Integer;
+    term->leftFactor = std::move(sum);
+    term->rightFactor.reset();
+  }
+}
+
+// Si el statement anterior al loop es i = constante regresa la constante.
+static bool initialValue(std::vector<std::unique_ptr<StatementNode>>& list,
+                         int index, const std::string& iv, int& value) {
+  if (index == 0) return false;
+  auto stmt = dynamic_cast<ExpressionStatementNode*>(list[index - 1].get());
+  if (!stmt) return false;
+  auto assign =
+      dynamic_cast<AssignmentExpressionNode*>(stmt->expression.get());
+  if (!assign || assign->var->expression || assign->var->id != iv) {
+    return false;
+  }
+  FactorNode* factor = asFactor(assign->simpleExpression.get());
+  if (!isLiteral(factor)) return false;
+  value = factor->value;
+  return true;
+}
+
+// Una expresión aditiva que es solo el factor.
+static std::unique_ptr<AdditiveExpressionNode> additiveOf(
+    std::unique_ptr<FactorNode> factor) {
+  int line = factor->getLineno(), pos = factor->getPosition();
+  auto additive = std::make_unique<AdditiveExpressionNode>(line, pos);
+  additive->leftTerm = std::make_unique<TermNode>(line, pos);
+  additive->leftTerm->leftFactor = std::move(factor);
+  return additive;
+}
+
+static std::unique_ptr<SimpleExpressionNode> makeComparison(
+    std::unique_ptr<FactorNode> left, TokenType relop,
+    std::unique_ptr<FactorNode> right) {
+  auto cond = std::make_unique<SimpleExpressionNode>(left->getLineno(),
+                                                     left->getPosition());
+  cond->additiveLeft = additiveOf(std::move(left));
+  cond->relop = relop;
+  cond->additiveRight = additiveOf(std::move(right));
+  cond->expressionType = ExpressionType::Integer;
+  return cond;
+}
+
+static bool unrollLoop(std::vector<std::unique_ptr<StatementNode>>& list,
+                       int index, FunDeclarationNode* fun,
+                       const std::set<std::string>& scalars, int factor,
+                       std::vector<UnrollDecision>& decisions) {
+  auto loop = static_cast<IterationStatementNode*>(list[index].get());
+  CountedLoop counted;
+  if (!analyzeLoop(loop, scalars, counted)) return false;
+  auto body = static_cast<CompoundStatementNode*>(loop->statement.get());
+
+  int size = 0;
+  forEachExpression(body, [&](ExpressionNode* expr) {
+    if (dynamic_cast<FactorNode*>(expr)) size++;
+  });
+  int init;
+  long long trips = -1;
+  if (initialValue(list, index, counted.iv, init)) {
+    trips = tripCount(counted, init);
+  }
+  int line = loop->getLineno();
+
+  // Copias del cuerpo sin el i = i + step: la copia k lee i + k * step (o
+  // (k + 1) * step después de donde estaba la actualización), o la constante
+  // si se conoce el valor inicial.
+  auto copies = [&](long long times, bool literal) {
+    std::vector<std::unique_ptr<StatementNode>> result;
+    for (long long k = 0; k < times; ++k) {
+      for (int j = 0; j < (int)body->statements.size(); ++j) {
+        if (j == counted.update) continue;
+        int offset = (j < counted.update ? k : k + 1) * counted.step;
+        result.push_back(cloneStatement(body->statements[j].get()));
+        substitute(result.back().get(), counted.iv, literal,
+                   literal ? init + offset : offset);
+      }
+    }
+    return result;
+  };
+
+  // Pocas vueltas conocidas: el loop desaparece.
+  if (trips >= 0 && trips <= FULL_UNROLL_TRIPS &&
+      trips * size <= UNROLL_SIZE_LIMIT) {
+    auto unrolled = copies(trips, true);
+    // i queda con el valor que tendría al salir del loop.
+    unrolled.push_back(makeAssignment(
+        counted.iv, makeNumberFactor(init + trips * counted.step,
+                                     loop->expression.get())));
+    list.erase(list.begin() + index);
+    list.insert(list.begin() + index,
+                std::make_move_iterator(unrolled.begin()),
+                std::make_move_iterator(unrolled.end()));
+    decisions.push_back({fun->id, line, 0, (int)trips});
+    return true;
+  }
+
+  if (factor < 2 || size * factor > UNROLL_SIZE_LIMIT) return false;
+  if (trips >= 0 && trips < factor) return false;
+
+  // while (i relop bound - (factor - 1) * step) { cuerpo x factor }: si la
+  // última copia de la vuelta cumple la condición, todas la cumplen. La
+  // resta va del lado de bound porque i + reach se desborda cerca del
+  // extremo aunque el loop original no; bound - reach solo se desborda si
+  // bound está a menos de reach del extremo contrario, y eso se revisa al
+  // compilar si bound es constante o antes de entrar si no.
+  ExpressionNode* origin = loop->expression.get();
+  long long reach = (long long)(factor - 1) * counted.step;
+  long long edge = reach > 0 ? INT_MIN + reach : INT_MAX + reach;
+  std::unique_ptr<FactorNode> limit;
+  if (isLiteral(counted.bound)) {
+    long long value = counted.bound->value - reach;
+    if (value < INT_MIN || value > INT_MAX) return false;
+    limit = makeNumberFactor(value, origin);
+  } else {
+    limit = std::make_unique<FactorNode>(line, loop->getPosition());
+    limit->expression = makeExpression(
+        makeVarFactor(counted.bound->var->id, origin),
+        reach < 0 ? TokenType::ADD : TokenType::SUB,
+        makeNumberFactor(reach < 0 ? -reach : reach, origin));
+    limit->expressionType = ExpressionType::Integer;
+  }
+  auto cond = makeComparison(makeVarFactor(counted.iv, origin),
+                             counted.relop, std::move(limit));
+
+  auto unrolled = std::make_unique<IterationStatementNode>(
+      line, loop->getPosition());
+  unrolled->expression = std::move(cond);
+  auto block =
+      std::make_unique<CompoundStatementNode>(line, loop->getPosition());
+  block->statements = copies(factor, false);
+  int advance = factor * counted.step;
+  block->statements.push_back(makeAssignment(
+      counted.iv,
+      makeExpression(makeVarFactor(counted.iv, loop->expression.get()),
+                     advance < 0 ? TokenType::SUB : TokenType::ADD,
+                     makeNumberFactor(advance < 0 ? -advance : advance,
+                                      loop->expression.get()))));
+  unrolled->statement = std::move(block);
+
+  // Si las vueltas son múltiplo del factor no sobra ninguna y el loop
+  // original ya no hace falta; eso solo se sabe con bound constante.
+  if (trips >= 0 && trips % factor == 0) {
+    list[index] = std::move(unrolled);
+  } else if (isLiteral(counted.bound)) {
+    list.insert(list.begin() + index, std::move(unrolled));
+  } else {
+    // if (bound >= INT_MIN + reach) (o <= INT_MAX + reach si i baja); si
+    // no se cumple, el loop original hace todas las vueltas.
+    auto guard = std::make_unique<SelectionStatementNode>(
+        line, loop->getPosition());
+    guard->condition = makeComparison(
+        makeVarFactor(counted.bound->var->id, origin),
+        reach > 0 ? TokenType::GTE : TokenType::LTE,
+        makeNumberFactor(edge, origin));
+    guard->statement = std::move(unrolled);
+    list.insert(list.begin() + index, std::move(guard));
+  }
+  decisions.push_back({fun->id, line, factor, (int)trips});
+  return true;
+}
+
+static void unrollStatements(std::vector<std::unique_ptr<StatementNode>>& list,
+                             FunDeclarationNode* fun,
+                             const std::set<std::string>& scalars, int factor,
+                             std::vector<UnrollDecision>& decisions) {
+  for (int i = 0; i < (int)list.size(); ++i) {
+    if (dynamic_cast<IterationStatementNode*>(list[i].get())) {
+      int before = list.size();
+      if (unrollLoop(list, i, fun, scalars, factor, decisions)) {
+        // Lo que se insertó ya no tiene loops que desenrollar.
+        i += list.size() - before;
+        continue;
+      }
+    }
+
+    StatementNode* stmt = list[i].get();
+    std::vector<StatementNode*> children;
+    if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+      children.push_back(comp);
+    } else if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+      children.push_back(iter->statement.get());
+    } else if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+      children.push_back(sel->statement.get());
+      children.push_back(sel->elseStatement.get());
+    }
+    for (auto child : children) {
+      if (auto comp = dynamic_cast<CompoundStatementNode*>(child)) {
+        unrollStatements(comp->statements, fun, scalars, factor, decisions);
+      }
+    }
+  }
+}
+
+std::vector<UnrollDecision> unrollLoops(ProgramNode* program, int factor) {
+  std::vector<UnrollDecision> decisions;
+  for (auto& decl : program->declarationList) {
+    auto fun = dynamic_cast<FunDeclarationNode*>(decl.get());
+    if (!fun || !fun->compoundStatement) continue;
+    unrollStatements(fun->compoundStatement->statements, fun,
+                     singleScalars(fun), factor, decisions);
+  }
+  return decisions;
+}
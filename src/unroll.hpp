@@ -0,0 +1,33 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del desenrollado de loops.
+ * */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+
+// Factor de -funroll-loops cuando no se da uno.
+constexpr int UNROLL_DEFAULT_FACTOR = 4;
+// Tamaño máximo, en operandos, del cuerpo ya desenrollado.
+constexpr int UNROLL_SIZE_LIMIT = 64;
+// Los loops con a lo más estas vueltas conocidas se desenrollan completos.
+constexpr int FULL_UNROLL_TRIPS = 16;
+
+struct UnrollDecision {
+  std::string function;
+  int line;
+  // Copias del cuerpo por vuelta, o 0 si se desenrolló completo.
+  int factor;
+  // Vueltas conocidas en tiempo de compilación, o -1.
+  int trips;
+};
+
+// Desenrolla los while internos con una variable de inducción i que solo
+// cambia con i = i + c y se compara contra un límite invariante. El loop
+// desenrollado corre factor vueltas a la vez mientras alcancen y el original
+// se queda para las que sobran. Si el número de vueltas es constante y chico
+// el loop se reemplaza por copias del cuerpo.
+std::vector<UnrollDecision> unrollLoops(ProgramNode* program, int factor);
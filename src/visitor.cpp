@@ -222,6 +222,9 @@ void SymbolTableVisitor::visitImpl(VarNode* node) {
 
 void SymbolTableVisitor::visitImpl(ParamNode* node) {
   symbolTable.currScope->symbolTable.addUsage(node->id, node->getLineno());
+  if (node->isArray) {
+    symbolTable.currScope->symbolTable.symbolTable[node->id].isArray = true;
+  }
 }
 
 void SymbolTableVisitor::visitImpl(DeclarationNode* node) {
@@ -0,0 +1,351 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file de la VM que ejecuta el bytecode.
+ * */
+#include "vm.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "colors.hpp"
+#include "simulator.hpp"
+
+// Con GCC y Clang cada instrucción salta directo a la siguiente con un goto
+// calculado; si no, se despacha con un switch.
+#if defined(__GNUC__)
+#define VM_COMPUTED_GOTO 1
+#else
+#define VM_COMPUTED_GOTO 0
+#endif
+
+VirtualMachine::VirtualMachine(const BytecodeProgram& program)
+    : program(program),
+      memory(program.globalsSize + VM_DATA_HEADROOM + VM_STACK_WORDS, 0),
+      calls(VM_MAX_CALL_DEPTH) {}
+
+VmResult VirtualMachine::run(const std::vector<int>& input,
+                             long long stepLimit) {
+  VmResult result;
+  std::fill(memory.begin(), memory.begin() + dirty, 0);
+
+  const uint32_t size = memory.size();
+  const uint32_t stackBase = program.globalsSize + VM_DATA_HEADROOM;
+  const VmInstruction* code = program.code.data();
+  const VmFunction* functions = program.functions.data();
+  int32_t* mem = memory.data();
+  CallRecord* frames = calls.data();
+
+  const VmInstruction* ip = code;
+  uint32_t fp = stackBase;
+  int32_t* regs = mem + fp;
+  // Lo más alto de la memoria que se usó, para limpiar solo eso después.
+  uint32_t highWater = stackBase;
+  size_t depth = 0;
+  size_t nextInput = 0;
+  long long steps = 0;
+  int32_t returned = 0;
+  uint32_t address = 0;
+  char digits[16];
+
+#if VM_COMPUTED_GOTO
+  // En el mismo orden que VmOp.
+  static const void* dispatch[] = {
+      &&vm_LOADK,  &&vm_MOVE,   &&vm_ADD,    &&vm_ADDK,   &&vm_SUB,
+      &&vm_MUL,    &&vm_DIV,    &&vm_LT,     &&vm_LE,     &&vm_GT,
+      &&vm_GE,     &&vm_EQ,     &&vm_NE,     &&vm_JMP,    &&vm_JLT,
+      &&vm_JLE,    &&vm_JGT,    &&vm_JGE,    &&vm_JEQ,    &&vm_JNE,
+      &&vm_JZ,     &&vm_JNZ,    &&vm_GET,    &&vm_PUT,    &&vm_LOADG,
+      &&vm_LOADL,  &&vm_LOADP,  &&vm_STOREG, &&vm_STOREL, &&vm_STOREP,
+      &&vm_ADDR,   &&vm_CHECK,  &&vm_CALL,   &&vm_RET,    &&vm_RETV,
+      &&vm_INPUT,  &&vm_OUTPUT, &&vm_HALT};
+  static_assert(sizeof(dispatch) / sizeof(*dispatch) ==
+                static_cast<int>(VmOp::HALT) + 1);
+#define VM_CASE(name) vm_##name:
+#define VM_DISPATCH() \
+  ++steps;            \
+  goto* dispatch[static_cast<int>(ip->op)]
+#else
+#define VM_CASE(name) case VmOp::name:
+#define VM_DISPATCH() continue
+#endif
+#define VM_NEXT() \
+  ++ip;           \
+  VM_DISPATCH()
+// Los saltos y las llamadas revisan el límite de pasos; todo lo demás
+// avanza.
+#define VM_JUMP(target)                      \
+  ip = code + (target);                      \
+  if (steps > stepLimit) goto stepsExceeded; \
+  VM_DISPATCH()
+// Aritmética de 32 bits que da la vuelta, como addu y mul.
+#define VM_ARITHMETIC(name, op)                                    \
+  VM_CASE(name) {                                                  \
+    uint32_t left = regs[ip->b], right = regs[ip->c];              \
+    regs[ip->a] = (int32_t)(left op right);                        \
+    VM_NEXT();                                                     \
+  }
+#define VM_COMPARE(name, jumpName, op)                             \
+  VM_CASE(name) {                                                  \
+    regs[ip->a] = regs[ip->b] op regs[ip->c];                      \
+    VM_NEXT();                                                     \
+  }                                                                \
+  VM_CASE(jumpName) {                                              \
+    if (regs[ip->b] op regs[ip->c]) {                              \
+      VM_JUMP(ip->a);                                              \
+    }                                                              \
+    VM_NEXT();                                                     \
+  }
+// Una dirección de memoria revisada y marcada como usada.
+#define VM_ADDRESS(base, index)                           \
+  address = (uint32_t)(base) + (uint32_t)(index);         \
+  if (address >= size) goto outOfMemory;                  \
+  if (address >= highWater) highWater = address + 1
+#define VM_RETURN(value)                                  \
+  {                                                       \
+    returned = (value);                                   \
+    const CallRecord& record = frames[--depth];           \
+    fp = record.fp;                                       \
+    regs = mem + fp;                                      \
+    if (record.dest >= 0) regs[record.dest] = returned;   \
+    ip = record.returnTo;                                 \
+    VM_DISPATCH();                                        \
+  }
+
+#if VM_COMPUTED_GOTO
+  VM_DISPATCH();
+#else
+  for (;;) {
+    ++steps;
+    switch (ip->op) {
+#endif
+  VM_CASE(LOADK) {
+    regs[ip->a] = ip->b;
+    VM_NEXT();
+  }
+  VM_CASE(MOVE) {
+    regs[ip->a] = regs[ip->b];
+    VM_NEXT();
+  }
+  VM_ARITHMETIC(ADD, +)
+  VM_ARITHMETIC(SUB, -)
+  VM_ARITHMETIC(MUL, *)
+  VM_CASE(ADDK) {
+    regs[ip->a] = (int32_t)((uint32_t)regs[ip->b] + (uint32_t)ip->c);
+    VM_NEXT();
+  }
+  VM_CASE(DIV) {
+    int32_t divisor = regs[ip->c];
+    if (divisor == 0) goto divisionByZero;
+    // INT_MIN / -1 da INT_MIN, como en MIPS.
+    regs[ip->a] = divisor == -1 ? (int32_t)(0u - (uint32_t)regs[ip->b])
+                                : regs[ip->b] / divisor;
+    VM_NEXT();
+  }
+  VM_COMPARE(LT, JLT, <)
+  VM_COMPARE(LE, JLE, <=)
+  VM_COMPARE(GT, JGT, >)
+  VM_COMPARE(GE, JGE, >=)
+  VM_COMPARE(EQ, JEQ, ==)
+  VM_COMPARE(NE, JNE, !=)
+  VM_CASE(JMP) { VM_JUMP(ip->a); }
+  VM_CASE(JZ) {
+    if (regs[ip->b] == 0) {
+      VM_JUMP(ip->a);
+    }
+    VM_NEXT();
+  }
+  VM_CASE(JNZ) {
+    if (regs[ip->b] != 0) {
+      VM_JUMP(ip->a);
+    }
+    VM_NEXT();
+  }
+  VM_CASE(GET) {
+    regs[ip->a] = mem[ip->b];
+    VM_NEXT();
+  }
+  VM_CASE(PUT) {
+    mem[ip->a] = regs[ip->b];
+    VM_NEXT();
+  }
+  VM_CASE(LOADG) {
+    VM_ADDRESS(ip->b, regs[ip->c]);
+    regs[ip->a] = mem[address];
+    VM_NEXT();
+  }
+  VM_CASE(LOADL) {
+    VM_ADDRESS(fp + ip->b, regs[ip->c]);
+    regs[ip->a] = mem[address];
+    VM_NEXT();
+  }
+  VM_CASE(LOADP) {
+    VM_ADDRESS(regs[ip->b], regs[ip->c]);
+    regs[ip->a] = mem[address];
+    VM_NEXT();
+  }
+  VM_CASE(STOREG) {
+    VM_ADDRESS(ip->a, regs[ip->b]);
+    mem[address] = regs[ip->c];
+    VM_NEXT();
+  }
+  VM_CASE(STOREL) {
+    VM_ADDRESS(fp + ip->a, regs[ip->b]);
+    mem[address] = regs[ip->c];
+    VM_NEXT();
+  }
+  VM_CASE(STOREP) {
+    VM_ADDRESS(regs[ip->a], regs[ip->b]);
+    mem[address] = regs[ip->c];
+    VM_NEXT();
+  }
+  VM_CASE(ADDR) {
+    regs[ip->a] = fp + ip->b;
+    VM_NEXT();
+  }
+  VM_CASE(CHECK) {
+    if ((uint32_t)regs[ip->a] >= (uint32_t)ip->b) {
+      // El mismo mensaje y la misma salida que el manejador en MIPS.
+      result.output += "Error: index out of bounds\n";
+      result.exited = true;
+      goto finish;
+    }
+    VM_NEXT();
+  }
+  VM_CASE(CALL) {
+    const VmFunction& callee = functions[ip->a];
+    uint32_t base = fp + ip->b;
+    if (base + callee.frameSize > size) goto stackOverflow;
+    if (depth == (size_t)VM_MAX_CALL_DEPTH) goto stackOverflow;
+    highWater = std::max(highWater, base + callee.frameSize);
+    frames[depth++] = {ip + 1, fp, ip->c};
+    fp = base;
+    regs = mem + fp;
+    VM_JUMP(callee.entry);
+  }
+  VM_CASE(RET) VM_RETURN(regs[ip->a])
+  VM_CASE(RETV) VM_RETURN(0)
+  VM_CASE(INPUT) {
+    if (nextInput == input.size()) {
+      result.error = "no hay más entrada para input()";
+      goto finish;
+    }
+    regs[ip->a] = input[nextInput++];
+    VM_NEXT();
+  }
+  VM_CASE(OUTPUT) {
+    char* end = std::to_chars(digits, digits + sizeof(digits), regs[ip->a]).ptr;
+    result.output.append(digits, end);
+    result.output += '\n';
+    VM_NEXT();
+  }
+  VM_CASE(HALT) {
+    result.exited = true;
+    goto finish;
+  }
+#if !VM_COMPUTED_GOTO
+    }
+  }
+#endif
+
+divisionByZero:
+  result.error = "división entre cero";
+  goto finish;
+outOfMemory:
+  result.error = "acceso fuera de la memoria";
+  goto finish;
+stackOverflow:
+  result.error = "stack overflow";
+  goto finish;
+stepsExceeded:
+  result.error = "se pasó del límite de instrucciones";
+
+finish:
+  result.instructions = steps;
+  dirty = highWater;
+  return result;
+
+#undef VM_CASE
+#undef VM_DISPATCH
+#undef VM_NEXT
+#undef VM_JUMP
+#undef VM_ARITHMETIC
+#undef VM_COMPARE
+#undef VM_ADDRESS
+#undef VM_RETURN
+}
+
+std::vector<int> readProgramInput(std::istream& in) {
+  std::vector<int> values;
+  int value;
+  while (in >> value) values.push_back(value);
+  return values;
+}
+
+// El tiempo del simulador incluye decodificar el código y reservar su
+// memoria, que es lo que cuesta cada corrida por ese camino.
+void benchmarkBackends(const BytecodeProgram& bytecode,
+                       double compileMilliseconds, const ObjectCode& object,
+                       const std::string& input, int runs, bool delaySlots) {
+  using Clock = std::chrono::steady_clock;
+  auto millisecondsSince = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+  };
+  std::istringstream parse(input);
+  std::vector<int> values = readProgramInput(parse);
+
+  VirtualMachine vm(bytecode);
+  VmResult vmRun;
+  auto start = Clock::now();
+  for (int i = 0; i < runs; ++i) vmRun = vm.run(values);
+  double vmMilliseconds = millisecondsSince(start) / runs;
+
+  SimulationResult simulated;
+  std::string simulatedOutput;
+  start = Clock::now();
+  for (int i = 0; i < runs; ++i) {
+    std::istringstream in(input);
+    std::ostringstream out;
+    SimulationOptions options;
+    options.delaySlots = delaySlots;
+    options.input = &in;
+    options.output = &out;
+    simulated = simulate(object, options);
+    simulatedOutput = out.str();
+  }
+  double simulatorMilliseconds = millisecondsSince(start) / runs;
+
+  auto format = [](double value, int digits) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(digits) << value;
+    return text.str();
+  };
+  std::cout << Style::bold("\nBackends (" + std::to_string(runs) +
+                           " corridas):\n");
+  std::cout << "  " << Style::cyan("vm") << ": "
+            << format(vmMilliseconds, 4) << " ms por corrida, "
+            << vmRun.instructions << " instrucciones; bytecode de "
+            << bytecode.code.size() << " instrucciones compilado en "
+            << format(compileMilliseconds, 3) << " ms\n";
+  std::cout << "  " << Style::cyan("simulador") << ": "
+            << format(simulatorMilliseconds, 4) << " ms por corrida, "
+            << simulated.instructions << " instrucciones MIPS\n";
+  std::cout << "  la VM es "
+            << format(simulatorMilliseconds / std::max(vmMilliseconds, 1e-9),
+                      1)
+            << "x más rápida, "
+            << (vmRun.output == simulatedOutput
+                    ? Style::green("misma salida")
+                    : Style::yellow("la salida es distinta"))
+            << "\n";
+  if (!vmRun.exited) {
+    std::cout << Style::bold_red("Error: ") << "vm: " << vmRun.error << "\n";
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file de la VM que ejecuta el bytecode.
+ * */
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bytecode.hpp"
+#include "encoder.hpp"
+
+// Tamaños de la memoria de la VM, en palabras. Después de los globales hay
+// un espacio libre (como el heap de SPIM), así que leer un poco después de
+// un arreglo global no es un error; luego vienen los frames.
+constexpr int VM_DATA_HEADROOM = 4096;
+constexpr int VM_STACK_WORDS = 1 << 21;
+constexpr int VM_MAX_CALL_DEPTH = 1 << 18;
+constexpr long long VM_STEP_LIMIT = 1000000000;
+
+struct VmResult {
+  // Terminó main (o el manejador de subíndices); si no, error dice por qué
+  // se detuvo.
+  bool exited = false;
+  std::string error;
+  long long instructions = 0;
+  // Cada output() en su propia línea, igual que en el simulador.
+  std::string output;
+};
+
+// La memoria y la pila de llamadas se reservan una vez al construirla y se
+// reutilizan en cada corrida, que solo limpia lo que la anterior usó. Así
+// correr el mismo programa miles de veces con distintas entradas no hace
+// ninguna reserva de memoria por corrida.
+class VirtualMachine {
+ public:
+  explicit VirtualMachine(const BytecodeProgram& program);
+
+  VmResult run(const std::vector<int>& input,
+               long long stepLimit = VM_STEP_LIMIT);
+
+ private:
+  struct CallRecord {
+    const VmInstruction* returnTo;
+    uint32_t fp;
+    int32_t dest;
+  };
+
+  const BytecodeProgram& program;
+  std::vector<int32_t> memory;
+  std::vector<CallRecord> calls;
+  // Hasta dónde pudo escribir la corrida anterior.
+  size_t dirty = 0;
+};
+
+// Lee todos los enteros de la entrada, para pasarlos a run().
+std::vector<int> readProgramInput(std::istream& in);
+
+// Lo que hace -fvm-bench: corre el mismo programa runs veces con la misma
+// entrada en la VM y en el simulador de MIPS, y compara el tiempo por
+// corrida y la salida. compileMilliseconds es lo que tardó compileBytecode.
+void benchmarkBackends(const BytecodeProgram& bytecode,
+                       double compileMilliseconds, const ObjectCode& object,
+                       const std::string& input, int runs, bool delaySlots);
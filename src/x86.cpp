@@ -0,0 +1,554 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el implementation file del backend de x86-64.
+ * */
+#include "x86.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "astutil.hpp"
+#include "parser.hpp"
+
+namespace {
+
+// Dónde vive cada nombre mientras se genera una función.
+struct X86Binding {
+  enum Kind { SCALAR, GLOBAL, LOCAL_ARRAY, PARAM_ARRAY, GLOBAL_ARRAY } kind;
+  // Los demás campos se llenan después, según dónde quedó la variable.
+  explicit X86Binding(Kind kind = SCALAR) : kind(kind) {}
+  // Desplazamiento desde %rbp, o el símbolo de un global.
+  int offset = 0;
+  std::string symbol;
+  // Tamaño del arreglo; 0 si no se conoce (parámetros).
+  int size = 0;
+};
+
+// Registros de los primeros seis argumentos en System V.
+const char* const ARGUMENT_REGISTERS[] = {"%rdi", "%rsi", "%rdx",
+                                          "%rcx", "%r8",  "%r9"};
+const char* const ARGUMENT_REGISTERS_32[] = {"%edi", "%esi", "%edx",
+                                             "%ecx", "%r8d", "%r9d"};
+
+/*
+ *  Cada expresión deja su valor en %eax. Cuando el operando derecho es una
+ *  constante o un escalar se usa directo como operando de la instrucción;
+ *  si no, el izquierdo se guarda con pushq mientras se calcula el derecho.
+ *  depth cuenta esos pushq para alinear %rsp a 16 bytes en cada llamada.
+ * */
+class X86Generator {
+ public:
+  explicit X86Generator(bool boundsCheck) : boundsCheck(boundsCheck) {}
+
+  std::string generate(ProgramNode* tree);
+
+ private:
+  bool boundsCheck;
+  std::string out;
+  // El cuerpo de la función actual; el prólogo se agrega al final, cuando
+  // ya se conoce el tamaño del frame.
+  std::string text;
+  std::map<std::string, X86Binding> globals;
+  std::vector<std::map<std::string, X86Binding>> scopes;
+  int frameBytes = 0;
+  int maxFrameBytes = 0;
+  int depth = 0;
+  int labels = 0;
+
+  void emit(const std::string& line) { text += "  " + line + "\n"; }
+  void place(const std::string& label) { text += label + ":\n"; }
+  std::string newLabel() { return ".L" + std::to_string(labels++); }
+
+  void push() {
+    emit("pushq %rax");
+    ++depth;
+  }
+  void pop(const std::string& reg) {
+    emit("popq " + reg);
+    --depth;
+  }
+
+  // Un espacio en el frame; regresa su desplazamiento desde %rbp.
+  int allocate(int bytes) {
+    int align = std::min(bytes, 8);
+    frameBytes = (frameBytes + bytes + align - 1) / align * align;
+    maxFrameBytes = std::max(maxFrameBytes, frameBytes);
+    return -frameBytes;
+  }
+
+  const X86Binding& lookup(const std::string& id) const {
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+      auto found = it->find(id);
+      if (found != it->end()) return found->second;
+    }
+    return globals.at(id);
+  }
+
+  static std::string location(const X86Binding& binding) {
+    if (!binding.symbol.empty()) return binding.symbol + "(%rip)";
+    return std::to_string(binding.offset) + "(%rbp)";
+  }
+
+  void function(FunDeclarationNode* fun);
+  void statement(StatementNode* stmt);
+  void jumpIf(ExpressionNode* condition, bool when, const std::string& to);
+  void value(ExpressionNode* expr);
+  std::optional<std::string> operand(ExpressionNode* expr);
+  std::string rightOperand(ExpressionNode* expr);
+  void divide(ExpressionNode* divisor);
+  void compare(SimpleExpressionNode* comparison);
+  void assign(AssignmentExpressionNode* node);
+  void readVar(VarNode* var);
+  std::string element(const X86Binding& binding);
+  void checkBounds(const X86Binding& binding);
+  void call(CallNode* node);
+  void alignedCall(const std::string& symbol);
+
+  template <typename Node>
+  void chain(Node* node);
+};
+
+}  // namespace
+
+static std::string conditionCode(TokenType relop) {
+  switch (relop) {
+    case TokenType::LT:
+      return "l";
+    case TokenType::LTE:
+      return "le";
+    case TokenType::GT:
+      return "g";
+    case TokenType::GTE:
+      return "ge";
+    case TokenType::EQ:
+      return "e";
+    default:
+      return "ne";
+  }
+}
+
+// scanf, printf y el mensaje de subíndices. __cm_input da 0 si ya no hay
+// entrada; el manejador de subíndices termina con el mismo mensaje que el
+// código MIPS.
+static const char* const X86_RUNTIME = R"(
+__cm_input:
+  subq $24, %rsp
+  movl $0, 12(%rsp)
+  leaq 12(%rsp), %rsi
+  leaq .Lcm_input_format(%rip), %rdi
+  xorl %eax, %eax
+  call scanf@PLT
+  movl 12(%rsp), %eax
+  addq $24, %rsp
+  ret
+
+__cm_output:
+  subq $8, %rsp
+  movl %edi, %esi
+  leaq .Lcm_output_format(%rip), %rdi
+  xorl %eax, %eax
+  call printf@PLT
+  addq $8, %rsp
+  ret
+
+__cm_bounds_error:
+  andq $-16, %rsp
+  leaq .Lcm_bounds_message(%rip), %rdi
+  call puts@PLT
+  xorl %edi, %edi
+  call exit@PLT
+
+main:
+  subq $8, %rsp
+  call cm_main
+  xorl %eax, %eax
+  addq $8, %rsp
+  ret
+
+  .section .rodata
+.Lcm_input_format:
+  .string "%d"
+.Lcm_output_format:
+  .string "%d\n"
+.Lcm_bounds_message:
+  .string "Error: index out of bounds"
+)";
+
+std::string X86Generator::generate(ProgramNode* tree) {
+  std::string data = "  .bss\n  .p2align 4\n";
+  for (auto& decl : tree->declarationList) {
+    auto var = dynamic_cast<VarDeclarationNode*>(decl.get());
+    if (!var) continue;
+    X86Binding binding{var->arraySize ? X86Binding::GLOBAL_ARRAY
+                                      : X86Binding::GLOBAL};
+    binding.symbol = "cm_" + var->id;
+    binding.size = var->arraySize.value_or(0);
+    globals[var->id] = binding;
+    data += binding.symbol + ":\n  .zero " +
+            std::to_string(4 * var->arraySize.value_or(1)) + "\n";
+  }
+  data += "  .zero " + std::to_string(X86_DATA_HEADROOM) + "\n";
+
+  out = "  .text\n  .globl main\n";
+  for (auto& decl : tree->declarationList) {
+    auto fun = dynamic_cast<FunDeclarationNode*>(decl.get());
+    if (fun && fun->compoundStatement) function(fun);
+  }
+  out += X86_RUNTIME;
+  out += "\n" + data;
+  out += "\n  .section .note.GNU-stack,\"\",@progbits\n";
+  return out;
+}
+
+void X86Generator::function(FunDeclarationNode* fun) {
+  text.clear();
+  scopes.assign(1, {});
+  frameBytes = maxFrameBytes = depth = 0;
+  std::string saveParams;
+  for (size_t i = 0; i < fun->params.size(); ++i) {
+    ParamNode* param = fun->params[i].get();
+    X86Binding binding{param->isArray ? X86Binding::PARAM_ARRAY
+                                      : X86Binding::SCALAR};
+    if (i < 6) {
+      // Los que llegan en registros se guardan en el frame.
+      binding.offset = allocate(param->isArray ? 8 : 4);
+      saveParams += std::string("  ") + (param->isArray ? "movq " : "movl ") +
+                    (param->isArray ? ARGUMENT_REGISTERS[i]
+                                    : ARGUMENT_REGISTERS_32[i]) +
+                    ", " + location(binding) + "\n";
+    } else {
+      binding.offset = 16 + 8 * (i - 6);
+    }
+    scopes[0][param->id] = binding;
+  }
+  statement(fun->compoundStatement.get());
+  // Una función que llega al final sin return regresa 0.
+  emit("xorl %eax, %eax");
+  emit("leave");
+  emit("ret");
+
+  int frame = (maxFrameBytes + 15) / 16 * 16;
+  out += "\ncm_" + fun->id + ":\n  pushq %rbp\n  movq %rsp, %rbp\n";
+  if (frame) out += "  subq $" + std::to_string(frame) + ", %rsp\n";
+  out += saveParams + text;
+}
+
+void X86Generator::statement(StatementNode* stmt) {
+  if (!stmt) return;
+  if (auto expr = dynamic_cast<ExpressionStatementNode*>(stmt)) {
+    if (expr->expression) value(expr->expression.get());
+  } else if (auto comp = dynamic_cast<CompoundStatementNode*>(stmt)) {
+    int saved = frameBytes;
+    scopes.emplace_back();
+    for (auto& var : comp->vars) {
+      X86Binding binding{var->arraySize ? X86Binding::LOCAL_ARRAY
+                                        : X86Binding::SCALAR};
+      binding.offset = allocate(4 * var->arraySize.value_or(1));
+      binding.size = var->arraySize.value_or(0);
+      scopes.back()[var->id] = binding;
+    }
+    for (auto& child : comp->statements) statement(child.get());
+    scopes.pop_back();
+    frameBytes = saved;
+  } else if (auto sel = dynamic_cast<SelectionStatementNode*>(stmt)) {
+    std::string skipThen = newLabel();
+    jumpIf(sel->condition.get(), false, skipThen);
+    statement(sel->statement.get());
+    if (sel->elseStatement) {
+      std::string skipElse = newLabel();
+      emit("jmp " + skipElse);
+      place(skipThen);
+      statement(sel->elseStatement.get());
+      place(skipElse);
+    } else {
+      place(skipThen);
+    }
+  } else if (auto iter = dynamic_cast<IterationStatementNode*>(stmt)) {
+    // La condición va al final: cada vuelta hace un solo salto.
+    std::string body = newLabel(), condition = newLabel();
+    emit("jmp " + condition);
+    place(body);
+    statement(iter->statement.get());
+    place(condition);
+    jumpIf(iter->expression.get(), true, body);
+  } else if (auto ret = dynamic_cast<ReturnStatementNode*>(stmt)) {
+    if (ret->expression) value(ret->expression.get());
+    emit("leave");
+    emit("ret");
+  }
+}
+
+// Salta a `to` cuando la condición vale when. Las comparaciones se vuelven
+// un cmpl y un salto condicional.
+void X86Generator::jumpIf(ExpressionNode* condition, bool when,
+                          const std::string& to) {
+  SimpleExpressionNode* comparison = asComparison(condition);
+  if (comparison && comparison->additiveRight) {
+    value(comparison->additiveLeft.get());
+    emit("cmpl " + rightOperand(comparison->additiveRight.get()) + ", %eax");
+    TokenType relop =
+        when ? comparison->relop : negateRelop(comparison->relop);
+    emit("j" + conditionCode(relop) + " " + to);
+  } else {
+    value(condition);
+    emit("testl %eax, %eax");
+    emit(std::string(when ? "jne " : "je ") + to);
+  }
+}
+
+// Una constante o un escalar que una instrucción puede leer directo.
+std::optional<std::string> X86Generator::operand(ExpressionNode* expr) {
+  FactorNode* factor = asFactor(expr);
+  if (isLiteral(factor)) return "$" + std::to_string(factor->value);
+  if (VarNode* var = bareVar(factor)) {
+    const X86Binding& binding = lookup(var->id);
+    if (binding.kind == X86Binding::SCALAR ||
+        binding.kind == X86Binding::GLOBAL) {
+      return location(binding);
+    }
+  }
+  return std::nullopt;
+}
+
+// El operando derecho de una operación cuyo operando izquierdo ya está en
+// %eax; si hay que calcularlo, queda en %ecx.
+std::string X86Generator::rightOperand(ExpressionNode* expr) {
+  if (auto direct = operand(expr)) return *direct;
+  push();
+  value(expr);
+  emit("movl %eax, %ecx");
+  pop("%rax");
+  return "%ecx";
+}
+
+void X86Generator::value(ExpressionNode* expr) {
+  if (auto factor = dynamic_cast<FactorNode*>(expr)) {
+    if (factor->expression) {
+      value(factor->expression.get());
+    } else if (factor->call) {
+      call(factor->call.get());
+    } else if (factor->var) {
+      readVar(factor->var.get());
+    } else if (factor->value == 0) {
+      emit("xorl %eax, %eax");
+    } else {
+      emit("movl $" + std::to_string(factor->value) + ", %eax");
+    }
+  } else if (auto term = dynamic_cast<TermNode*>(expr)) {
+    chain(term);
+  } else if (auto add = dynamic_cast<AdditiveExpressionNode*>(expr)) {
+    chain(add);
+  } else if (auto simple = dynamic_cast<SimpleExpressionNode*>(expr)) {
+    if (simple->additiveRight) {
+      compare(simple);
+    } else {
+      value(simple->additiveLeft.get());
+    }
+  } else if (auto assignment = dynamic_cast<AssignmentExpressionNode*>(expr)) {
+    assign(assignment);
+  } else if (auto callNode = dynamic_cast<CallNode*>(expr)) {
+    call(callNode);
+  }
+}
+
+void X86Generator::compare(SimpleExpressionNode* comparison) {
+  value(comparison->additiveLeft.get());
+  emit("cmpl " + rightOperand(comparison->additiveRight.get()) + ", %eax");
+  emit("set" + conditionCode(comparison->relop) + " %al");
+  emit("movzbl %al, %eax");
+}
+
+// a op b op c ... de izquierda a derecha, para términos y sumas. Las
+// operaciones de 32 bits dan la vuelta igual que en MIPS.
+template <typename Node>
+void X86Generator::chain(Node* node) {
+  constexpr bool isTerm = std::is_same_v<Node, TermNode>;
+  auto leftOf = [](auto* link) -> ExpressionNode* {
+    if constexpr (isTerm) {
+      return link->leftFactor.get();
+    } else {
+      return link->leftTerm.get();
+    }
+  };
+  auto nextOf = [](auto* link) {
+    if constexpr (isTerm) {
+      return link->rightFactor.get();
+    } else {
+      return link->rightTerm.get();
+    }
+  };
+  value(leftOf(node));
+  for (Node* link = node; nextOf(link); link = nextOf(link)) {
+    ExpressionNode* right = leftOf(nextOf(link));
+    if constexpr (isTerm) {
+      if (link->mulop == TokenType::DIV) {
+        divide(right);
+        continue;
+      }
+      std::string source = rightOperand(right);
+      // imull no acepta una constante como operando de dos registros.
+      emit("imull " + source + (source[0] == '$' ? ", %eax, %eax" : ", %eax"));
+    } else {
+      emit((link->addop == TokenType::SUB ? "subl " : "addl ") +
+           rightOperand(right) + ", %eax");
+    }
+  }
+}
+
+// %eax / divisor. idivl truncha hacia cero como div; INT_MIN / -1 haría
+// trap en x86, así que -1 se vuelve una negación, que da INT_MIN como en
+// MIPS. Dividir entre cero termina el programa con SIGFPE.
+void X86Generator::divide(ExpressionNode* divisor) {
+  FactorNode* factor = asFactor(divisor);
+  if (isLiteral(factor)) {
+    if (factor->value == -1) {
+      emit("negl %eax");
+      return;
+    }
+    emit("movl $" + std::to_string(factor->value) + ", %ecx");
+    emit("cltd");
+    emit("idivl %ecx");
+    return;
+  }
+  std::string source = rightOperand(divisor);
+  if (source != "%ecx") emit("movl " + source + ", %ecx");
+  std::string divideLabel = newLabel(), done = newLabel();
+  emit("cmpl $-1, %ecx");
+  emit("jne " + divideLabel);
+  emit("negl %eax");
+  emit("jmp " + done);
+  place(divideLabel);
+  emit("cltd");
+  emit("idivl %ecx");
+  place(done);
+}
+
+// Como en el código MIPS, primero el valor y luego el subíndice. El valor
+// asignado queda en %eax.
+void X86Generator::assign(AssignmentExpressionNode* node) {
+  VarNode* var = node->var.get();
+  const X86Binding& binding = lookup(var->id);
+  value(node->simpleExpression.get());
+  if (!var->expression) {
+    emit("movl %eax, " + location(binding));
+    return;
+  }
+  push();
+  value(var->expression.get());
+  checkBounds(binding);
+  emit("cltq");
+  pop("%rdx");
+  emit("movl %edx, " + element(binding));
+  emit("movl %edx, %eax");
+}
+
+void X86Generator::readVar(VarNode* var) {
+  const X86Binding& binding = lookup(var->id);
+  if (var->expression) {
+    value(var->expression.get());
+    checkBounds(binding);
+    emit("cltq");
+    emit("movl " + element(binding) + ", %eax");
+    return;
+  }
+  // Sin subíndice: el valor de un escalar o la dirección de un arreglo,
+  // que es lo que se pasa como argumento.
+  switch (binding.kind) {
+    case X86Binding::SCALAR:
+    case X86Binding::GLOBAL:
+      emit("movl " + location(binding) + ", %eax");
+      break;
+    case X86Binding::PARAM_ARRAY:
+      emit("movq " + location(binding) + ", %rax");
+      break;
+    case X86Binding::LOCAL_ARRAY:
+    case X86Binding::GLOBAL_ARRAY:
+      emit("leaq " + location(binding) + ", %rax");
+      break;
+  }
+}
+
+// El operando de memoria del elemento cuyo subíndice ya está en %rax. Usa
+// %rcx para la base de los arreglos que no están en el frame.
+std::string X86Generator::element(const X86Binding& binding) {
+  switch (binding.kind) {
+    case X86Binding::LOCAL_ARRAY:
+      return std::to_string(binding.offset) + "(%rbp,%rax,4)";
+    case X86Binding::GLOBAL_ARRAY:
+      emit("leaq " + location(binding) + ", %rcx");
+      return "(%rcx,%rax,4)";
+    case X86Binding::PARAM_ARRAY:
+      emit("movq " + location(binding) + ", %rcx");
+      return "(%rcx,%rax,4)";
+    default:
+      return location(binding);
+  }
+}
+
+void X86Generator::checkBounds(const X86Binding& binding) {
+  if (!boundsCheck || binding.size <= 0) return;
+  // Sin signo, un subíndice negativo también queda fuera.
+  emit("cmpl $" + std::to_string(binding.size) + ", %eax");
+  emit("jae __cm_bounds_error");
+}
+
+void X86Generator::alignedCall(const std::string& symbol) {
+  if (depth % 2) emit("subq $8, %rsp");
+  emit("call " + symbol);
+  if (depth % 2) emit("addq $8, %rsp");
+}
+
+// Los argumentos se calculan de izquierda a derecha y se guardan en la
+// pila; luego los primeros seis pasan a sus registros y los demás se
+// copian en el orden que pide System V.
+void X86Generator::call(CallNode* node) {
+  if (node->id == "input") {
+    alignedCall("__cm_input");
+    return;
+  }
+  if (node->id == "output") {
+    value(node->argsList[0].get());
+    emit("movl %eax, %edi");
+    alignedCall("__cm_output");
+    return;
+  }
+  int count = node->argsList.size();
+  for (auto& arg : node->argsList) {
+    value(arg.get());
+    push();
+  }
+  int onStack = std::max(0, count - 6);
+  int padding = (depth + onStack) % 2 ? 8 : 0;
+  if (padding) emit("subq $8, %rsp");
+  for (int i = count - 1, copied = 0; i >= 6; --i, ++copied) {
+    emit("pushq " + std::to_string(8 * (count - 1 - i) + padding + 8 * copied) +
+         "(%rsp)");
+  }
+  for (int i = 0; i < std::min(count, 6); ++i) {
+    emit("movq " +
+         std::to_string(8 * (count - 1 - i) + padding + 8 * onStack) +
+         "(%rsp), " + ARGUMENT_REGISTERS[i]);
+  }
+  emit("call cm_" + node->id);
+  int pushed = 8 * (count + onStack) + padding;
+  if (pushed) emit("addq $" + std::to_string(pushed) + ", %rsp");
+  depth -= count;
+}
+
+std::string generateX86(ProgramNode* program, bool boundsCheck) {
+  X86Generator generator(boundsCheck);
+  return generator.generate(program);
+}
+
+bool linkNative(const std::string& assemblyPath,
+                const std::string& executable) {
+  const char* compiler = std::getenv("CC");
+  std::string command = std::string(compiler && *compiler ? compiler : "cc") +
+                        " -o " + executable + " " + assemblyPath;
+  return std::system(command.c_str()) == 0;
+}
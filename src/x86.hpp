@@ -0,0 +1,26 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Este es el header file del backend de x86-64.
+ * */
+#pragma once
+
+#include <string>
+
+#include "parser.hpp"
+
+// Bytes libres después de los globales, como el heap de SPIM y la VM: leer
+// un poco después de un arreglo global da 0 en los tres backends.
+constexpr int X86_DATA_HEADROOM = 16384;
+
+// Genera el programa completo en ensamblador de GNU (sintaxis AT&T) para
+// x86-64 con la convención System V. Compila el árbol ya revisado por
+// Semantic, igual que la VM. Las funciones de C- se llaman cm_<nombre> para
+// no chocar con la biblioteca de C; el main de C llama a cm_main y el
+// runtime (__cm_input, __cm_output y el manejador de subíndices) va en el
+// mismo archivo y usa scanf y printf.
+std::string generateX86(ProgramNode* program, bool boundsCheck);
+
+// Ensambla y liga el archivo con el compilador de C del sistema ($CC o cc).
+// Regresa false si el comando falla.
+bool linkNative(const std::string& assemblyPath,
+                const std::string& executable);
@@ -0,0 +1,217 @@
+/*
+ *  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+ *  Prueba del codificador: codifica un programa que usa todas las
+ *  instrucciones y expansiones que emite CodeGenerator, y lo desensambla
+ *  palabra por palabra. tests/run_tests.sh compara la salida con
+ *  tests/golden/encoder.txt. El desensamblador es independiente del
+ *  codificador: solo lee los campos de cada palabra.
+ * */
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/encoder.cpp"
+#include "../src/encoder.hpp"
+#include "../src/mips.cpp"
+#include "../src/mips.hpp"
+
+static std::string hex(uint32_t value) {
+  std::ostringstream out;
+  out << "0x" << std::hex << value;
+  return out.str();
+}
+
+static std::string reg(uint32_t number) { return Mips::regName(number); }
+
+static std::string disassemble(uint32_t word, uint32_t pc) {
+  uint32_t opcode = word >> 26, rs = (word >> 21) & 31, rt = (word >> 16) & 31;
+  uint32_t rd = (word >> 11) & 31, shamt = (word >> 6) & 31, funct = word & 63;
+  int imm = (int16_t)(word & 0xffff);
+  uint32_t branch = pc + 4 + 4 * imm;
+  uint32_t jump = ((pc + 4) & 0xf0000000) | ((word & 0x03ffffff) << 2);
+  std::string three = " " + reg(rd) + ", " + reg(rs) + ", " + reg(rt);
+  std::string shift =
+      " " + reg(rd) + ", " + reg(rt) + ", " + std::to_string(shamt);
+  std::string immediate =
+      " " + reg(rt) + ", " + reg(rs) + ", " + std::to_string(imm);
+  std::string logical =
+      " " + reg(rt) + ", " + reg(rs) + ", " + hex(word & 0xffff);
+  std::string memory =
+      " " + reg(rt) + ", " + std::to_string(imm) + "(" + reg(rs) + ")";
+  switch (opcode) {
+    case 0x00:
+      if (word == 0) return "nop";
+      switch (funct) {
+        case 0x00:
+          return "sll" + shift;
+        case 0x02:
+          return "srl" + shift;
+        case 0x03:
+          return "sra" + shift;
+        case 0x08:
+          return "jr " + reg(rs);
+        case 0x0c:
+          return "syscall";
+        case 0x10:
+          return "mfhi " + reg(rd);
+        case 0x12:
+          return "mflo " + reg(rd);
+        case 0x18:
+          return "mult " + reg(rs) + ", " + reg(rt);
+        case 0x1a:
+          return "div " + reg(rs) + ", " + reg(rt);
+        case 0x20:
+          return "add" + three;
+        case 0x21:
+          return "addu" + three;
+        case 0x22:
+          return "sub" + three;
+        case 0x23:
+          return "subu" + three;
+        case 0x26:
+          return "xor" + three;
+        case 0x2a:
+          return "slt" + three;
+        case 0x2b:
+          return "sltu" + three;
+      }
+      break;
+    case 0x01:
+      if (rt > 1) break;
+      return (rt ? "bgez " : "bltz ") + reg(rs) + ", " + hex(branch);
+    case 0x02:
+      return "j " + hex(jump);
+    case 0x03:
+      return "jal " + hex(jump);
+    case 0x04:
+      return "beq " + reg(rs) + ", " + reg(rt) + ", " + hex(branch);
+    case 0x05:
+      return "bne " + reg(rs) + ", " + reg(rt) + ", " + hex(branch);
+    case 0x06:
+      return "blez " + reg(rs) + ", " + hex(branch);
+    case 0x07:
+      return "bgtz " + reg(rs) + ", " + hex(branch);
+    case 0x09:
+      return "addiu" + immediate;
+    case 0x0b:
+      return "sltiu" + immediate;
+    case 0x0d:
+      return "ori" + logical;
+    case 0x0e:
+      return "xori" + logical;
+    case 0x0f:
+      return "lui " + reg(rt) + ", " + hex(word & 0xffff);
+    case 0x1c:
+      if (funct == 0x02) return "mul" + three;
+      break;
+    case 0x23:
+      return "lw" + memory;
+    case 0x2b:
+      return "sw" + memory;
+  }
+  return "?";
+}
+
+static void print(const ObjectCode& object) {
+  std::map<uint32_t, std::vector<std::string>> labels;
+  for (const auto& [name, address] : object.symbols) {
+    labels[address].push_back(name);
+  }
+  for (size_t i = 0; i < object.text.size(); ++i) {
+    uint32_t pc = TEXT_BASE + 4 * i;
+    for (const auto& name : labels[pc]) std::cout << name << ":\n";
+    std::cout << std::hex << std::setfill('0') << std::setw(8) << pc << "  "
+              << std::setw(8) << object.text[i] << std::dec << "  "
+              << disassemble(object.text[i], pc) << "\n";
+  }
+  for (const auto& error : object.errors) {
+    std::cout << "error: " << error << "\n";
+  }
+}
+
+int main() {
+  std::vector<DataObject> data(3);
+  data[0].label = "small";
+  data[0].size = 8;
+  data[0].small = true;
+  data[1].label = "big";
+  data[1].size = 40000;
+  data[2].label = "text";
+  data[2].contents = std::string("hola\0", 5);
+
+  std::vector<Instruction> text = {
+      Mips::label("main"),
+      Mips::rtype(Op::ADD, Reg::T0, Reg::T1, Reg::T2),
+      Mips::rtype(Op::ADDU, Reg::T0, Reg::T1, Reg::T2),
+      Mips::rtype(Op::SUB, Reg::T3, Reg::T4, Reg::T5),
+      Mips::rtype(Op::SUBU, Reg::T3, Reg::T4, Reg::T5),
+      Mips::rtype(Op::XOR, Reg::S0, Reg::S7, Reg::T8),
+      Mips::rtype(Op::SLT, Reg::V0, Reg::A0, Reg::A1),
+      Mips::rtype(Op::SLTU, Reg::V0, Reg::ZERO, Reg::A1),
+      Mips::rtype(Op::MUL, Reg::T9, Reg::A2, Reg::A3),
+      Mips::hilo(Op::MULT, Reg::T0, Reg::T1),
+      Mips::hilo(Op::DIV, Reg::T0, Reg::T1),
+      Mips::moveFrom(Op::MFHI, Reg::T2),
+      Mips::moveFrom(Op::MFLO, Reg::T3),
+      Mips::shift(Op::SLL, Reg::T0, Reg::T1, 2),
+      Mips::shift(Op::SRL, Reg::T0, Reg::T1, 31),
+      Mips::shift(Op::SRA, Reg::T0, Reg::T1, 1),
+      // Inmediatos que caben y que no: los segundos pasan por $at.
+      Mips::addiu(Reg::SP, Reg::SP, -32),
+      Mips::addiu(Reg::T0, Reg::FP, -40012),
+      Mips::immediate(Op::XORI, Reg::T0, Reg::T1, 1),
+      Mips::immediate(Op::XORI, Reg::T0, Reg::T1, 65536),
+      Mips::immediate(Op::SLTIU, Reg::T0, Reg::T1, 10),
+      Mips::immediate(Op::SLTIU, Reg::T0, Reg::T1, 100000),
+      Mips::li(Reg::T0, -5),
+      Mips::li(Reg::T0, 40000),
+      Mips::li(Reg::T0, 0x12340000),
+      Mips::li(Reg::T0, -100000),
+      Mips::la(Reg::A0, "text"),
+      Mips::move(Reg::FP, Reg::SP),
+      // Desplazamientos: la parte alta se redondea para que la baja, con
+      // signo, complete el valor.
+      Mips::lw(Reg::T0, -4, Reg::FP),
+      Mips::sw(Reg::RA, 28, Reg::SP),
+      Mips::lw(Reg::T0, -40000, Reg::FP),
+      Mips::sw(Reg::T0, 40000, Reg::SP),
+      Mips::sw(Reg::T0, 98304, Reg::T1),
+      Mips::gpRelative(Op::LW, Reg::T0, "small"),
+      Mips::gpRelative(Op::SW, Reg::T0, "small", 4),
+      Mips::gpRelative(Op::ADDIU, Reg::T0, "small"),
+      Mips::label("loop"),
+      Mips::branch(Op::BEQ, Reg::T0, Reg::T1, "done"),
+      Mips::branch(Op::BNE, Reg::T0, Reg::ZERO, "loop"),
+      Mips::branchZero(Op::BLEZ, Reg::T0, "loop"),
+      Mips::branchZero(Op::BGTZ, Reg::T0, "done"),
+      Mips::branchZero(Op::BLTZ, Reg::T0, "done"),
+      Mips::branchZero(Op::BGEZ, Reg::T0, "loop"),
+      Mips::jump(Op::JAL, "loop"),
+      Mips::tailCall("main"),
+      Mips::jump(Op::J, "done"),
+      Mips::label("done"),
+      Mips::li(Reg::V0, 10),
+      Mips::syscall(),
+      Mips::jr(Reg::RA),
+      Mips::nop(),
+  };
+  print(encodeProgram(text, data));
+
+  // Con $at como operando la expansión lo pisaría antes de leerlo.
+  std::cout << "\n";
+  std::vector<Instruction> conflicts = {
+      Mips::sw(Reg::AT, 40000, Reg::FP),
+      Mips::lw(Reg::T0, 40000, Reg::AT),
+      Mips::immediate(Op::SLTIU, Reg::T0, Reg::AT, 100000),
+      // Estas no pasan por $at, así que se pueden usar.
+      Mips::lw(Reg::AT, 40000, Reg::FP),
+      Mips::addiu(Reg::AT, Reg::FP, -40000),
+      Mips::sw(Reg::AT, -8, Reg::FP),
+  };
+  print(encodeProgram(conflicts, {}));
+  return 0;
+}
@@ -0,0 +1,51 @@
+#!/bin/sh
+#
+#  Copyright (c) 2025 Andres Tarazona Solloa <andres.tara.so@gmail.com>
+#  Compila el compilador y corre las pruebas: cada programa de
+#  tests/programs se compila con varios niveles de optimización y se corre
+#  en el simulador integrado con su .in; la salida tiene que ser igual a su
+#  .out. Si hay un .flags, sus banderas se agregan a todas las corridas de
+#  ese programa. Además el desensamblado de tests/encoder_test.cpp tiene que
+#  ser igual a tests/golden/encoder.txt.
+#
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+${CXX:-g++} -std=c++17 -O1 -o "$work/cm" "$root/src/main.cpp" || exit 1
+
+failed=0
+${CXX:-g++} -std=c++17 -o "$work/encoder_test" "$root/tests/encoder_test.cpp" ||
+  exit 1
+if "$work/encoder_test" | diff -u "$root/tests/golden/encoder.txt" -; then
+  echo "ok   encoder"
+else
+  echo "FAIL encoder"
+  failed=1
+fi
+
+for program in "$root"/tests/programs/*.c-; do
+  name=$(basename "$program" .c-)
+  cp "$program" "$work/sample.c-"
+  extra=""
+  [ -f "$root/tests/programs/$name.flags" ] &&
+    extra=$(cat "$root/tests/programs/$name.flags")
+  for flags in "-O0" "-O1" "-O2" "-O1 -fno-omit-frame-pointer" \
+      "-O2 -fno-omit-frame-pointer" "-O2 -fdelayed-branch" \
+      "-O2 -fbounds-check"; do
+    # Solo la salida del programa: lo que sigue a "Simulation:" sin los
+    # conteos, que van con sangría.
+    actual=$(cd "$work" && ./cm -felf -fsimulate -fno-print-asm $flags $extra \
+        < "$root/tests/programs/$name.in" 2>&1 |
+        sed -n '/Simulation:/,$p' | sed 's/\x1b\[[0-9;]*m//g' | sed '1d' |
+        grep -v '^  ')
+    if [ "$actual" = "$(cat "$root/tests/programs/$name.out")" ]; then
+      echo "ok   $name $flags"
+    else
+      echo "FAIL $name $flags"
+      echo "$actual" | sed 's/^/     /'
+      failed=1
+    fi
+  done
+done
+exit $failed